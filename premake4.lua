@@ -18,15 +18,15 @@ newoption {
 }
 
 solution 'tarsier'
-    configurations {'release', 'debug'}
+    configurations {'release', 'debug', 'avx'}
     location 'build'
     project 'tarsier'
         kind 'ConsoleApp'
         language 'C++'
         location 'build'
         files {'source/*.hpp', 'test/*.cpp'}
-        buildoptions {'-std=c++11'}
-        linkoptions {'-std=c++11'}
+        buildoptions {'-std=c++11', '-pthread'}
+        linkoptions {'-std=c++11', '-pthread'}
         configuration 'release'
             targetdir 'build/release'
             defines {'NDEBUG'}
@@ -35,3 +35,8 @@ solution 'tarsier'
             targetdir 'build/debug'
             defines {'DEBUG'}
             flags {'Symbols'}
+        configuration 'avx'
+            targetdir 'build/avx'
+            defines {'NDEBUG'}
+            flags {'OptimizeSpeed'}
+            buildoptions {'-mavx2', '-mfma'}
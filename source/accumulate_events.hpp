@@ -0,0 +1,81 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+/// tarsier is a collection of event handlers.
+namespace tarsier {
+    /// accumulate_events sums events into a frame, for instance the output of warp_events.
+    /// The event type must have x and y members, which can be fractional: each event is split between the four
+    /// nearest pixels with bilinear weights. Events outside the frame are ignored, and the frame is read with frame()
+    /// and reset with clear().
+    template <typename Event>
+    class accumulate_events {
+        public:
+        accumulate_events(uint16_t width, uint16_t height) :
+            _width(width),
+            _height(height),
+            _frame(static_cast<std::size_t>(width) * height, 0.0f) {}
+        accumulate_events(const accumulate_events&) = delete;
+        accumulate_events(accumulate_events&&) = default;
+        accumulate_events& operator=(const accumulate_events&) = delete;
+        accumulate_events& operator=(accumulate_events&&) = default;
+        virtual ~accumulate_events() {}
+
+        /// operator() handles an event.
+        virtual void operator()(Event event) {
+            const auto x = static_cast<float>(event.x);
+            const auto y = static_cast<float>(event.y);
+            if (!(x > -1.0f && y > -1.0f && x < _width && y < _height)) {
+                return;
+            }
+            const auto left = std::floor(x);
+            const auto top = std::floor(y);
+            const auto right_weight = x - left;
+            const auto bottom_weight = y - top;
+            const auto column = static_cast<int32_t>(left);
+            const auto row = static_cast<int32_t>(top);
+            add(column, row, (1.0f - right_weight) * (1.0f - bottom_weight));
+            add(column + 1, row, right_weight * (1.0f - bottom_weight));
+            add(column, row + 1, (1.0f - right_weight) * bottom_weight);
+            add(column + 1, row + 1, right_weight * bottom_weight);
+        }
+
+        /// operator() handles a batch of events.
+        virtual void operator()(const Event* events, std::size_t count) {
+            for (std::size_t index = 0; index < count; ++index) {
+                operator()(events[index]);
+            }
+        }
+
+        /// frame returns the accumulated frame, row by row.
+        const std::vector<float>& frame() const {
+            return _frame;
+        }
+
+        /// clear resets the frame.
+        void clear() {
+            std::fill(_frame.begin(), _frame.end(), 0.0f);
+        }
+
+        protected:
+        /// add increments a pixel if it is inside the frame.
+        void add(int32_t x, int32_t y, float weight) {
+            if (x >= 0 && y >= 0 && x < _width && y < _height) {
+                _frame[x + y * static_cast<std::size_t>(_width)] += weight;
+            }
+        }
+
+        const uint16_t _width;
+        const uint16_t _height;
+        std::vector<float> _frame;
+    };
+
+    /// make_accumulate_events creates an accumulate_events.
+    template <typename Event>
+    accumulate_events<Event> make_accumulate_events(uint16_t width, uint16_t height) {
+        return accumulate_events<Event>(width, height);
+    }
+}
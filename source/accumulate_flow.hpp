@@ -0,0 +1,148 @@
+#pragma once
+
+#include "snapshot.hpp"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+/// tarsier is a collection of event handlers.
+namespace tarsier {
+    /// accumulate_flow averages optical flow events on a grid of cells, using an exponential decay.
+    /// The flow type must have t, x, y, vx and vy members. The memory footprint depends only on the grid size.
+    /// When reject_outliers is true, each cell uses the median of its last three samples instead of the raw sample.
+    /// Other threads must not call snapshot while events are handled; they read the field published with publish_to.
+    template <typename Flow>
+    class accumulate_flow {
+        public:
+        /// cell represents the averaged flow in a cell, and the decayed number of contributing events.
+        struct cell {
+            float vx;
+            float vy;
+            float confidence;
+        };
+
+        accumulate_flow(uint16_t width, uint16_t height, uint16_t cell_size, uint64_t decay, bool reject_outliers) :
+            _cell_size(cell_size),
+            _columns(static_cast<uint16_t>((width + cell_size - 1) / std::max(cell_size, static_cast<uint16_t>(1)))),
+            _rows(static_cast<uint16_t>((height + cell_size - 1) / std::max(cell_size, static_cast<uint16_t>(1)))),
+            _decay(static_cast<float>(decay)),
+            _states(static_cast<std::size_t>(_columns) * _rows, state{0.0f, 0.0f, 0.0f, 0}),
+            _samples(reject_outliers ? static_cast<std::size_t>(_columns) * _rows : 0, {{0.0f, 0.0f, 0.0f, 0.0f}}),
+            _snapshot(nullptr),
+            _period(0),
+            _next_publication_t(0) {
+            if (cell_size == 0) {
+                throw std::logic_error("cell_size must be strictly positive");
+            }
+            if (decay == 0) {
+                throw std::logic_error("decay must be larger than zero");
+            }
+        }
+        accumulate_flow(const accumulate_flow&) = delete;
+        accumulate_flow(accumulate_flow&&) = default;
+        accumulate_flow& operator=(const accumulate_flow&) = delete;
+        accumulate_flow& operator=(accumulate_flow&&) = default;
+        virtual ~accumulate_flow() {}
+
+        /// operator() handles a flow event.
+        virtual void operator()(Flow flow) {
+            const auto index = flow.x / _cell_size + (flow.y / _cell_size) * _columns;
+            auto vx = static_cast<float>(flow.vx);
+            auto vy = static_cast<float>(flow.vy);
+            auto& state = _states[index];
+            if (!_samples.empty()) {
+                auto& samples = _samples[index];
+                if (state.weight == 0) {
+                    samples = {{vx, vx, vy, vy}};
+                }
+                const auto median_vx = median(samples[0], samples[1], vx);
+                const auto median_vy = median(samples[2], samples[3], vy);
+                samples[0] = samples[1];
+                samples[1] = vx;
+                samples[2] = samples[3];
+                samples[3] = vy;
+                vx = median_vx;
+                vy = median_vy;
+            }
+            const auto weight = state.weight * std::exp(-static_cast<float>(flow.t - state.t) / _decay);
+            const auto inverse_weight = 1.0f / (weight + 1.0f);
+            state.vx = (state.vx * weight + vx) * inverse_weight;
+            state.vy = (state.vy * weight + vy) * inverse_weight;
+            state.weight = weight + 1.0f;
+            state.t = flow.t;
+            if (_snapshot != nullptr && flow.t >= _next_publication_t) {
+                auto& cells = _snapshot->back();
+                cells.resize(_states.size());
+                snapshot(flow.t, cells.data());
+                _snapshot->publish();
+                _next_publication_t = flow.t + _period;
+            }
+        }
+
+        /// snapshot writes the decayed field at the given time into cells, row by row.
+        /// cells must contain at least columns() * rows() elements. The accumulator is left untouched.
+        void snapshot(uint64_t t, cell* cells) const {
+            for (std::size_t index = 0; index < _states.size(); ++index) {
+                const auto& state = _states[index];
+                cells[index].vx = state.vx;
+                cells[index].vy = state.vy;
+                cells[index].confidence =
+                    (t <= state.t ? state.weight
+                                  : state.weight * std::exp(-static_cast<float>(t - state.t) / _decay));
+            }
+        }
+
+        /// publish_to makes a copy of the decayed field (row-major) available to another thread at most once every
+        /// period (event time). The field is decayed to the time of the event that triggers the publication.
+        void publish_to(tarsier::snapshot<std::vector<cell>>& cells_snapshot, uint64_t period) {
+            _snapshot = &cells_snapshot;
+            _period = period;
+            _next_publication_t = 0;
+        }
+
+        /// columns returns the number of cells along the x axis.
+        uint16_t columns() const {
+            return _columns;
+        }
+
+        /// rows returns the number of cells along the y axis.
+        uint16_t rows() const {
+            return _rows;
+        }
+
+        protected:
+        /// state holds the running average of a cell.
+        struct state {
+            float vx;
+            float vy;
+            float weight;
+            uint64_t t;
+        };
+
+        /// median returns the median of three values.
+        static float median(float a, float b, float c) {
+            return std::max(std::min(a, b), std::min(std::max(a, b), c));
+        }
+
+        const uint16_t _cell_size;
+        const uint16_t _columns;
+        const uint16_t _rows;
+        const float _decay;
+        std::vector<state> _states;
+        std::vector<std::array<float, 4>> _samples;
+        tarsier::snapshot<std::vector<cell>>* _snapshot;
+        uint64_t _period;
+        uint64_t _next_publication_t;
+    };
+
+    /// make_accumulate_flow creates an accumulate_flow.
+    template <typename Flow>
+    accumulate_flow<Flow>
+    make_accumulate_flow(uint16_t width, uint16_t height, uint16_t cell_size, uint64_t decay, bool reject_outliers) {
+        return accumulate_flow<Flow>(width, height, cell_size, decay, reject_outliers);
+    }
+}
@@ -0,0 +1,212 @@
+#pragma once
+
+#include "state.hpp"
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/// tarsier is a collection of event handlers.
+namespace tarsier {
+    /// active_events_pixel describes the data stored for each pixel of a surface of active events.
+    template <typename Polarity>
+    struct active_events_pixel {
+        typedef std::pair<uint64_t, Polarity> type;
+
+        /// update stores an event's timestamp and polarity.
+        template <typename Event>
+        static void update(type& pixel, Event event) {
+            pixel.first = event.t;
+            pixel.second = event.polarity;
+        }
+
+        /// t returns the pixel's timestamp.
+        static uint64_t t(const type& pixel) {
+            return pixel.first;
+        }
+
+        /// polarity returns the pixel's polarity.
+        static Polarity polarity(const type& pixel) {
+            return pixel.second;
+        }
+    };
+
+    /// active_events_pixel describes the data stored for each pixel of a surface of active events without polarity.
+    template <>
+    struct active_events_pixel<void> {
+        typedef uint64_t type;
+
+        /// update stores an event's timestamp.
+        template <typename Event>
+        static void update(type& pixel, Event event) {
+            pixel = event.t;
+        }
+
+        /// t returns the pixel's timestamp.
+        static uint64_t t(const type& pixel) {
+            return pixel;
+        }
+    };
+
+    /// active_events_traits describes the geometry of a surface of active events.
+    /// Guarded surfaces accept coordinates up to guard pixels outside the sensor, hence handlers can read
+    /// neighbourhoods without clamping them.
+    template <typename ActiveEvents>
+    struct active_events_traits {
+        static constexpr bool guarded = false;
+        static constexpr uint16_t guard = 0;
+    };
+
+    /// check_window throws if a neighbourhood does not fit in the guard band of a surface of active events.
+    template <typename ActiveEvents>
+    void check_window(uint16_t window) {
+        typedef active_events_traits<typename std::decay<ActiveEvents>::type> traits;
+        if (traits::guarded && window > traits::guard) {
+            throw std::logic_error("the spatial window must not be larger than the active events guard band");
+        }
+    }
+
+    /// window_first returns the first coordinate of a neighbourhood, clamped to the sensor unless ActiveEvents is
+    /// guarded.
+    template <typename ActiveEvents>
+    int32_t window_first(uint16_t coordinate, uint16_t window) {
+        if (active_events_traits<typename std::decay<ActiveEvents>::type>::guarded) {
+            return static_cast<int32_t>(coordinate) - window;
+        }
+        return coordinate <= window ? 0 : coordinate - window;
+    }
+
+    /// window_last returns the last coordinate of a neighbourhood, clamped to the sensor unless ActiveEvents is
+    /// guarded.
+    template <typename ActiveEvents>
+    int32_t window_last(uint16_t coordinate, uint16_t window, uint16_t size) {
+        if (active_events_traits<typename std::decay<ActiveEvents>::type>::guarded) {
+            return static_cast<int32_t>(coordinate) + window;
+        }
+        return coordinate >= size - 1 - window ? size - 1 : coordinate + window;
+    }
+
+    /// active_events stores the most recent timestamp and polarity of each pixel (surface of active events).
+    /// It can be owned by a handler, or shared by several handlers and updated once per event by
+    /// update_active_events. Use active_events<void> to store timestamps only.
+    /// Allocator (rebound to the pixel type) can be one of the allocators in allocators.hpp.
+    template <typename Polarity, typename Allocator = std::allocator<uint64_t>>
+    class active_events {
+        public:
+        typedef typename std::allocator_traits<Allocator>::template rebind_alloc<std::pair<uint64_t, Polarity>>
+            pixel_allocator;
+
+        active_events(uint16_t width, uint16_t height, Allocator allocator = Allocator()) :
+            _width(width),
+            _height(height),
+            _ts_and_polarities(
+                static_cast<std::size_t>(width) * height,
+                {0, Polarity()},
+                pixel_allocator(std::move(allocator))) {}
+        active_events(const active_events&) = delete;
+        active_events(active_events&&) = default;
+        active_events& operator=(const active_events&) = delete;
+        active_events& operator=(active_events&&) = default;
+        virtual ~active_events() {}
+
+        /// update stores an event's timestamp and polarity.
+        template <typename Event>
+        void update(Event event) {
+            auto& t_and_polarity = _ts_and_polarities[event.x + event.y * static_cast<std::size_t>(_width)];
+            t_and_polarity.first = event.t;
+            t_and_polarity.second = event.polarity;
+        }
+
+        /// t returns the most recent timestamp at the given pixel.
+        uint64_t t(uint16_t x, uint16_t y) const {
+            return _ts_and_polarities[x + y * static_cast<std::size_t>(_width)].first;
+        }
+
+        /// polarity returns the most recent polarity at the given pixel.
+        Polarity polarity(uint16_t x, uint16_t y) const {
+            return _ts_and_polarities[x + y * static_cast<std::size_t>(_width)].second;
+        }
+
+        /// width returns the number of pixels along the x axis.
+        uint16_t width() const {
+            return _width;
+        }
+
+        /// height returns the number of pixels along the y axis.
+        uint16_t height() const {
+            return _height;
+        }
+
+        /// write_state_sections writes the timestamps and polarities to a state stream.
+        void write_state_sections(std::ostream& stream) const {
+            write_state_section(stream, _ts_and_polarities);
+        }
+
+        /// read_state_sections reads the timestamps and polarities from a state stream.
+        void read_state_sections(std::istream& stream) {
+            auto ts_and_polarities = read_state_copy(stream, _ts_and_polarities);
+            _ts_and_polarities.swap(ts_and_polarities);
+        }
+
+        protected:
+        const uint16_t _width;
+        const uint16_t _height;
+        std::vector<std::pair<uint64_t, Polarity>, pixel_allocator> _ts_and_polarities;
+    };
+
+    /// active_events stores the most recent timestamp of each pixel.
+    template <typename Allocator>
+    class active_events<void, Allocator> {
+        public:
+        typedef typename std::allocator_traits<Allocator>::template rebind_alloc<uint64_t> pixel_allocator;
+
+        active_events(uint16_t width, uint16_t height, Allocator allocator = Allocator()) :
+            _width(width),
+            _height(height),
+            _ts(static_cast<std::size_t>(width) * height, 0, pixel_allocator(std::move(allocator))) {}
+        active_events(const active_events&) = delete;
+        active_events(active_events&&) = default;
+        active_events& operator=(const active_events&) = delete;
+        active_events& operator=(active_events&&) = default;
+        virtual ~active_events() {}
+
+        /// update stores an event's timestamp.
+        template <typename Event>
+        void update(Event event) {
+            _ts[event.x + event.y * static_cast<std::size_t>(_width)] = event.t;
+        }
+
+        /// t returns the most recent timestamp at the given pixel.
+        uint64_t t(uint16_t x, uint16_t y) const {
+            return _ts[x + y * static_cast<std::size_t>(_width)];
+        }
+
+        /// width returns the number of pixels along the x axis.
+        uint16_t width() const {
+            return _width;
+        }
+
+        /// height returns the number of pixels along the y axis.
+        uint16_t height() const {
+            return _height;
+        }
+
+        /// write_state_sections writes the timestamps to a state stream.
+        void write_state_sections(std::ostream& stream) const {
+            write_state_section(stream, _ts);
+        }
+
+        /// read_state_sections reads the timestamps from a state stream.
+        void read_state_sections(std::istream& stream) {
+            auto ts = read_state_copy(stream, _ts);
+            _ts.swap(ts);
+        }
+
+        protected:
+        const uint16_t _width;
+        const uint16_t _height;
+        std::vector<uint64_t, pixel_allocator> _ts;
+    };
+}
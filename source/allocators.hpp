@@ -0,0 +1,230 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdlib>
+#include <limits>
+#include <new>
+#ifdef _WIN32
+#include <malloc.h>
+#endif
+#ifdef __linux__
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+/// tarsier is a collection of event handlers.
+namespace tarsier {
+    /// Allocators for the pixel maps of active_events, guarded_active_events, compute_activity and stitch.
+    /// The handlers rebind the given allocator to their pixel type, hence any value_type can be used (for example
+    /// tarsier::huge_page_allocator<uint8_t>).
+
+    /// cache_line_size is the alignment used by aligned_allocator by default.
+    constexpr std::size_t cache_line_size = 64;
+
+    /// huge_page_size is the size of a transparent or explicit huge page on x86-64 and ARM64 Linux.
+    constexpr std::size_t huge_page_size = 2 << 20;
+
+    /// aligned_bytes allocates size bytes aligned on alignment, or throws std::bad_alloc.
+    inline void* aligned_bytes(std::size_t size, std::size_t alignment) {
+#ifdef _WIN32
+        auto pointer = _aligned_malloc(size, alignment);
+        if (pointer == nullptr) {
+            throw std::bad_alloc();
+        }
+        return pointer;
+#else
+        void* pointer = nullptr;
+        if (posix_memalign(&pointer, alignment, size) != 0) {
+            throw std::bad_alloc();
+        }
+        return pointer;
+#endif
+    }
+
+    /// free_aligned_bytes releases memory allocated by aligned_bytes.
+    inline void free_aligned_bytes(void* pointer) {
+#ifdef _WIN32
+        _aligned_free(pointer);
+#else
+        free(pointer);
+#endif
+    }
+
+    /// round_up returns the smallest multiple of step larger than or equal to size.
+    inline std::size_t round_up(std::size_t size, std::size_t step) {
+        return (size + step - 1) / step * step;
+    }
+
+    /// bytes_count returns the number of bytes used by count elements, or throws std::bad_alloc on overflow.
+    template <typename T>
+    std::size_t bytes_count(std::size_t count) {
+        if (count > (std::numeric_limits<std::size_t>::max() - huge_page_size) / sizeof(T)) {
+            throw std::bad_alloc();
+        }
+        return count * sizeof(T);
+    }
+
+    /// aligned_allocator allocates memory aligned on alignment bytes (a cache line by default), so that a pixel
+    /// never straddles two cache lines and vectorised loops start on a boundary.
+    template <typename T, std::size_t alignment = cache_line_size>
+    class aligned_allocator {
+        public:
+        typedef T value_type;
+
+        /// rebind changes the allocated type.
+        template <typename U>
+        struct rebind {
+            typedef aligned_allocator<U, alignment> other;
+        };
+
+        static_assert(
+            alignment >= alignof(T) && (alignment & (alignment - 1)) == 0 && alignment % sizeof(void*) == 0,
+            "alignment must be a power of two and a multiple of the pointer size");
+
+        aligned_allocator() = default;
+        template <typename U>
+        aligned_allocator(const aligned_allocator<U, alignment>&) {}
+
+        /// allocate returns uninitialised memory for count elements.
+        T* allocate(std::size_t count) {
+            return static_cast<T*>(aligned_bytes(bytes_count<T>(count), alignment));
+        }
+
+        /// deallocate releases memory returned by allocate.
+        void deallocate(T* pointer, std::size_t) {
+            free_aligned_bytes(pointer);
+        }
+    };
+
+    /// huge_page_allocator backs large allocations with 2 MiB pages, which cover a 1280 x 720 map of timestamps with
+    /// 4 TLB entries instead of 1800. It requests explicit huge pages (MAP_HUGETLB, reserved by the administrator with
+    /// vm.nr_hugepages) first, and falls back to 2 MiB-aligned memory marked for transparent huge pages
+    /// (MADV_HUGEPAGE). Outside Linux, it falls back to page-aligned memory.
+    template <typename T>
+    class huge_page_allocator {
+        public:
+        typedef T value_type;
+
+        huge_page_allocator() = default;
+        template <typename U>
+        huge_page_allocator(const huge_page_allocator<U>&) {}
+
+        /// allocate returns memory for count elements.
+        T* allocate(std::size_t count) {
+            const auto size = round_up(bytes_count<T>(count), huge_page_size);
+#ifdef __linux__
+            void* pointer;
+#ifdef MAP_HUGETLB
+            pointer = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+            if (pointer != MAP_FAILED) {
+                return static_cast<T*>(pointer);
+            }
+#endif
+            pointer = mmap(nullptr, size + huge_page_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (pointer == MAP_FAILED) {
+                throw std::bad_alloc();
+            }
+            const auto address = reinterpret_cast<uintptr_t>(pointer);
+            const auto aligned_address = round_up(address, huge_page_size);
+            if (aligned_address > address) {
+                munmap(pointer, aligned_address - address);
+            }
+            munmap(reinterpret_cast<void*>(aligned_address + size), address + huge_page_size - aligned_address);
+#ifdef MADV_HUGEPAGE
+            madvise(reinterpret_cast<void*>(aligned_address), size, MADV_HUGEPAGE);
+#endif
+            return reinterpret_cast<T*>(aligned_address);
+#else
+            return static_cast<T*>(aligned_bytes(size, 4096));
+#endif
+        }
+
+        /// deallocate releases memory returned by allocate.
+        void deallocate(T* pointer, std::size_t count) {
+#ifdef __linux__
+            munmap(pointer, round_up(count * sizeof(T), huge_page_size));
+#else
+            free_aligned_bytes(pointer);
+#endif
+        }
+    };
+
+    /// numa_local_allocator allocates pages that are placed on the NUMA node of the thread that first writes them
+    /// (MPOL_LOCAL), regardless of the process policy (for instance numactl --interleave). Handlers initialise their
+    /// maps in their constructor, hence a handler built on a worker thread (for instance in replay's make_handler)
+    /// gets its pixel state on that worker's node. Outside Linux, it falls back to page-aligned memory.
+    template <typename T>
+    class numa_local_allocator {
+        public:
+        typedef T value_type;
+
+        numa_local_allocator() = default;
+        template <typename U>
+        numa_local_allocator(const numa_local_allocator<U>&) {}
+
+        /// allocate returns memory for count elements, without touching its pages.
+        T* allocate(std::size_t count) {
+#ifdef __linux__
+            const auto size = round_up(bytes_count<T>(count), static_cast<std::size_t>(sysconf(_SC_PAGESIZE)));
+            auto pointer = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (pointer == MAP_FAILED) {
+                throw std::bad_alloc();
+            }
+#ifdef SYS_mbind
+            // MPOL_LOCAL is not exposed by the libc headers (it is defined in numaif.h, from libnuma).
+            const int mpol_local = 4;
+            syscall(SYS_mbind, pointer, size, mpol_local, nullptr, 0, 0);
+#endif
+            return static_cast<T*>(pointer);
+#else
+            return static_cast<T*>(aligned_bytes(round_up(bytes_count<T>(count), 4096), 4096));
+#endif
+        }
+
+        /// deallocate releases memory returned by allocate.
+        void deallocate(T* pointer, std::size_t count) {
+#ifdef __linux__
+            munmap(pointer, round_up(count * sizeof(T), static_cast<std::size_t>(sysconf(_SC_PAGESIZE))));
+#else
+            free_aligned_bytes(pointer);
+#endif
+        }
+    };
+
+    /// operator== returns true if the allocators have the same alignment.
+    template <typename T, std::size_t t_alignment, typename U, std::size_t u_alignment>
+    bool operator==(const aligned_allocator<T, t_alignment>&, const aligned_allocator<U, u_alignment>&) {
+        return t_alignment == u_alignment;
+    }
+
+    /// operator!= returns true if the allocators have different alignments.
+    template <typename T, std::size_t t_alignment, typename U, std::size_t u_alignment>
+    bool operator!=(const aligned_allocator<T, t_alignment>&, const aligned_allocator<U, u_alignment>&) {
+        return t_alignment != u_alignment;
+    }
+
+    /// operator== returns true since the allocators are stateless.
+    template <typename T, typename U>
+    bool operator==(const huge_page_allocator<T>&, const huge_page_allocator<U>&) {
+        return true;
+    }
+
+    /// operator!= returns false since the allocators are stateless.
+    template <typename T, typename U>
+    bool operator!=(const huge_page_allocator<T>&, const huge_page_allocator<U>&) {
+        return false;
+    }
+
+    /// operator== returns true since the allocators are stateless.
+    template <typename T, typename U>
+    bool operator==(const numa_local_allocator<T>&, const numa_local_allocator<U>&) {
+        return true;
+    }
+
+    /// operator!= returns false since the allocators are stateless.
+    template <typename T, typename U>
+    bool operator!=(const numa_local_allocator<T>&, const numa_local_allocator<U>&) {
+        return false;
+    }
+}
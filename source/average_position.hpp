@@ -1,30 +1,49 @@
 #pragma once
 
+#include "emission.hpp"
+#include "fixed_point.hpp"
+#include "inertia.hpp"
+#include "snapshot.hpp"
+#include "state.hpp"
+#include <array>
 #include <stdexcept>
 #include <utility>
+#include <vector>
 
 /// tarsier is a collection of event handlers.
 namespace tarsier {
     /// average_position calculates the average position of the given events.
     /// An exponential event-wise decay is used as weight.
-    template <typename Event, typename Position, typename EventToPosition, typename HandlePosition>
+    /// Number can be float or a fixed_point. With fixed_point, the inertia is stored with 30 fractional bits and each
+    /// event adds a rounding error of at most q, the resolution of Number. The position differs from the float version
+    /// by at most q / (1 - inertia) for coordinates below 2^14 (0.015 pixels in Q16.16 with an inertia of 0.999).
+    /// Emission selects the events that trigger an output (see emission.hpp).
+    /// Inertia gives the weight of the previous position (see inertia.hpp): a fixed inertia per event by default, or
+    /// a time constant with time_inertia.
+    template <
+        typename Event,
+        typename Position,
+        typename EventToPosition,
+        typename HandlePosition,
+        typename Number = float,
+        typename Emission = emit_always,
+        typename Inertia = event_inertia<Number>>
     class average_position {
         public:
         average_position(
             float x,
             float y,
-            float inertia,
+            Inertia inertia,
             EventToPosition event_to_position,
-            HandlePosition handle_position) :
+            HandlePosition handle_position,
+            Emission emission = Emission()) :
             _x(x),
             _y(y),
-            _inertia(inertia),
+            _inertia(std::move(inertia)),
             _event_to_position(std::forward<EventToPosition>(event_to_position)),
-            _handle_position(std::forward<HandlePosition>(handle_position)) {
-            if (_inertia < 0 || _inertia > 1) {
-                throw std::logic_error("inertia must be in the range [0, 1]");
-            }
-        }
+            _handle_position(std::forward<HandlePosition>(handle_position)),
+            _emission(std::move(emission)),
+            _snapshot(nullptr) {}
         average_position(const average_position&) = delete;
         average_position(average_position&&) = default;
         average_position& operator=(const average_position&) = delete;
@@ -33,32 +52,143 @@ namespace tarsier {
 
         /// operator() handles an event.
         virtual void operator()(Event event) {
-            _x = _inertia * _x + (1 - _inertia) * event.x;
-            _y = _inertia * _y + (1 - _inertia) * event.y;
-            _handle_position(_event_to_position(event, _x, _y));
+            _inertia.update(event);
+            _x = _x * _inertia.inertia() + Number(event.x) * _inertia.complement();
+            _y = _y * _inertia.inertia() + Number(event.y) * _inertia.complement();
+            publish(event, _emission.due(event));
+        }
+
+        /// operator() handles a batch of events.
+        /// The batch is split after each event due for an output (see emission.hpp), and the position is updated
+        /// once per part, with the weights of the events in closed form, hence the sums have no dependency between
+        /// events. The outputs match the single-event updates up to rounding.
+        virtual void operator()(const Event* events, std::size_t count) {
+            std::size_t begin = 0;
+            while (begin < count) {
+                auto end = begin;
+                auto due = false;
+                while (!due && end < count) {
+                    due = _emission.due(events[end]);
+                    ++end;
+                }
+                update(events + begin, end - begin);
+                publish(events[end - 1], due);
+                begin = end;
+            }
+        }
+
+        /// publish_to makes the position (x, y) available to another thread after each event.
+        void publish_to(snapshot<std::array<Number, 2>>& position_snapshot) {
+            _snapshot = &position_snapshot;
+        }
+
+        /// save_state writes the position and the inertia's state to a stream.
+        void save_state(std::ostream& stream) const {
+            write_state_header(stream, "average_position");
+            const std::array<Number, 2> values{{_x, _y}};
+            write_state_section(stream, values.data(), values.size());
+            _inertia.write_state_sections(stream);
+        }
+
+        /// load_state reads the position and the inertia's state written by save_state.
+        void load_state(std::istream& stream) {
+            read_state_header(stream, "average_position");
+            std::array<Number, 2> values;
+            read_state_section(stream, values.data(), values.size());
+            _inertia.read_state_sections(stream);
+            _x = values[0];
+            _y = values[1];
         }
 
         protected:
-        float _x;
-        float _y;
-        const float _inertia;
+        /// update applies a part of a batch to the position.
+        void update(const Event* events, std::size_t count) {
+            _weights.resize(count);
+            const auto head = _inertia.weights(events, count, _weights.data());
+            auto x = _x * head;
+            auto y = _y * head;
+            for (std::size_t index = 0; index < count; ++index) {
+                x = x + Number(events[index].x) * _weights[index];
+                y = y + Number(events[index].y) * _weights[index];
+            }
+            _x = x;
+            _y = y;
+        }
+
+        /// publish sends the position to the snapshot, and to the handler if the event is due for an output.
+        void publish(Event event, bool due) {
+            if (_snapshot != nullptr) {
+                _snapshot->back() = {{_x, _y}};
+                _snapshot->publish();
+            }
+            if (due && _emission.emit(_x, _y)) {
+                _handle_position(_event_to_position(event, _x, _y));
+            }
+        }
+
+        Number _x;
+        Number _y;
+        Inertia _inertia;
         EventToPosition _event_to_position;
         HandlePosition _handle_position;
+        Emission _emission;
+        snapshot<std::array<Number, 2>>* _snapshot;
+        std::vector<typename decay_factor<Number>::type> _weights;
     };
 
     /// make_average_position creates an average_position from functors.
-    template <typename Event, typename Position, typename EventToPosition, typename HandlePosition>
-    average_position<Event, Position, EventToPosition, HandlePosition> make_average_position(
+    template <
+        typename Event,
+        typename Position,
+        typename Number = float,
+        typename EventToPosition,
+        typename HandlePosition,
+        typename Emission = emit_always>
+    average_position<Event, Position, EventToPosition, HandlePosition, Number, Emission> make_average_position(
         float x,
         float y,
         float inertia,
         EventToPosition EventToposition,
-        HandlePosition handle_position) {
-        return average_position<Event, Position, EventToPosition, HandlePosition>(
+        HandlePosition handle_position,
+        Emission emission = Emission()) {
+        return average_position<Event, Position, EventToPosition, HandlePosition, Number, Emission>(
             x,
             y,
             inertia,
             std::forward<EventToPosition>(EventToposition),
-            std::forward<HandlePosition>(handle_position));
+            std::forward<HandlePosition>(handle_position),
+            std::move(emission));
+    }
+
+    /// make_average_position creates an average_position with a time-based inertia from functors.
+    template <
+        typename Event,
+        typename Position,
+        typename Number = float,
+        typename EventToPosition,
+        typename HandlePosition,
+        typename Emission = emit_always>
+    average_position<Event, Position, EventToPosition, HandlePosition, Number, Emission, time_inertia<Number>>
+    make_average_position(
+        float x,
+        float y,
+        time_constant inertia_time_constant,
+        EventToPosition event_to_position,
+        HandlePosition handle_position,
+        Emission emission = Emission()) {
+        return average_position<
+            Event,
+            Position,
+            EventToPosition,
+            HandlePosition,
+            Number,
+            Emission,
+            time_inertia<Number>>(
+            x,
+            y,
+            inertia_time_constant,
+            std::forward<EventToPosition>(event_to_position),
+            std::forward<HandlePosition>(handle_position),
+            std::move(emission));
     }
 }
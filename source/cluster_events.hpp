@@ -0,0 +1,271 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+/// tarsier is a collection of event handlers.
+namespace tarsier {
+    /// cluster_change enumerates the notifications sent by cluster_events.
+    enum class cluster_change {
+        create,
+        merge,
+        end,
+    };
+
+    /// cluster_events assigns each event to a cluster of spatio-temporally connected events.
+    /// An event is connected to the pixels within spatial_radius that were active less than temporal_window ago.
+    /// Connected clusters are merged with a union-find structure (path halving, union by size).
+    /// handle_cluster_change is called with (t, cluster_change::create, id, id) when a cluster appears,
+    /// (t, cluster_change::merge, id, other_id) when cluster id is merged into cluster other_id, and
+    /// (t, cluster_change::end, id, id) when cluster id has been inactive for temporal_window.
+    template <
+        typename Event,
+        typename ClusterEvent,
+        typename EventToClusterEvent,
+        typename HandleClusterEvent,
+        typename HandleClusterChange>
+    class cluster_events {
+        public:
+        cluster_events(
+            uint16_t width,
+            uint16_t height,
+            uint16_t spatial_radius,
+            uint64_t temporal_window,
+            EventToClusterEvent event_to_cluster_event,
+            HandleClusterEvent handle_cluster_event,
+            HandleClusterChange handle_cluster_change) :
+            _width(width),
+            _height(height),
+            _spatial_radius(spatial_radius),
+            _temporal_window(temporal_window),
+            _event_to_cluster_event(std::forward<EventToClusterEvent>(event_to_cluster_event)),
+            _handle_cluster_event(std::forward<HandleClusterEvent>(handle_cluster_event)),
+            _handle_cluster_change(std::forward<HandleClusterChange>(handle_cluster_change)),
+            _pixels(static_cast<std::size_t>(width) * height, pixel{0, none}),
+            _oldest(none),
+            _newest(none),
+            _next_id(0),
+            _members(0) {
+            if (temporal_window == 0) {
+                throw std::logic_error("temporal_window must be larger than zero");
+            }
+        }
+        cluster_events(const cluster_events&) = delete;
+        cluster_events(cluster_events&&) = default;
+        cluster_events& operator=(const cluster_events&) = delete;
+        cluster_events& operator=(cluster_events&&) = default;
+        virtual ~cluster_events() {}
+
+        /// operator() handles an event.
+        virtual void operator()(Event event) {
+            expire(event.t);
+            const auto t_threshold = (event.t <= _temporal_window ? 0 : event.t - _temporal_window);
+            auto root = none;
+            for (uint16_t y = (event.y <= _spatial_radius ? 0 : event.y - _spatial_radius);
+                 y <= (event.y >= _height - 1 - _spatial_radius ? _height - 1 : event.y + _spatial_radius);
+                 ++y) {
+                for (uint16_t x = (event.x <= _spatial_radius ? 0 : event.x - _spatial_radius);
+                     x <= (event.x >= _width - 1 - _spatial_radius ? _width - 1 : event.x + _spatial_radius);
+                     ++x) {
+                    auto& neighbour = _pixels[x + y * static_cast<std::size_t>(_width)];
+                    if (neighbour.t > t_threshold) {
+                        neighbour.label = find(neighbour.label);
+                        if (root == none) {
+                            root = neighbour.label;
+                        } else if (neighbour.label != root) {
+                            root = unite(root, neighbour.label, event.t);
+                        }
+                    }
+                }
+            }
+            if (root == none) {
+                root = create(event.t);
+            } else {
+                unlink(root);
+                link(root);
+            }
+            auto& cluster = _nodes[root];
+            cluster.t = event.t;
+            ++cluster.size;
+            _pixels[event.x + event.y * static_cast<std::size_t>(_width)] = pixel{event.t, root};
+            _handle_cluster_event(_event_to_cluster_event(event, cluster.id));
+        }
+
+        /// number_of_clusters returns the number of active clusters.
+        std::size_t number_of_clusters() const {
+            return _nodes.size() - _free_nodes.size() - _members;
+        }
+
+        protected:
+        /// none represents a missing node.
+        static constexpr uint32_t none = std::numeric_limits<uint32_t>::max();
+
+        /// pixel stores the most recent timestamp and the union-find node of a pixel.
+        struct pixel {
+            uint64_t t;
+            uint32_t label;
+        };
+
+        /// node is an element of the union-find forest.
+        /// Roots represent clusters, and are stored in a list sorted by last activity.
+        /// Each root also chains its members, so that they can be recycled when the cluster ends.
+        struct node {
+            uint32_t parent;
+            uint32_t next_member;
+            uint32_t last_member;
+            uint32_t older;
+            uint32_t newer;
+            uint64_t id;
+            uint64_t t;
+            uint64_t size;
+        };
+
+        /// find returns the root of a node, and halves the path.
+        uint32_t find(uint32_t index) {
+            while (_nodes[index].parent != index) {
+                _nodes[index].parent = _nodes[_nodes[index].parent].parent;
+                index = _nodes[index].parent;
+            }
+            return index;
+        }
+
+        /// create allocates a root for a new cluster.
+        uint32_t create(uint64_t t) {
+            uint32_t index;
+            if (_free_nodes.empty()) {
+                index = static_cast<uint32_t>(_nodes.size());
+                _nodes.emplace_back();
+            } else {
+                index = _free_nodes.back();
+                _free_nodes.pop_back();
+            }
+            auto& cluster = _nodes[index];
+            cluster.parent = index;
+            cluster.next_member = none;
+            cluster.last_member = index;
+            cluster.id = _next_id;
+            cluster.size = 0;
+            ++_next_id;
+            link(index);
+            _handle_cluster_change(t, cluster_change::create, cluster.id, cluster.id);
+            return index;
+        }
+
+        /// unite merges the smaller of two clusters into the larger one, and returns the remaining root.
+        uint32_t unite(uint32_t first, uint32_t second, uint64_t t) {
+            if (_nodes[first].size < _nodes[second].size) {
+                std::swap(first, second);
+            }
+            auto& cluster = _nodes[first];
+            auto& merged = _nodes[second];
+            merged.parent = first;
+            _nodes[cluster.last_member].next_member = second;
+            cluster.last_member = merged.last_member;
+            cluster.size += merged.size;
+            if (merged.t > cluster.t) {
+                cluster.t = merged.t;
+            }
+            unlink(second);
+            ++_members;
+            _handle_cluster_change(t, cluster_change::merge, merged.id, cluster.id);
+            return first;
+        }
+
+        /// expire ends the clusters inactive for longer than the temporal window, and recycles their nodes.
+        /// An event older than the oldest cluster (out of order input) expires nothing.
+        void expire(uint64_t t) {
+            while (_oldest != none && t > _nodes[_oldest].t && t - _nodes[_oldest].t > _temporal_window) {
+                const auto root = _oldest;
+                unlink(root);
+                _handle_cluster_change(t, cluster_change::end, _nodes[root].id, _nodes[root].id);
+                for (auto member = root; member != none; member = _nodes[member].next_member) {
+                    _free_nodes.push_back(member);
+                    if (member != root) {
+                        --_members;
+                    }
+                }
+            }
+        }
+
+        /// unlink removes a root from the activity list.
+        void unlink(uint32_t index) {
+            auto& cluster = _nodes[index];
+            if (cluster.older == none) {
+                _oldest = cluster.newer;
+            } else {
+                _nodes[cluster.older].newer = cluster.newer;
+            }
+            if (cluster.newer == none) {
+                _newest = cluster.older;
+            } else {
+                _nodes[cluster.newer].older = cluster.older;
+            }
+        }
+
+        /// link appends a root to the activity list.
+        void link(uint32_t index) {
+            auto& cluster = _nodes[index];
+            cluster.older = _newest;
+            cluster.newer = none;
+            if (_newest == none) {
+                _oldest = index;
+            } else {
+                _nodes[_newest].newer = index;
+            }
+            _newest = index;
+        }
+
+        const uint16_t _width;
+        const uint16_t _height;
+        const uint16_t _spatial_radius;
+        const uint64_t _temporal_window;
+        EventToClusterEvent _event_to_cluster_event;
+        HandleClusterEvent _handle_cluster_event;
+        HandleClusterChange _handle_cluster_change;
+        std::vector<pixel> _pixels;
+        std::vector<node> _nodes;
+        std::vector<uint32_t> _free_nodes;
+        uint32_t _oldest;
+        uint32_t _newest;
+        uint64_t _next_id;
+        std::size_t _members;
+    };
+
+    template <
+        typename Event,
+        typename ClusterEvent,
+        typename EventToClusterEvent,
+        typename HandleClusterEvent,
+        typename HandleClusterChange>
+    constexpr uint32_t
+        cluster_events<Event, ClusterEvent, EventToClusterEvent, HandleClusterEvent, HandleClusterChange>::none;
+
+    /// make_cluster_events creates a cluster_events from functors.
+    template <
+        typename Event,
+        typename ClusterEvent,
+        typename EventToClusterEvent,
+        typename HandleClusterEvent,
+        typename HandleClusterChange>
+    cluster_events<Event, ClusterEvent, EventToClusterEvent, HandleClusterEvent, HandleClusterChange>
+    make_cluster_events(
+        uint16_t width,
+        uint16_t height,
+        uint16_t spatial_radius,
+        uint64_t temporal_window,
+        EventToClusterEvent event_to_cluster_event,
+        HandleClusterEvent handle_cluster_event,
+        HandleClusterChange handle_cluster_change) {
+        return cluster_events<Event, ClusterEvent, EventToClusterEvent, HandleClusterEvent, HandleClusterChange>(
+            width,
+            height,
+            spatial_radius,
+            temporal_window,
+            std::forward<EventToClusterEvent>(event_to_cluster_event),
+            std::forward<HandleClusterEvent>(handle_cluster_event),
+            std::forward<HandleClusterChange>(handle_cluster_change));
+    }
+}
@@ -0,0 +1,153 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+/// tarsier is a collection of event handlers.
+namespace tarsier {
+    /// frequency_marker represents a group of nearby pixels blinking at the same frequency (for instance, an LED).
+    struct frequency_marker {
+        uint64_t id;
+        uint64_t t;
+        float x;
+        float y;
+        float frequency;
+        uint64_t count;
+    };
+
+    /// cluster_frequencies groups frequency events (see detect_frequency) into markers.
+    /// The frequency event type must have t, x, y and frequency members. An event joins the closest active marker
+    /// within radius pixels whose frequency is within tolerance (relative) of its own, and the marker's position and
+    /// frequency follow its events with an exponential filter of weight filter_weight. Otherwise, the event creates
+    /// a marker. Markers without events for temporal_window are dropped, and at most maximum_number_of_markers are
+    /// active at once (events that would create more are ignored). frequency_event_to_marker_event(frequency_event,
+    /// marker) is called for each clustered event.
+    template <
+        typename FrequencyEvent,
+        typename MarkerEvent,
+        typename FrequencyEventToMarkerEvent,
+        typename HandleMarkerEvent>
+    class cluster_frequencies {
+        public:
+        cluster_frequencies(
+            float radius,
+            float tolerance,
+            float filter_weight,
+            uint64_t temporal_window,
+            std::size_t maximum_number_of_markers,
+            FrequencyEventToMarkerEvent frequency_event_to_marker_event,
+            HandleMarkerEvent handle_marker_event) :
+            _squared_radius(radius * radius),
+            _tolerance(tolerance),
+            _filter_weight(filter_weight),
+            _temporal_window(temporal_window),
+            _frequency_event_to_marker_event(
+                std::forward<FrequencyEventToMarkerEvent>(frequency_event_to_marker_event)),
+            _handle_marker_event(std::forward<HandleMarkerEvent>(handle_marker_event)),
+            _markers(maximum_number_of_markers, frequency_marker{0, 0, 0.0f, 0.0f, 0.0f, 0}),
+            _next_id(0) {
+            if (radius < 0.0f) {
+                throw std::logic_error("radius must be positive");
+            }
+            if (filter_weight <= 0.0f || filter_weight > 1.0f) {
+                throw std::logic_error("filter_weight must be in the range ]0, 1]");
+            }
+            if (maximum_number_of_markers == 0) {
+                throw std::logic_error("maximum_number_of_markers must be larger than zero");
+            }
+        }
+        cluster_frequencies(const cluster_frequencies&) = delete;
+        cluster_frequencies(cluster_frequencies&&) = default;
+        cluster_frequencies& operator=(const cluster_frequencies&) = delete;
+        cluster_frequencies& operator=(cluster_frequencies&&) = default;
+        virtual ~cluster_frequencies() {}
+
+        /// operator() handles a frequency event.
+        virtual void operator()(FrequencyEvent frequency_event) {
+            const auto none = _markers.size();
+            auto closest = none;
+            auto free = none;
+            auto closest_squared_distance = std::numeric_limits<float>::infinity();
+            for (std::size_t index = 0; index < _markers.size(); ++index) {
+                const auto& marker = _markers[index];
+                if (marker.count == 0 || marker.t + _temporal_window < frequency_event.t) {
+                    if (free == none) {
+                        free = index;
+                    }
+                    continue;
+                }
+                if (std::abs(frequency_event.frequency - marker.frequency) > _tolerance * marker.frequency) {
+                    continue;
+                }
+                const auto dx = frequency_event.x - marker.x;
+                const auto dy = frequency_event.y - marker.y;
+                const auto squared_distance = dx * dx + dy * dy;
+                if (squared_distance <= _squared_radius && squared_distance < closest_squared_distance) {
+                    closest_squared_distance = squared_distance;
+                    closest = index;
+                }
+            }
+            if (closest == none) {
+                if (free == none) {
+                    return;
+                }
+                closest = free;
+                _markers[closest] = frequency_marker{
+                    _next_id,
+                    frequency_event.t,
+                    static_cast<float>(frequency_event.x),
+                    static_cast<float>(frequency_event.y),
+                    frequency_event.frequency,
+                    0};
+                ++_next_id;
+            } else {
+                auto& marker = _markers[closest];
+                marker.t = frequency_event.t;
+                marker.x += _filter_weight * (frequency_event.x - marker.x);
+                marker.y += _filter_weight * (frequency_event.y - marker.y);
+                marker.frequency += _filter_weight * (frequency_event.frequency - marker.frequency);
+            }
+            ++_markers[closest].count;
+            _handle_marker_event(_frequency_event_to_marker_event(frequency_event, _markers[closest]));
+        }
+
+        protected:
+        const float _squared_radius;
+        const float _tolerance;
+        const float _filter_weight;
+        const uint64_t _temporal_window;
+        FrequencyEventToMarkerEvent _frequency_event_to_marker_event;
+        HandleMarkerEvent _handle_marker_event;
+        std::vector<frequency_marker> _markers;
+        uint64_t _next_id;
+    };
+
+    /// make_cluster_frequencies creates a cluster_frequencies from functors.
+    template <
+        typename FrequencyEvent,
+        typename MarkerEvent,
+        typename FrequencyEventToMarkerEvent,
+        typename HandleMarkerEvent>
+    cluster_frequencies<FrequencyEvent, MarkerEvent, FrequencyEventToMarkerEvent, HandleMarkerEvent>
+    make_cluster_frequencies(
+        float radius,
+        float tolerance,
+        float filter_weight,
+        uint64_t temporal_window,
+        std::size_t maximum_number_of_markers,
+        FrequencyEventToMarkerEvent frequency_event_to_marker_event,
+        HandleMarkerEvent handle_marker_event) {
+        return cluster_frequencies<FrequencyEvent, MarkerEvent, FrequencyEventToMarkerEvent, HandleMarkerEvent>(
+            radius,
+            tolerance,
+            filter_weight,
+            temporal_window,
+            maximum_number_of_markers,
+            std::forward<FrequencyEventToMarkerEvent>(frequency_event_to_marker_event),
+            std::forward<HandleMarkerEvent>(handle_marker_event));
+    }
+}
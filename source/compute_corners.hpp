@@ -0,0 +1,130 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+/// tarsier is a collection of event handlers.
+namespace tarsier {
+    /// compute_corners detects corners on the surface of active events (eFAST).
+    /// A corner is detected when the most recent timestamps on a circle around the event form a contiguous arc whose
+    /// length lies in a given range, or in the complementary range (the older pixels form the short arc). The inner
+    /// circle (radius 3, arcs of 3 to 6 or 10 to 13 pixels) is always tested, and the outer circle (radius 4, arcs of
+    /// 4 to 8 or 12 to 16 pixels) is tested as well when refine is true.
+    /// The event type must have a boolean polarity, each polarity having its own surface.
+    template <typename Event, typename Corner, typename EventToCorner, typename HandleCorner>
+    class compute_corners {
+        public:
+        compute_corners(
+            uint16_t width,
+            uint16_t height,
+            bool refine,
+            EventToCorner event_to_corner,
+            HandleCorner handle_corner) :
+            _width(width),
+            _height(height),
+            _refine(refine),
+            _event_to_corner(std::forward<EventToCorner>(event_to_corner)),
+            _handle_corner(std::forward<HandleCorner>(handle_corner)),
+            _ts(static_cast<std::size_t>(width) * height * 2, 0) {
+            const std::array<std::pair<int32_t, int32_t>, 16> inner_circle{{
+                {0, 3}, {1, 3}, {2, 2}, {3, 1}, {3, 0}, {3, -1}, {2, -2}, {1, -3},
+                {0, -3}, {-1, -3}, {-2, -2}, {-3, -1}, {-3, 0}, {-3, 1}, {-2, 2}, {-1, 3},
+            }};
+            const std::array<std::pair<int32_t, int32_t>, 20> outer_circle{{
+                {0, 4}, {1, 4}, {2, 3}, {3, 2}, {4, 1}, {4, 0}, {4, -1}, {3, -2}, {2, -3}, {1, -4},
+                {0, -4}, {-1, -4}, {-2, -3}, {-3, -2}, {-4, -1}, {-4, 0}, {-4, 1}, {-3, 2}, {-2, 3}, {-1, 4},
+            }};
+            for (std::size_t index = 0; index < inner_circle.size(); ++index) {
+                _inner_offsets[index] = inner_circle[index].first + inner_circle[index].second * _width;
+            }
+            for (std::size_t index = 0; index < outer_circle.size(); ++index) {
+                _outer_offsets[index] = outer_circle[index].first + outer_circle[index].second * _width;
+            }
+        }
+        compute_corners(const compute_corners&) = delete;
+        compute_corners(compute_corners&&) = default;
+        compute_corners& operator=(const compute_corners&) = delete;
+        compute_corners& operator=(compute_corners&&) = default;
+        virtual ~compute_corners() {}
+
+        /// operator() handles an event.
+        virtual void operator()(Event event) {
+            const auto index = event.x + event.y * static_cast<std::size_t>(_width)
+                               + (event.polarity ? static_cast<std::size_t>(_width) * _height : 0);
+            _ts[index] = event.t;
+            if (event.x < 4 || event.x >= _width - 4 || event.y < 4 || event.y >= _height - 4) {
+                return;
+            }
+            if (is_arc<16, 3, 6>(index, _inner_offsets) && (!_refine || is_arc<20, 4, 8>(index, _outer_offsets))) {
+                _handle_corner(_event_to_corner(event));
+            }
+        }
+
+        protected:
+        /// is_arc determines whether the most recent timestamps on a circle form a contiguous arc, with a length in
+        /// [minimum_length, maximum_length] or in [size - maximum_length, size - minimum_length].
+        template <std::size_t size, std::size_t minimum_length, std::size_t maximum_length>
+        bool is_arc(std::size_t index, const std::array<std::ptrdiff_t, size>& offsets) const {
+            std::array<uint64_t, size> ts;
+            for (std::size_t offset_index = 0; offset_index < size; ++offset_index) {
+                ts[offset_index] = _ts[index + offsets[offset_index]];
+            }
+            for (std::size_t start = 0; start < size; ++start) {
+                if (ts[start] < ts[(start + size - 1) % size]) {
+                    continue;
+                }
+                auto arc_minimum = ts[start];
+                for (std::size_t length = 1; length < size - minimum_length; ++length) {
+                    const auto end_t = ts[(start + length) % size];
+                    if (end_t < arc_minimum) {
+                        arc_minimum = end_t;
+                    }
+                    if (length + 1 < minimum_length
+                        || (length + 1 > maximum_length && length + 1 < size - maximum_length)
+                        || end_t < ts[(start + length + 1) % size]) {
+                        continue;
+                    }
+                    auto is_corner = true;
+                    for (std::size_t other = length + 1; other < size; ++other) {
+                        if (ts[(start + other) % size] >= arc_minimum) {
+                            is_corner = false;
+                            break;
+                        }
+                    }
+                    if (is_corner) {
+                        return true;
+                    }
+                }
+            }
+            return false;
+        }
+
+        const uint16_t _width;
+        const uint16_t _height;
+        const bool _refine;
+        EventToCorner _event_to_corner;
+        HandleCorner _handle_corner;
+        std::vector<uint64_t> _ts;
+        std::array<std::ptrdiff_t, 16> _inner_offsets;
+        std::array<std::ptrdiff_t, 20> _outer_offsets;
+    };
+
+    /// make_compute_corners creates a compute_corners from functors.
+    template <typename Event, typename Corner, typename EventToCorner, typename HandleCorner>
+    compute_corners<Event, Corner, EventToCorner, HandleCorner> make_compute_corners(
+        uint16_t width,
+        uint16_t height,
+        bool refine,
+        EventToCorner event_to_corner,
+        HandleCorner handle_corner) {
+        return compute_corners<Event, Corner, EventToCorner, HandleCorner>(
+            width,
+            height,
+            refine,
+            std::forward<EventToCorner>(event_to_corner),
+            std::forward<HandleCorner>(handle_corner));
+    }
+}
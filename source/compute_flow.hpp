@@ -1,14 +1,89 @@
 #pragma once
 
+#include "active_events.hpp"
+#include "emission.hpp"
+#include "state.hpp"
 #include <cmath>
 #include <cstdint>
+#include <type_traits>
 #include <utility>
 #include <vector>
 
 /// tarsier is a collection of event handlers.
 namespace tarsier {
+    /// plane_fit fits a plane t = f(x, y) to points given relative to an event, and derives the optical flow from
+    /// its gradient. The sums are accumulated in a single pass, so that no point is stored.
+    class plane_fit {
+        public:
+        plane_fit() :
+            _count(0),
+            _t_sum(0.0f),
+            _x_sum(0.0f),
+            _y_sum(0.0f),
+            _tx_sum(0.0f),
+            _ty_sum(0.0f),
+            _xx_sum(0.0f),
+            _xy_sum(0.0f),
+            _yy_sum(0.0f) {}
+
+        /// add accumulates a point.
+        void add(float t_delta, float x_delta, float y_delta) {
+            ++_count;
+            _t_sum += t_delta;
+            _x_sum += x_delta;
+            _y_sum += y_delta;
+            _tx_sum += t_delta * x_delta;
+            _ty_sum += t_delta * y_delta;
+            _xx_sum += x_delta * x_delta;
+            _xy_sum += x_delta * y_delta;
+            _yy_sum += y_delta * y_delta;
+        }
+
+        /// count returns the number of accumulated points.
+        std::size_t count() const {
+            return _count;
+        }
+
+        /// velocity calculates the flow, in pixels per timestamp unit.
+        void velocity(float& vx, float& vy) const {
+            const auto inverse_count = 1.0f / _count;
+            const auto tx_sum = _tx_sum - _t_sum * _x_sum * inverse_count;
+            const auto ty_sum = _ty_sum - _t_sum * _y_sum * inverse_count;
+            const auto xx_sum = _xx_sum - _x_sum * _x_sum * inverse_count;
+            const auto xy_sum = _xy_sum - _x_sum * _y_sum * inverse_count;
+            const auto yy_sum = _yy_sum - _y_sum * _y_sum * inverse_count;
+            const auto t_determinant = xx_sum * yy_sum - xy_sum * xy_sum;
+            const auto x_determinant = tx_sum * yy_sum - ty_sum * xy_sum;
+            const auto y_determinant = ty_sum * xx_sum - tx_sum * xy_sum;
+            const auto inverse_squares_sum = 1.0f / (x_determinant * x_determinant + y_determinant * y_determinant);
+            vx = t_determinant * x_determinant * inverse_squares_sum;
+            vy = t_determinant * y_determinant * inverse_squares_sum;
+        }
+
+        protected:
+        std::size_t _count;
+        float _t_sum;
+        float _x_sum;
+        float _y_sum;
+        float _tx_sum;
+        float _ty_sum;
+        float _xx_sum;
+        float _xy_sum;
+        float _yy_sum;
+    };
+
     /// compute_flow evaluates the optical flow.
-    template <typename Event, typename Flow, typename EventToFlow, typename HandleFlow>
+    /// When ActiveEvents is a reference, the timestamps are shared with other handlers and must be updated before
+    /// each event reaches compute_flow (see update_active_events). Otherwise, compute_flow owns and updates them.
+    /// Emission selects the events that trigger an output (see emission.hpp). The flow is not fitted for the other
+    /// events.
+    template <
+        typename Event,
+        typename Flow,
+        typename EventToFlow,
+        typename HandleFlow,
+        typename ActiveEvents = active_events<void>,
+        typename Emission = emit_always>
     class compute_flow {
         public:
         compute_flow(
@@ -18,7 +93,8 @@ namespace tarsier {
             uint64_t temporal_window,
             std::size_t minimum_number_of_events,
             EventToFlow event_to_flow,
-            HandleFlow handle_flow) :
+            HandleFlow handle_flow,
+            Emission emission = Emission()) :
             _width(width),
             _height(height),
             _spatial_window(spatial_window),
@@ -26,7 +102,27 @@ namespace tarsier {
             _minimum_number_of_events(minimum_number_of_events),
             _event_to_flow(std::forward<EventToFlow>(event_to_flow)),
             _handle_flow(std::forward<HandleFlow>(handle_flow)),
-            _ts(width * height, 0) {}
+            _active_events(width, height),
+            _emission(std::move(emission)) {}
+        compute_flow(
+            ActiveEvents active_events,
+            uint16_t spatial_window,
+            uint64_t temporal_window,
+            std::size_t minimum_number_of_events,
+            EventToFlow event_to_flow,
+            HandleFlow handle_flow,
+            Emission emission = Emission()) :
+            _width(active_events.width()),
+            _height(active_events.height()),
+            _spatial_window(spatial_window),
+            _temporal_window(temporal_window),
+            _minimum_number_of_events(minimum_number_of_events),
+            _event_to_flow(std::forward<EventToFlow>(event_to_flow)),
+            _handle_flow(std::forward<HandleFlow>(handle_flow)),
+            _active_events(std::forward<ActiveEvents>(active_events)),
+            _emission(std::move(emission)) {
+            check_window<ActiveEvents>(spatial_window);
+        }
         compute_flow(const compute_flow&) = delete;
         compute_flow(compute_flow&&) = default;
         compute_flow& operator=(const compute_flow&) = delete;
@@ -35,71 +131,51 @@ namespace tarsier {
 
         /// operator() handles an event.
         virtual void operator()(Event event) {
-            _ts[event.x + event.y * _width] = event.t;
+            if (!std::is_reference<ActiveEvents>::value) {
+                _active_events.update(event);
+            }
+            if (!_emission.due(event)) {
+                return;
+            }
             const auto t_threshold = (event.t <= _temporal_window ? 0 : event.t - _temporal_window);
-            std::vector<point> points;
-            for (uint16_t y = (event.y <= _spatial_window ? 0 : event.y - _spatial_window);
-                 y <= (event.y >= _height - 1 - _spatial_window ? _height - 1 : event.y + _spatial_window);
-                 ++y) {
-                for (uint16_t x = (event.x <= _spatial_window ? 0 : event.x - _spatial_window);
-                     x <= (event.x >= _width - 1 - _spatial_window ? _width - 1 : event.x + _spatial_window);
-                     ++x) {
-                    const auto t = _ts[x + y * _width];
+            plane_fit fit;
+            const auto y_last = window_last<ActiveEvents>(event.y, _spatial_window, _height);
+            const auto x_first = window_first<ActiveEvents>(event.x, _spatial_window);
+            const auto x_last = window_last<ActiveEvents>(event.x, _spatial_window, _width);
+            for (auto y = window_first<ActiveEvents>(event.y, _spatial_window); y <= y_last; ++y) {
+                for (auto x = x_first; x <= x_last; ++x) {
+                    const auto t = _active_events.t(x, y);
                     if (t > t_threshold) {
-                        points.push_back(point{
-                            static_cast<float>(t),
-                            static_cast<float>(x),
-                            static_cast<float>(y),
-                        });
+                        fit.add(
+                            -static_cast<float>(event.t - t),
+                            static_cast<float>(x) - event.x,
+                            static_cast<float>(y) - event.y);
                     }
                 }
             }
-            if (points.size() >= _minimum_number_of_events) {
-                auto t_mean = 0.0f;
-                auto x_mean = 0.0f;
-                auto y_mean = 0.0f;
-                for (auto point : points) {
-                    t_mean += point.t;
-                    x_mean += point.x;
-                    y_mean += point.y;
+            if (fit.count() >= _minimum_number_of_events) {
+                float vx;
+                float vy;
+                fit.velocity(vx, vy);
+                if (_emission.emit(vx, vy)) {
+                    _handle_flow(_event_to_flow(event, vx, vy));
                 }
-                t_mean /= points.size();
-                x_mean /= points.size();
-                y_mean /= points.size();
-                auto tx_sum = 0.0f;
-                auto ty_sum = 0.0f;
-                auto xx_sum = 0.0f;
-                auto xy_sum = 0.0f;
-                auto yy_sum = 0.0f;
-                for (auto point : points) {
-                    const auto t_delta = point.t - t_mean;
-                    const auto x_delta = point.x - x_mean;
-                    const auto y_delta = point.y - y_mean;
-                    tx_sum += t_delta * x_delta;
-                    ty_sum += t_delta * y_delta;
-                    xx_sum += x_delta * x_delta;
-                    xy_sum += x_delta * y_delta;
-                    yy_sum += y_delta * y_delta;
-                }
-                const auto t_determinant = xx_sum * yy_sum - xy_sum * xy_sum;
-                const auto x_determinant = tx_sum * yy_sum - ty_sum * xy_sum;
-                const auto y_determinant = ty_sum * xx_sum - tx_sum * xy_sum;
-                const auto inverse_squares_sum = 1.0f / (x_determinant * x_determinant + y_determinant * y_determinant);
-                _handle_flow(_event_to_flow(
-                    event,
-                    t_determinant * x_determinant * inverse_squares_sum,
-                    t_determinant * y_determinant * inverse_squares_sum));
             }
         }
 
-        protected:
-        /// point represents a point in xyt space.
-        struct point {
-            float t;
-            float x;
-            float y;
-        } __attribute__((packed));
+        /// save_state writes the timestamps map to a stream.
+        void save_state(std::ostream& stream) const {
+            write_state_header(stream, "compute_flow");
+            _active_events.write_state_sections(stream);
+        }
+
+        /// load_state reads the timestamps map written by save_state.
+        void load_state(std::istream& stream) {
+            read_state_header(stream, "compute_flow");
+            _active_events.read_state_sections(stream);
+        }
 
+        protected:
         const uint16_t _width;
         const uint16_t _height;
         const uint16_t _spatial_window;
@@ -107,26 +183,64 @@ namespace tarsier {
         const std::size_t _minimum_number_of_events;
         EventToFlow _event_to_flow;
         HandleFlow _handle_flow;
-        std::vector<uint64_t> _ts;
+        ActiveEvents _active_events;
+        Emission _emission;
     };
 
     /// make_compute_flow creates an optical flow estimator from functors.
-    template <typename Event, typename Flow, typename EventToFlow, typename HandleFlow>
-    compute_flow<Event, Flow, EventToFlow, HandleFlow> make_compute_flow(
+    template <
+        typename Event,
+        typename Flow,
+        typename EventToFlow,
+        typename HandleFlow,
+        typename Emission = emit_always>
+    compute_flow<Event, Flow, EventToFlow, HandleFlow, active_events<void>, Emission> make_compute_flow(
         uint16_t width,
         uint16_t height,
         uint16_t spatial_window,
         uint64_t temporal_window,
         std::size_t minimum_number_of_events,
         EventToFlow EventToflow,
-        HandleFlow handle_flow) {
-        return compute_flow<Event, Flow, EventToFlow, HandleFlow>(
+        HandleFlow handle_flow,
+        Emission emission = Emission()) {
+        return compute_flow<Event, Flow, EventToFlow, HandleFlow, active_events<void>, Emission>(
             width,
             height,
             spatial_window,
             temporal_window,
             minimum_number_of_events,
             std::forward<EventToFlow>(EventToflow),
-            std::forward<HandleFlow>(handle_flow));
+            std::forward<HandleFlow>(handle_flow),
+            std::move(emission));
+    }
+
+    /// make_compute_flow creates an optical flow estimator from active events and functors.
+    /// An lvalue active_events is shared (the handler keeps a reference), an rvalue is moved into the handler.
+    /// Arithmetic first arguments are rejected so that calls with a width, a height and an emission policy resolve
+    /// to the other overload.
+    template <
+        typename Event,
+        typename Flow,
+        typename ActiveEvents,
+        typename EventToFlow,
+        typename HandleFlow,
+        typename Emission = emit_always,
+        typename = typename std::enable_if<!std::is_arithmetic<typename std::decay<ActiveEvents>::type>::value>::type>
+    compute_flow<Event, Flow, EventToFlow, HandleFlow, ActiveEvents, Emission> make_compute_flow(
+        ActiveEvents&& active_events,
+        uint16_t spatial_window,
+        uint64_t temporal_window,
+        std::size_t minimum_number_of_events,
+        EventToFlow event_to_flow,
+        HandleFlow handle_flow,
+        Emission emission = Emission()) {
+        return compute_flow<Event, Flow, EventToFlow, HandleFlow, ActiveEvents, Emission>(
+            std::forward<ActiveEvents>(active_events),
+            spatial_window,
+            temporal_window,
+            minimum_number_of_events,
+            std::forward<EventToFlow>(event_to_flow),
+            std::forward<HandleFlow>(handle_flow),
+            std::move(emission));
     }
 }
@@ -0,0 +1,156 @@
+#pragma once
+
+#include "compute_flow.hpp"
+#include <cmath>
+#include <cstdint>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+/// tarsier is a collection of event handlers.
+namespace tarsier {
+    /// compute_flow_pyramid evaluates the optical flow on a pyramid of timestamp maps.
+    /// The level n map stores the most recent timestamp of each 2^n x 2^n pixels cell.
+    /// The plane is first fitted on the coarsest level with at least minimum_number_of_events in the spatial window.
+    /// The estimate is then refined at finer levels as long as the motion takes at least minimum_crossing_time to
+    /// cross the finer window, and the finer window has enough events. Fast motions are thus estimated with a wide
+    /// aperture, at the cost of a small window. The fit is that of compute_flow, hence a single-level pyramid
+    /// yields the same flow events as compute_flow.
+    template <typename Event, typename Flow, typename EventToFlow, typename HandleFlow>
+    class compute_flow_pyramid {
+        public:
+        compute_flow_pyramid(
+            uint16_t width,
+            uint16_t height,
+            uint8_t levels,
+            uint16_t spatial_window,
+            uint64_t temporal_window,
+            std::size_t minimum_number_of_events,
+            uint64_t minimum_crossing_time,
+            EventToFlow event_to_flow,
+            HandleFlow handle_flow) :
+            _spatial_window(spatial_window),
+            _temporal_window(temporal_window),
+            _minimum_number_of_events(minimum_number_of_events),
+            _minimum_crossing_time(static_cast<float>(minimum_crossing_time)),
+            _event_to_flow(std::forward<EventToFlow>(event_to_flow)),
+            _handle_flow(std::forward<HandleFlow>(handle_flow)) {
+            if (levels == 0 || levels > 16) {
+                throw std::logic_error("levels must be in the range [1, 16]");
+            }
+            for (uint8_t level = 0; level < levels; ++level) {
+                const uint16_t level_width = static_cast<uint16_t>(((width - 1) >> level) + 1);
+                const uint16_t level_height = static_cast<uint16_t>(((height - 1) >> level) + 1);
+                _widths.push_back(level_width);
+                _heights.push_back(level_height);
+                _tss.emplace_back(static_cast<std::size_t>(level_width) * level_height, 0);
+            }
+        }
+        compute_flow_pyramid(const compute_flow_pyramid&) = delete;
+        compute_flow_pyramid(compute_flow_pyramid&&) = default;
+        compute_flow_pyramid& operator=(const compute_flow_pyramid&) = delete;
+        compute_flow_pyramid& operator=(compute_flow_pyramid&&) = default;
+        virtual ~compute_flow_pyramid() {}
+
+        /// operator() handles an event.
+        virtual void operator()(Event event) {
+            for (std::size_t level = 0; level < _tss.size(); ++level) {
+                _tss[level][(event.x >> level) + (event.y >> level) * _widths[level]] = event.t;
+            }
+            auto level = _tss.size();
+            float vx = 0;
+            float vy = 0;
+            do {
+                --level;
+                if (fit(event, level, vx, vy)) {
+                    while (level > 0) {
+                        const auto crossing_distance = static_cast<float>(_spatial_window << (level - 1));
+                        if (crossing_distance * crossing_distance
+                            < _minimum_crossing_time * _minimum_crossing_time * (vx * vx + vy * vy)) {
+                            break;
+                        }
+                        float finer_vx = 0;
+                        float finer_vy = 0;
+                        if (!fit(event, level - 1, finer_vx, finer_vy)) {
+                            break;
+                        }
+                        vx = finer_vx;
+                        vy = finer_vy;
+                        --level;
+                    }
+                    _handle_flow(_event_to_flow(event, vx, vy));
+                    return;
+                }
+            } while (level > 0);
+        }
+
+        protected:
+        /// fit estimates the flow at the given level, and returns false if there are not enough events.
+        /// The velocity is expressed in pixels per timestamp unit.
+        bool fit(Event event, std::size_t level, float& vx, float& vy) const {
+            const auto width = _widths[level];
+            const auto height = _heights[level];
+            const auto& ts = _tss[level];
+            const uint16_t event_x = event.x >> level;
+            const uint16_t event_y = event.y >> level;
+            const auto t_threshold = (event.t <= _temporal_window ? 0 : event.t - _temporal_window);
+            plane_fit plane;
+            for (uint16_t y = (event_y <= _spatial_window ? 0 : event_y - _spatial_window);
+                 y <= (event_y >= height - 1 - _spatial_window ? height - 1 : event_y + _spatial_window);
+                 ++y) {
+                for (uint16_t x = (event_x <= _spatial_window ? 0 : event_x - _spatial_window);
+                     x <= (event_x >= width - 1 - _spatial_window ? width - 1 : event_x + _spatial_window);
+                     ++x) {
+                    const auto t = ts[x + y * width];
+                    if (t > t_threshold) {
+                        plane.add(
+                            -static_cast<float>(event.t - t),
+                            static_cast<float>(x) - event_x,
+                            static_cast<float>(y) - event_y);
+                    }
+                }
+            }
+            if (plane.count() < _minimum_number_of_events || plane.count() == 0) {
+                return false;
+            }
+            plane.velocity(vx, vy);
+            vx *= static_cast<float>(1 << level);
+            vy *= static_cast<float>(1 << level);
+            return true;
+        }
+
+        const uint16_t _spatial_window;
+        const uint64_t _temporal_window;
+        const std::size_t _minimum_number_of_events;
+        const float _minimum_crossing_time;
+        EventToFlow _event_to_flow;
+        HandleFlow _handle_flow;
+        std::vector<uint16_t> _widths;
+        std::vector<uint16_t> _heights;
+        std::vector<std::vector<uint64_t>> _tss;
+    };
+
+    /// make_compute_flow_pyramid creates a compute_flow_pyramid from functors.
+    template <typename Event, typename Flow, typename EventToFlow, typename HandleFlow>
+    compute_flow_pyramid<Event, Flow, EventToFlow, HandleFlow> make_compute_flow_pyramid(
+        uint16_t width,
+        uint16_t height,
+        uint8_t levels,
+        uint16_t spatial_window,
+        uint64_t temporal_window,
+        std::size_t minimum_number_of_events,
+        uint64_t minimum_crossing_time,
+        EventToFlow event_to_flow,
+        HandleFlow handle_flow) {
+        return compute_flow_pyramid<Event, Flow, EventToFlow, HandleFlow>(
+            width,
+            height,
+            levels,
+            spatial_window,
+            temporal_window,
+            minimum_number_of_events,
+            minimum_crossing_time,
+            std::forward<EventToFlow>(event_to_flow),
+            std::forward<HandleFlow>(handle_flow));
+    }
+}
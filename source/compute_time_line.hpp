@@ -1 +1,210 @@
 #pragma once
+
+#include "allocators.hpp"
+#include "state.hpp"
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <utility>
+#include <vector>
+
+/// tarsier is a collection of event handlers.
+namespace tarsier {
+    /// time_line_polarities stores the polarities of a pixel's time line.
+    template <typename Polarity, std::size_t length>
+    struct time_line_polarities {
+        Polarity values[length];
+
+        /// set stores an event's polarity.
+        template <typename Event>
+        void set(std::size_t slot, Event event) {
+            values[slot] = event.polarity;
+        }
+
+        /// get returns a stored polarity.
+        Polarity get(std::size_t slot) const {
+            return values[slot];
+        }
+    };
+
+    /// time_line_polarities is empty for events without polarity.
+    template <std::size_t length>
+    struct time_line_polarities<void, length> {
+        /// set ignores the event.
+        template <typename Event>
+        void set(std::size_t, Event) {}
+    };
+
+    /// time_line_storage holds the fields of a pixel_time_line.
+    /// intervals[slot] is the time elapsed between the event in slot and the previous one, saturated to 2^32 - 1
+    /// microseconds.
+    template <typename Polarity, std::size_t length>
+    struct time_line_storage {
+        uint64_t t;
+        uint32_t intervals[length];
+        time_line_polarities<Polarity, length> polarities;
+        uint8_t head;
+        uint8_t size;
+    };
+
+    /// time_line_alignment returns the smallest power of two larger than or equal to size, capped to a cache line.
+    constexpr std::size_t time_line_alignment(std::size_t size, std::size_t alignment = 1) {
+        return alignment >= cache_line_size || alignment >= size ? alignment :
+                                                                   time_line_alignment(size, alignment * 2);
+    }
+
+    /// pixel_time_line stores the length most recent timestamps (and polarities) of a pixel, in a ring.
+    /// The latest timestamp is absolute, and the others are stored as 32-bit intervals. A pixel_time_line is
+    /// aligned so that it does not straddle two cache lines when it fits in one (for instance, length up to 10
+    /// with bool polarities).
+    template <typename Polarity, std::size_t length>
+    class alignas(time_line_alignment(sizeof(time_line_storage<Polarity, length>))) pixel_time_line {
+        public:
+        static_assert(length > 0 && length <= 255, "length must be in the range [1, 255] (size is stored on 8 bits)");
+
+        pixel_time_line() : _storage() {}
+
+        /// update adds an event to the time line, replacing the oldest one if the ring is full.
+        template <typename Event>
+        void update(Event event) {
+            const auto slot = _storage.size == 0 ? 0 : (_storage.head + 1) % length;
+            if (_storage.size == 0 || event.t - _storage.t > std::numeric_limits<uint32_t>::max()) {
+                _storage.intervals[slot] = std::numeric_limits<uint32_t>::max();
+            } else {
+                _storage.intervals[slot] = static_cast<uint32_t>(event.t - _storage.t);
+            }
+            _storage.polarities.set(slot, event);
+            _storage.t = event.t;
+            _storage.head = static_cast<uint8_t>(slot);
+            if (_storage.size < length) {
+                ++_storage.size;
+            }
+        }
+
+        /// size returns the number of events in the time line (at most length).
+        std::size_t size() const {
+            return _storage.size;
+        }
+
+        /// t returns the timestamp of an event, 0 being the most recent one.
+        /// The timestamps are exact unless an interval was saturated, in which case they are upper bounds.
+        uint64_t t(std::size_t index) const {
+            auto t = _storage.t;
+            for (std::size_t offset = 0; offset < index; ++offset) {
+                const auto interval = _storage.intervals[slot(offset)];
+                if (interval >= t) {
+                    return 0;
+                }
+                t -= interval;
+            }
+            return t;
+        }
+
+        /// interval returns the time elapsed between the events index + 1 and index (0 being the most recent
+        /// event), saturated to 2^32 - 1 microseconds. index must be smaller than size() - 1.
+        uint32_t interval(std::size_t index) const {
+            return _storage.intervals[slot(index)];
+        }
+
+        /// polarity returns the polarity of an event, 0 being the most recent one.
+        Polarity polarity(std::size_t index) const {
+            return _storage.polarities.get(slot(index));
+        }
+
+        protected:
+        /// slot returns the position of an event in the ring.
+        std::size_t slot(std::size_t index) const {
+            return (_storage.head + length - index) % length;
+        }
+
+        time_line_storage<Polarity, length> _storage;
+    };
+
+    /// compute_time_line keeps the length most recent events of each pixel, and emits a pixel's time line for each
+    /// event. The time lines are stored contiguously (one pixel_time_line per pixel), so that reading a pixel's
+    /// history costs a single cache line for small lengths. Use void as Polarity to store timestamps only.
+    /// Allocator (rebound to the pixel type) can be one of the allocators in allocators.hpp.
+    template <
+        typename Event,
+        typename Polarity,
+        typename TimeLine,
+        std::size_t length,
+        typename EventToTimeLine,
+        typename HandleTimeLine,
+        typename Allocator = aligned_allocator<uint64_t>>
+    class compute_time_line {
+        public:
+        typedef typename std::allocator_traits<Allocator>::template rebind_alloc<pixel_time_line<Polarity, length>>
+            pixel_allocator;
+
+        compute_time_line(
+            uint16_t width,
+            uint16_t height,
+            EventToTimeLine event_to_time_line,
+            HandleTimeLine handle_time_line,
+            Allocator allocator = Allocator()) :
+            _width(width),
+            _event_to_time_line(std::forward<EventToTimeLine>(event_to_time_line)),
+            _handle_time_line(std::forward<HandleTimeLine>(handle_time_line)),
+            _time_lines(
+                static_cast<std::size_t>(width) * height,
+                pixel_time_line<Polarity, length>(),
+                pixel_allocator(std::move(allocator))) {}
+        compute_time_line(const compute_time_line&) = delete;
+        compute_time_line(compute_time_line&&) = default;
+        compute_time_line& operator=(const compute_time_line&) = delete;
+        compute_time_line& operator=(compute_time_line&&) = default;
+        virtual ~compute_time_line() {}
+
+        /// operator() handles an event.
+        virtual void operator()(Event event) {
+            auto& time_line = _time_lines[event.x + event.y * static_cast<std::size_t>(_width)];
+            time_line.update(event);
+            _handle_time_line(_event_to_time_line(event, time_line));
+        }
+
+        /// time_line returns the time line of the given pixel.
+        const pixel_time_line<Polarity, length>& time_line(uint16_t x, uint16_t y) const {
+            return _time_lines[x + y * static_cast<std::size_t>(_width)];
+        }
+
+        /// save_state writes the time lines to a stream.
+        void save_state(std::ostream& stream) const {
+            write_state_header(stream, "compute_time_line");
+            write_state_section(stream, _time_lines);
+        }
+
+        /// load_state reads the time lines written by save_state.
+        void load_state(std::istream& stream) {
+            read_state_header(stream, "compute_time_line");
+            auto time_lines = read_state_copy(stream, _time_lines);
+            _time_lines.swap(time_lines);
+        }
+
+        protected:
+        const uint16_t _width;
+        EventToTimeLine _event_to_time_line;
+        HandleTimeLine _handle_time_line;
+        std::vector<pixel_time_line<Polarity, length>, pixel_allocator> _time_lines;
+    };
+
+    /// make_compute_time_line creates a compute_time_line from functors.
+    template <
+        typename Event,
+        typename Polarity,
+        typename TimeLine,
+        std::size_t length,
+        typename EventToTimeLine,
+        typename HandleTimeLine>
+    compute_time_line<Event, Polarity, TimeLine, length, EventToTimeLine, HandleTimeLine> make_compute_time_line(
+        uint16_t width,
+        uint16_t height,
+        EventToTimeLine event_to_time_line,
+        HandleTimeLine handle_time_line) {
+        return compute_time_line<Event, Polarity, TimeLine, length, EventToTimeLine, HandleTimeLine>(
+            width,
+            height,
+            std::forward<EventToTimeLine>(event_to_time_line),
+            std::forward<HandleTimeLine>(handle_time_line));
+    }
+}
@@ -1,21 +1,29 @@
 #pragma once
 
+#include "active_events.hpp"
+#include "snapshot.hpp"
+#include "state.hpp"
 #include <array>
 #include <cmath>
 #include <cstdint>
+#include <type_traits>
 #include <utility>
 #include <vector>
 
 /// tarsier is a collection of event handlers.
 namespace tarsier {
     /// compute_time_surface extracts time surfaces from events.
+    /// When ActiveEvents is a reference, the timestamps and polarities are shared with other handlers and must be
+    /// updated before each event reaches compute_time_surface (see update_active_events). Otherwise,
+    /// compute_time_surface owns and updates them.
     template <
         typename Event,
         typename Polarity,
         typename TimeSurface,
         uint16_t spatial_window,
         typename EventToTimeSurface,
-        typename HandleTimeSurface>
+        typename HandleTimeSurface,
+        typename ActiveEvents = active_events<Polarity>>
     class compute_time_surface {
         public:
         compute_time_surface(
@@ -31,7 +39,28 @@ namespace tarsier {
             _decay(decay),
             _event_to_time_surface(std::forward<EventToTimeSurface>(event_to_time_surface)),
             _handle_time_surface(std::forward<HandleTimeSurface>(handle_time_surface)),
-            _ts_and_polarities(width * height, {0, false}) {}
+            _active_events(width, height),
+            _snapshot(nullptr),
+            _period(0),
+            _next_publication_t(0) {}
+        compute_time_surface(
+            ActiveEvents active_events,
+            uint64_t temporal_window,
+            float decay,
+            EventToTimeSurface event_to_time_surface,
+            HandleTimeSurface handle_time_surface) :
+            _width(active_events.width()),
+            _height(active_events.height()),
+            _temporal_window(temporal_window),
+            _decay(decay),
+            _event_to_time_surface(std::forward<EventToTimeSurface>(event_to_time_surface)),
+            _handle_time_surface(std::forward<HandleTimeSurface>(handle_time_surface)),
+            _active_events(std::forward<ActiveEvents>(active_events)),
+            _snapshot(nullptr),
+            _period(0),
+            _next_publication_t(0) {
+            check_window<ActiveEvents>(spatial_window);
+        }
         compute_time_surface(const compute_time_surface&) = delete;
         compute_time_surface(compute_time_surface&&) = default;
         compute_time_surface& operator=(const compute_time_surface&) = delete;
@@ -40,40 +69,78 @@ namespace tarsier {
 
         /// operator() handles an event.
         virtual void operator()(Event event) {
-            {
-                const auto index = event.x + event.y * _width;
-                _ts_and_polarities[index].first = event.t;
-                _ts_and_polarities[index].second = event.polarity;
+            if (!std::is_reference<ActiveEvents>::value) {
+                _active_events.update(event);
+            }
+            if (_snapshot != nullptr && event.t >= _next_publication_t) {
+                publish();
+                _next_publication_t = event.t + _period;
             }
             const auto t_threshold = (event.t <= _temporal_window ? 0 : event.t - _temporal_window);
             std::array<std::pair<float, Polarity>, (spatial_window * 2 + 1) * (spatial_window * 2 + 1)>
                 projections_and_polarities;
-            for (uint16_t y = (event.y <= spatial_window ? 0 : event.y - spatial_window);
-                 y <= (event.y >= _height - 1 - spatial_window ? _height - 1 : event.y + spatial_window);
-                 ++y) {
-                for (uint16_t x = (event.x <= spatial_window ? 0 : event.x - spatial_window);
-                     x <= (event.x >= _width - 1 - spatial_window ? _width - 1 : event.x + spatial_window);
-                     ++x) {
-                    const auto t_and_polarity = _ts_and_polarities[x + y * _width];
-                    if (t_and_polarity.first > t_threshold) {
+            const auto y_last = window_last<ActiveEvents>(event.y, spatial_window, _height);
+            const auto x_first = window_first<ActiveEvents>(event.x, spatial_window);
+            const auto x_last = window_last<ActiveEvents>(event.x, spatial_window, _width);
+            for (auto y = window_first<ActiveEvents>(event.y, spatial_window); y <= y_last; ++y) {
+                for (auto x = x_first; x <= x_last; ++x) {
+                    const auto t = _active_events.t(x, y);
+                    if (t > t_threshold) {
                         projections_and_polarities
                             [x + spatial_window - event.x + (y + spatial_window - event.y) * (2 * spatial_window + 1)] =
-                                {std::exp(-static_cast<float>(event.t - t_and_polarity.first) / _decay),
-                                 t_and_polarity.second};
+                                {std::exp(-static_cast<float>(event.t - t) / _decay), _active_events.polarity(x, y)};
                     }
                 }
             }
             _handle_time_surface(_event_to_time_surface(event, projections_and_polarities));
         }
 
+        /// publish_to makes a copy of the timestamps and polarities map (row-major) available to another thread at
+        /// most once every period (event time).
+        void publish_to(
+            snapshot<std::vector<std::pair<uint64_t, Polarity>>>& ts_and_polarities_snapshot,
+            uint64_t period) {
+            _snapshot = &ts_and_polarities_snapshot;
+            _period = period;
+            _next_publication_t = 0;
+        }
+
+        /// save_state writes the timestamps and polarities map to a stream.
+        void save_state(std::ostream& stream) const {
+            write_state_header(stream, "compute_time_surface");
+            _active_events.write_state_sections(stream);
+        }
+
+        /// load_state reads the timestamps and polarities map written by save_state.
+        void load_state(std::istream& stream) {
+            read_state_header(stream, "compute_time_surface");
+            _active_events.read_state_sections(stream);
+        }
+
         protected:
+        /// publish copies the map to the snapshot.
+        void publish() {
+            auto& ts_and_polarities = _snapshot->back();
+            ts_and_polarities.resize(static_cast<std::size_t>(_width) * _height);
+            for (uint16_t y = 0; y < _height; ++y) {
+                for (uint16_t x = 0; x < _width; ++x) {
+                    ts_and_polarities[x + y * static_cast<std::size_t>(_width)] = {
+                        _active_events.t(x, y), _active_events.polarity(x, y)};
+                }
+            }
+            _snapshot->publish();
+        }
+
         const uint16_t _width;
         const uint16_t _height;
         const uint64_t _temporal_window;
         const float _decay;
         EventToTimeSurface _event_to_time_surface;
         HandleTimeSurface _handle_time_surface;
-        std::vector<std::pair<uint64_t, Polarity>> _ts_and_polarities;
+        ActiveEvents _active_events;
+        snapshot<std::vector<std::pair<uint64_t, Polarity>>>* _snapshot;
+        uint64_t _period;
+        uint64_t _next_publication_t;
     };
 
     /// make_compute_time_surface creates a compute_time_surface from functors.
@@ -106,4 +173,43 @@ namespace tarsier {
             std::forward<EventToTimeSurface>(event_to_time_surface),
             std::forward<HandleTimeSurface>(handle_time_surface));
     }
+
+    /// make_compute_time_surface creates a compute_time_surface from active events and functors.
+    /// An lvalue active_events is shared (the handler keeps a reference), an rvalue is moved into the handler.
+    template <
+        typename Event,
+        typename Polarity,
+        typename TimeSurface,
+        uint16_t spatial_window,
+        typename ActiveEvents,
+        typename EventToTimeSurface,
+        typename HandleTimeSurface>
+    compute_time_surface<
+        Event,
+        Polarity,
+        TimeSurface,
+        spatial_window,
+        EventToTimeSurface,
+        HandleTimeSurface,
+        ActiveEvents>
+    make_compute_time_surface(
+        ActiveEvents&& active_events,
+        uint64_t temporal_window,
+        float decay,
+        EventToTimeSurface event_to_time_surface,
+        HandleTimeSurface handle_time_surface) {
+        return compute_time_surface<
+            Event,
+            Polarity,
+            TimeSurface,
+            spatial_window,
+            EventToTimeSurface,
+            HandleTimeSurface,
+            ActiveEvents>(
+            std::forward<ActiveEvents>(active_events),
+            temporal_window,
+            decay,
+            std::forward<EventToTimeSurface>(event_to_time_surface),
+            std::forward<HandleTimeSurface>(handle_time_surface));
+    }
 }
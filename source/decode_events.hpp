@@ -0,0 +1,94 @@
+#pragma once
+
+#include <cstdint>
+#include <stdexcept>
+#include <utility>
+
+/// tarsier is a collection of event handlers.
+namespace tarsier {
+    /// decode_events reads blocks written by encode_events, and propagates the events.
+    /// Event must be an aggregate initialisable with {t, x, y}.
+    template <typename Event, typename HandleEvent>
+    class decode_events {
+        public:
+        decode_events(HandleEvent handle_event) :
+            _handle_event(std::forward<HandleEvent>(handle_event)),
+            _t(0),
+            _x(0),
+            _y(0) {}
+        decode_events(const decode_events&) = delete;
+        decode_events(decode_events&&) = default;
+        decode_events& operator=(const decode_events&) = delete;
+        decode_events& operator=(decode_events&&) = default;
+        virtual ~decode_events() {}
+
+        /// operator() handles a block of bytes.
+        virtual void operator()(const uint8_t* data, std::size_t size) {
+            const auto end = data + size;
+            _t = 0;
+            _x = 0;
+            _y = 0;
+            while (data != end) {
+                data = decode(data, end);
+            }
+        }
+
+        protected:
+        /// unzigzag maps zigzag-encoded integers back to signed integers.
+        static int32_t unzigzag(uint64_t value) {
+            return static_cast<int32_t>(static_cast<uint32_t>(value >> 1) ^ (0u - static_cast<uint32_t>(value & 1)));
+        }
+
+        /// read reads a varint.
+        static const uint8_t* read(const uint8_t* data, const uint8_t* end, uint64_t& value) {
+            if (data != end && *data < 0x80) {
+                value = *data;
+                return data + 1;
+            }
+            value = 0;
+            for (uint8_t shift = 0;; shift += 7) {
+                if (data == end || shift > 63) {
+                    throw std::runtime_error("the block is truncated or corrupted");
+                }
+                value |= static_cast<uint64_t>(*data & 0x7f) << shift;
+                ++data;
+                if ((*(data - 1) & 0x80) == 0) {
+                    return data;
+                }
+            }
+        }
+
+        /// decode reads one event.
+        const uint8_t* decode(const uint8_t* data, const uint8_t* end) {
+            uint64_t t_value;
+            uint64_t x_value;
+            uint64_t y_value = 0;
+            data = read(data, end, t_value);
+            data = read(data, end, x_value);
+            if ((x_value & 1) == 1) {
+                data = read(data, end, y_value);
+            }
+            handle(t_value, x_value, y_value);
+            return data;
+        }
+
+        /// handle applies the deltas and propagates the event.
+        void handle(uint64_t t_value, uint64_t x_value, uint64_t y_value) {
+            _t += t_value;
+            _x += unzigzag(x_value >> 1);
+            _y += unzigzag(y_value);
+            _handle_event(Event{_t, static_cast<uint16_t>(_x), static_cast<uint16_t>(_y)});
+        }
+
+        HandleEvent _handle_event;
+        uint64_t _t;
+        int32_t _x;
+        int32_t _y;
+    };
+
+    /// make_decode_events creates a decode_events from a functor.
+    template <typename Event, typename HandleEvent>
+    decode_events<Event, HandleEvent> make_decode_events(HandleEvent handle_event) {
+        return decode_events<Event, HandleEvent>(std::forward<HandleEvent>(handle_event));
+    }
+}
@@ -0,0 +1,163 @@
+#pragma once
+
+#include "state.hpp"
+#include <cmath>
+#include <cstdint>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+/// tarsier is a collection of event handlers.
+namespace tarsier {
+    /// detect_frequency estimates the blinking frequency of each pixel, and emits frequency events for the pixels
+    /// whose period is stable.
+    /// Each pixel stores the timestamp of its latest transition to each polarity (the first event after an event
+    /// with the other polarity). The interval between two transitions to the same polarity is a period sample.
+    /// Samples within tolerance (relative) of the pixel's filtered period update it with an exponential filter of
+    /// weight filter_weight, and other samples restart the filter. Once minimum_number_of_samples consecutive
+    /// samples agree, each sample triggers event_to_frequency_event(event, frequency) with the frequency in Hz
+    /// (timestamps in microseconds). Samples outside [minimum_frequency, maximum_frequency] reset the pixel. The
+    /// cost per event does not depend on the scene.
+    template <typename Event, typename FrequencyEvent, typename EventToFrequencyEvent, typename HandleFrequencyEvent>
+    class detect_frequency {
+        public:
+        detect_frequency(
+            uint16_t width,
+            uint16_t height,
+            float minimum_frequency,
+            float maximum_frequency,
+            float tolerance,
+            float filter_weight,
+            uint8_t minimum_number_of_samples,
+            EventToFrequencyEvent event_to_frequency_event,
+            HandleFrequencyEvent handle_frequency_event) :
+            _width(width),
+            _minimum_period(1e6f / maximum_frequency),
+            _maximum_period(1e6f / minimum_frequency),
+            _tolerance(tolerance),
+            _filter_weight(filter_weight),
+            _minimum_number_of_samples(minimum_number_of_samples),
+            _event_to_frequency_event(std::forward<EventToFrequencyEvent>(event_to_frequency_event)),
+            _handle_frequency_event(std::forward<HandleFrequencyEvent>(handle_frequency_event)),
+            _pixels(static_cast<std::size_t>(width) * height, pixel{{0, 0}, 0.0f, unknown_polarity, 0}) {
+            if (minimum_frequency <= 0.0f || minimum_frequency > maximum_frequency) {
+                throw std::logic_error(
+                    "minimum_frequency must be larger than zero and smaller than or equal to maximum_frequency");
+            }
+            if (tolerance < 0.0f) {
+                throw std::logic_error("tolerance must be positive");
+            }
+            if (filter_weight <= 0.0f || filter_weight > 1.0f) {
+                throw std::logic_error("filter_weight must be in the range ]0, 1]");
+            }
+        }
+        detect_frequency(const detect_frequency&) = delete;
+        detect_frequency(detect_frequency&&) = default;
+        detect_frequency& operator=(const detect_frequency&) = delete;
+        detect_frequency& operator=(detect_frequency&&) = default;
+        virtual ~detect_frequency() {}
+
+        /// operator() handles an event.
+        virtual void operator()(Event event) {
+            auto& pixel = _pixels[event.x + event.y * static_cast<std::size_t>(_width)];
+            const uint8_t polarity = event.polarity ? 1 : 0;
+            if (polarity == pixel.polarity) {
+                return;
+            }
+            pixel.polarity = polarity;
+            const auto previous_t = pixel.ts[polarity];
+            pixel.ts[polarity] = event.t;
+            if (previous_t == 0) {
+                return;
+            }
+            const auto period = static_cast<float>(event.t - previous_t);
+            if (period < _minimum_period || period > _maximum_period) {
+                pixel.period = 0.0f;
+                pixel.samples = 0;
+                return;
+            }
+            if (pixel.period > 0.0f && std::abs(period - pixel.period) <= _tolerance * pixel.period) {
+                pixel.period += _filter_weight * (period - pixel.period);
+                if (pixel.samples < _minimum_number_of_samples) {
+                    ++pixel.samples;
+                }
+            } else {
+                pixel.period = period;
+                pixel.samples = 1;
+            }
+            if (pixel.samples >= _minimum_number_of_samples) {
+                _handle_frequency_event(_event_to_frequency_event(event, 1e6f / pixel.period));
+            }
+        }
+
+        /// frequency returns the filtered frequency of the given pixel in Hz, or zero if it is not stable.
+        float frequency(uint16_t x, uint16_t y) const {
+            const auto& pixel = _pixels[x + y * static_cast<std::size_t>(_width)];
+            return pixel.samples >= _minimum_number_of_samples && pixel.period > 0.0f ? 1e6f / pixel.period : 0.0f;
+        }
+
+        /// save_state writes the transitions and periods to a stream.
+        void save_state(std::ostream& stream) const {
+            write_state_header(stream, "detect_frequency");
+            write_state_section(stream, _pixels);
+        }
+
+        /// load_state reads the transitions and periods written by save_state.
+        void load_state(std::istream& stream) {
+            read_state_header(stream, "detect_frequency");
+            auto pixels = read_state_copy(stream, _pixels);
+            _pixels.swap(pixels);
+        }
+
+        protected:
+        /// unknown_polarity marks pixels that have not received any event yet.
+        static constexpr uint8_t unknown_polarity = 2;
+
+        /// pixel stores the latest transition to each polarity, the filtered period and the number of consecutive
+        /// consistent samples of a pixel.
+        struct pixel {
+            uint64_t ts[2];
+            float period;
+            uint8_t polarity;
+            uint8_t samples;
+        };
+
+        const uint16_t _width;
+        const float _minimum_period;
+        const float _maximum_period;
+        const float _tolerance;
+        const float _filter_weight;
+        const uint8_t _minimum_number_of_samples;
+        EventToFrequencyEvent _event_to_frequency_event;
+        HandleFrequencyEvent _handle_frequency_event;
+        std::vector<pixel> _pixels;
+    };
+
+    template <typename Event, typename FrequencyEvent, typename EventToFrequencyEvent, typename HandleFrequencyEvent>
+    constexpr uint8_t detect_frequency<Event, FrequencyEvent, EventToFrequencyEvent, HandleFrequencyEvent>::
+        unknown_polarity;
+
+    /// make_detect_frequency creates a detect_frequency from functors.
+    template <typename Event, typename FrequencyEvent, typename EventToFrequencyEvent, typename HandleFrequencyEvent>
+    detect_frequency<Event, FrequencyEvent, EventToFrequencyEvent, HandleFrequencyEvent> make_detect_frequency(
+        uint16_t width,
+        uint16_t height,
+        float minimum_frequency,
+        float maximum_frequency,
+        float tolerance,
+        float filter_weight,
+        uint8_t minimum_number_of_samples,
+        EventToFrequencyEvent event_to_frequency_event,
+        HandleFrequencyEvent handle_frequency_event) {
+        return detect_frequency<Event, FrequencyEvent, EventToFrequencyEvent, HandleFrequencyEvent>(
+            width,
+            height,
+            minimum_frequency,
+            maximum_frequency,
+            tolerance,
+            filter_weight,
+            minimum_number_of_samples,
+            std::forward<EventToFrequencyEvent>(event_to_frequency_event),
+            std::forward<HandleFrequencyEvent>(handle_frequency_event));
+    }
+}
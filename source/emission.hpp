@@ -0,0 +1,117 @@
+#pragma once
+
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+/// tarsier is a collection of event handlers.
+namespace tarsier {
+    /// Emission policies decide which events trigger an output of a per-event handler (average_position,
+    /// compute_activity, compute_flow and track_blob). The handler updates its state on every event, then calls
+    /// due(event) before computing the output, and emit(values...) with the output values. The output conversion and
+    /// the handler call are skipped unless both return true. Batch operators call due for every event of the batch,
+    /// and split the batch after each due event, so that policies behave as with single events.
+
+    /// emit_always emits an output for every event.
+    class emit_always {
+        public:
+        /// due returns whether the event may trigger an output.
+        template <typename Event>
+        bool due(Event) {
+            return true;
+        }
+
+        /// emit returns whether the output must be propagated.
+        template <typename... Values>
+        bool emit(Values...) {
+            return true;
+        }
+    };
+
+    /// emit_every_events emits an output every number_of_events events.
+    /// If the handler cannot compute an output when due, it emits on the next event that yields one.
+    class emit_every_events {
+        public:
+        emit_every_events(std::size_t number_of_events) : _number_of_events(number_of_events), _count(0) {
+            if (number_of_events == 0) {
+                throw std::logic_error("number_of_events must be larger than zero");
+            }
+        }
+
+        /// due returns whether the event may trigger an output.
+        template <typename Event>
+        bool due(Event) {
+            ++_count;
+            return _count >= _number_of_events;
+        }
+
+        /// emit returns whether the output must be propagated.
+        template <typename... Values>
+        bool emit(Values...) {
+            _count = 0;
+            return true;
+        }
+
+        protected:
+        std::size_t _number_of_events;
+        std::size_t _count;
+    };
+
+    /// emit_every_duration emits an output at most once every duration microseconds (event time).
+    class emit_every_duration {
+        public:
+        emit_every_duration(uint64_t duration) : _duration(duration), _next_t(0), _t(0) {}
+
+        /// due returns whether the event may trigger an output.
+        template <typename Event>
+        bool due(Event event) {
+            _t = event.t;
+            return _t >= _next_t;
+        }
+
+        /// emit returns whether the output must be propagated.
+        template <typename... Values>
+        bool emit(Values...) {
+            _next_t = _t + _duration;
+            return true;
+        }
+
+        protected:
+        uint64_t _duration;
+        uint64_t _next_t;
+        uint64_t _t;
+    };
+
+    /// emit_on_change emits an output when a value differs from the last emitted one by more than threshold.
+    /// The values are compared regardless of the pixel that generated them.
+    class emit_on_change {
+        public:
+        emit_on_change(float threshold) : _threshold(threshold) {}
+
+        /// due returns whether the event may trigger an output.
+        template <typename Event>
+        bool due(Event) {
+            return true;
+        }
+
+        /// emit returns whether the output must be propagated.
+        template <typename... Values>
+        bool emit(Values... values) {
+            const std::array<float, sizeof...(Values)> current{{static_cast<float>(values)...}};
+            auto changed = _values.size() != current.size();
+            for (std::size_t index = 0; !changed && index < current.size(); ++index) {
+                changed = std::abs(current[index] - _values[index]) > _threshold;
+            }
+            if (changed) {
+                _values.assign(current.begin(), current.end());
+            }
+            return changed;
+        }
+
+        protected:
+        float _threshold;
+        std::vector<float> _values;
+    };
+}
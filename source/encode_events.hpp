@@ -0,0 +1,99 @@
+#pragma once
+
+#include <cstdint>
+#include <stdexcept>
+#include <utility>
+
+/// tarsier is a collection of event handlers.
+namespace tarsier {
+    /// maximum_encoded_event_size is the largest number of bytes used by encode_events for one event.
+    constexpr std::size_t maximum_encoded_event_size = 16;
+
+    /// encode_events writes the timestamp and coordinates of events as a compact byte stream.
+    /// Each event is encoded as LEB128 varints: the timestamp delta, then the zigzag-encoded x delta shifted left by
+    /// one bit, with the low bit set if the row changes, then (on row change only) the zigzag-encoded y delta.
+    /// Bursts of events on the same row typically use 2 bytes per event, other events 3 bytes.
+    /// The bytes are written to the given buffer, and handle_bytes(data, size) is called whenever it cannot hold
+    /// another event, or when flush is called. Each block is decoded independently (deltas restart from zero).
+    template <typename Event, typename HandleBytes>
+    class encode_events {
+        public:
+        encode_events(uint8_t* buffer, std::size_t size, HandleBytes handle_bytes) :
+            _buffer(buffer),
+            _end(buffer + size),
+            _handle_bytes(std::forward<HandleBytes>(handle_bytes)),
+            _position(buffer),
+            _t(0),
+            _x(0),
+            _y(0) {
+            if (size < maximum_encoded_event_size) {
+                throw std::logic_error("size must be at least maximum_encoded_event_size");
+            }
+        }
+        encode_events(const encode_events&) = delete;
+        encode_events(encode_events&&) = default;
+        encode_events& operator=(const encode_events&) = delete;
+        encode_events& operator=(encode_events&&) = default;
+        virtual ~encode_events() {}
+
+        /// operator() handles an event.
+        virtual void operator()(Event event) {
+            if (_end - _position < static_cast<std::ptrdiff_t>(maximum_encoded_event_size)) {
+                flush();
+            }
+            const uint16_t x = event.x;
+            const uint16_t y = event.y;
+            write(event.t - _t);
+            const auto row_change = _position == _buffer || y != _y;
+            write((zigzag(static_cast<int32_t>(x) - _x) << 1) | (row_change ? 1 : 0));
+            if (row_change) {
+                write(zigzag(static_cast<int32_t>(y) - _y));
+            }
+            _t = event.t;
+            _x = x;
+            _y = y;
+        }
+
+        /// flush passes the pending bytes to handle_bytes, and starts a new block.
+        void flush() {
+            if (_position != _buffer) {
+                _handle_bytes(static_cast<const uint8_t*>(_buffer), static_cast<std::size_t>(_position - _buffer));
+                _position = _buffer;
+                _t = 0;
+                _x = 0;
+                _y = 0;
+            }
+        }
+
+        protected:
+        /// zigzag maps signed integers to unsigned integers with small absolute values first.
+        static uint64_t zigzag(int32_t value) {
+            return (static_cast<uint32_t>(value) << 1) ^ (value < 0 ? 0xffffffffu : 0u);
+        }
+
+        /// write appends a varint to the buffer.
+        void write(uint64_t value) {
+            while (value >= 0x80) {
+                *_position = static_cast<uint8_t>(value | 0x80);
+                ++_position;
+                value >>= 7;
+            }
+            *_position = static_cast<uint8_t>(value);
+            ++_position;
+        }
+
+        uint8_t* _buffer;
+        uint8_t* _end;
+        HandleBytes _handle_bytes;
+        uint8_t* _position;
+        uint64_t _t;
+        int32_t _x;
+        int32_t _y;
+    };
+
+    /// make_encode_events creates an encode_events from a buffer and a functor.
+    template <typename Event, typename HandleBytes>
+    encode_events<Event, HandleBytes> make_encode_events(uint8_t* buffer, std::size_t size, HandleBytes handle_bytes) {
+        return encode_events<Event, HandleBytes>(buffer, size, std::forward<HandleBytes>(handle_bytes));
+    }
+}
@@ -0,0 +1,176 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+/// tarsier is a collection of event handlers.
+namespace tarsier {
+    /// has_batch_call determines whether a handler accepts batches of events (const Event*, std::size_t).
+    template <typename HandleEvent, typename Event>
+    class has_batch_call {
+        template <typename Type>
+        static auto test(int) -> decltype(
+            std::declval<Type&>()(std::declval<const Event*>(), std::declval<std::size_t>()),
+            std::true_type());
+        template <typename>
+        static std::false_type test(...);
+
+        public:
+        static constexpr bool value = decltype(test<HandleEvent>(0))::value;
+    };
+
+    /// erased_handler stores any event handler behind a fixed type, so that handlers can be chained at runtime.
+    /// Handlers smaller than buffer_size bytes are stored in place, larger ones on the heap.
+    /// A batch call (const Event*, std::size_t) costs a single indirect call: the loop over the events runs inside
+    /// the erased function, where the handler's operator() can be inlined. Handlers that accept batches themselves
+    /// receive them directly, and receive single events as batches of one event.
+    template <typename Event, std::size_t buffer_size = 64>
+    class erased_handler {
+        public:
+        template <
+            typename HandleEvent,
+            typename = typename std::enable_if<
+                !std::is_same<typename std::decay<HandleEvent>::type, erased_handler>::value>::type>
+        erased_handler(HandleEvent handle_event) : _operations(operations_for<HandleEvent>::table()) {
+            operations_for<HandleEvent>::construct(_storage, std::move(handle_event));
+        }
+        erased_handler(const erased_handler&) = delete;
+        erased_handler(erased_handler&& other) noexcept : _operations(other._operations) {
+            if (_operations != nullptr) {
+                _operations->move(other._storage, _storage);
+                other._operations = nullptr;
+            }
+        }
+        erased_handler& operator=(const erased_handler&) = delete;
+        erased_handler& operator=(erased_handler&& other) noexcept {
+            if (this != &other) {
+                reset();
+                _operations = other._operations;
+                if (_operations != nullptr) {
+                    _operations->move(other._storage, _storage);
+                    other._operations = nullptr;
+                }
+            }
+            return *this;
+        }
+        virtual ~erased_handler() {
+            reset();
+        }
+
+        /// operator() handles an event.
+        void operator()(Event event) {
+            if (_operations == nullptr) {
+                throw std::logic_error("the erased_handler was moved");
+            }
+            _operations->handle(_storage, event);
+        }
+
+        /// operator() handles a batch of events.
+        void operator()(const Event* events, std::size_t count) {
+            if (_operations == nullptr) {
+                throw std::logic_error("the erased_handler was moved");
+            }
+            _operations->handle_batch(_storage, events, count);
+        }
+
+        protected:
+        typedef typename std::aligned_storage<buffer_size, alignof(std::max_align_t)>::type storage;
+
+        /// operations_table lists the type-specific functions of a stored handler.
+        struct operations_table {
+            void (*handle)(storage&, Event);
+            void (*handle_batch)(storage&, const Event*, std::size_t);
+            void (*move)(storage&, storage&);
+            void (*destroy)(storage&);
+        };
+
+        /// operations_for implements the operations for a given handler type.
+        template <typename HandleEvent>
+        struct operations_for {
+            static constexpr bool in_place = sizeof(HandleEvent) <= buffer_size
+                                             && alignof(HandleEvent) <= alignof(std::max_align_t)
+                                             && std::is_nothrow_move_constructible<HandleEvent>::value;
+
+            static HandleEvent& get(storage& buffer) {
+                if (in_place) {
+                    return *reinterpret_cast<HandleEvent*>(&buffer);
+                }
+                return **reinterpret_cast<HandleEvent**>(&buffer);
+            }
+
+            static void construct(storage& buffer, HandleEvent&& handle_event) {
+                if (in_place) {
+                    new (&buffer) HandleEvent(std::move(handle_event));
+                } else {
+                    *reinterpret_cast<HandleEvent**>(&buffer) = new HandleEvent(std::move(handle_event));
+                }
+            }
+
+            typedef std::integral_constant<bool, has_batch_call<HandleEvent, Event>::value> batch_call;
+
+            static void handle(storage& buffer, Event event) {
+                dispatch_batch(get(buffer), &event, 1, batch_call());
+            }
+
+            static void handle_batch(storage& buffer, const Event* events, std::size_t count) {
+                dispatch_batch(get(buffer), events, count, batch_call());
+            }
+
+            static void
+            dispatch_batch(HandleEvent& handle_event, const Event* events, std::size_t count, std::true_type) {
+                handle_event(events, count);
+            }
+
+            static void
+            dispatch_batch(HandleEvent& handle_event, const Event* events, std::size_t count, std::false_type) {
+                for (std::size_t index = 0; index < count; ++index) {
+                    handle_event(events[index]);
+                }
+            }
+
+            static void move(storage& from, storage& to) {
+                if (in_place) {
+                    new (&to) HandleEvent(std::move(get(from)));
+                    get(from).~HandleEvent();
+                } else {
+                    *reinterpret_cast<HandleEvent**>(&to) = *reinterpret_cast<HandleEvent**>(&from);
+                }
+            }
+
+            static void destroy(storage& buffer) {
+                if (in_place) {
+                    get(buffer).~HandleEvent();
+                } else {
+                    delete &get(buffer);
+                }
+            }
+
+            /// table returns the operations of HandleEvent.
+            static const operations_table* table() {
+                static const operations_table operations{&handle, &handle_batch, &move, &destroy};
+                return &operations;
+            }
+        };
+
+        /// reset destroys the stored handler.
+        void reset() {
+            if (_operations != nullptr) {
+                _operations->destroy(_storage);
+                _operations = nullptr;
+            }
+        }
+
+        storage _storage;
+        const operations_table* _operations;
+    };
+
+    /// make_erased_handler creates an erased_handler from a functor.
+    template <typename Event, typename HandleEvent>
+    erased_handler<Event> make_erased_handler(HandleEvent handle_event) {
+        return erased_handler<Event>(std::move(handle_event));
+    }
+}
@@ -0,0 +1,158 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+/// tarsier is a collection of event handlers.
+namespace tarsier {
+    /// fixed_point is a signed 32 bits number with fractional_bits bits after the point (Q16.16 by default).
+    /// Additions are exact and products are rounded to the nearest value representable with the smaller number of
+    /// fractional bits, so computations are reproducible across platforms. Results outside the range wrap around (two's
+    /// complement): the raw arithmetic is done on unsigned integers, where overflows are well defined.
+    template <uint8_t fractional_bits = 16>
+    class fixed_point {
+        static_assert(fractional_bits > 0 && fractional_bits < 31, "fractional_bits must be in the range [1, 30]");
+
+        public:
+        fixed_point() : _raw(0) {}
+        fixed_point(int32_t value) : _raw(wrap(static_cast<uint32_t>(value) << fractional_bits)) {}
+        fixed_point(float value) : _raw(static_cast<int32_t>(std::lround(value * (int32_t(1) << fractional_bits)))) {}
+        fixed_point(double value) :
+            _raw(static_cast<int32_t>(std::lround(value * (int32_t(1) << fractional_bits)))) {}
+        fixed_point(const fixed_point&) = default;
+        fixed_point(fixed_point&&) = default;
+        fixed_point& operator=(const fixed_point&) = default;
+        fixed_point& operator=(fixed_point&&) = default;
+
+        /// from_raw creates a fixed_point from its integer representation.
+        static fixed_point from_raw(int32_t raw) {
+            fixed_point result;
+            result._raw = raw;
+            return result;
+        }
+
+        /// raw returns the integer representation.
+        int32_t raw() const {
+            return _raw;
+        }
+
+        /// operator float converts the number to a float.
+        explicit operator float() const {
+            return static_cast<float>(_raw) / static_cast<float>(int32_t(1) << fractional_bits);
+        }
+
+        fixed_point operator+(fixed_point other) const {
+            return from_raw(wrap(static_cast<uint32_t>(_raw) + static_cast<uint32_t>(other._raw)));
+        }
+        fixed_point operator-(fixed_point other) const {
+            return from_raw(wrap(static_cast<uint32_t>(_raw) - static_cast<uint32_t>(other._raw)));
+        }
+        fixed_point operator-() const {
+            return from_raw(wrap(uint32_t(0) - static_cast<uint32_t>(_raw)));
+        }
+        template <uint8_t other_fractional_bits>
+        fixed_point<(fractional_bits < other_fractional_bits ? fractional_bits : other_fractional_bits)>
+        operator*(fixed_point<other_fractional_bits> other) const {
+            return fixed_point<(fractional_bits < other_fractional_bits ? fractional_bits : other_fractional_bits)>::
+                from_raw(wrap(static_cast<uint32_t>(
+                    (static_cast<int64_t>(_raw) * other.raw() + (int64_t(1) << (shift(other_fractional_bits) - 1)))
+                    >> shift(other_fractional_bits))));
+        }
+        bool operator==(fixed_point other) const {
+            return _raw == other._raw;
+        }
+        bool operator!=(fixed_point other) const {
+            return _raw != other._raw;
+        }
+        bool operator<(fixed_point other) const {
+            return _raw < other._raw;
+        }
+        bool operator>(fixed_point other) const {
+            return _raw > other._raw;
+        }
+        bool operator<=(fixed_point other) const {
+            return _raw <= other._raw;
+        }
+        bool operator>=(fixed_point other) const {
+            return _raw >= other._raw;
+        }
+
+        /// wrap converts an unsigned raw value to its two's complement signed value.
+        static constexpr int32_t wrap(uint32_t raw) {
+            return raw < (uint32_t(1) << 31) ? static_cast<int32_t>(raw) : -static_cast<int32_t>(~raw) - 1;
+        }
+
+        protected:
+        /// shift returns the number of bits to drop after multiplying by a number with other_fractional_bits.
+        static constexpr uint8_t shift(uint8_t other_fractional_bits) {
+            return fractional_bits > other_fractional_bits ? fractional_bits : other_fractional_bits;
+        }
+
+        int32_t _raw;
+    };
+
+    /// decay_factor is the type used to store inertias and decay factors (numbers in the range [0, 1]).
+    /// Fixed-point factors have 30 fractional bits, and a product with a fixed_point yields the coarser format.
+    template <typename Number>
+    struct decay_factor {
+        typedef Number type;
+    };
+    template <uint8_t fractional_bits>
+    struct decay_factor<fixed_point<fractional_bits>> {
+        typedef fixed_point<30> type;
+    };
+
+    /// exponential_decay calculates exp(-delta_t / decay).
+    template <typename Number>
+    class exponential_decay {
+        public:
+        exponential_decay(uint64_t decay) : _decay(static_cast<float>(decay)) {}
+
+        /// operator() returns the decay factor after delta_t.
+        typename decay_factor<Number>::type operator()(uint64_t delta_t) const {
+            return std::exp(-static_cast<float>(delta_t) / _decay);
+        }
+
+        protected:
+        float _decay;
+    };
+
+    /// exponential_decay calculates exp(-delta_t / decay) with two lookup tables of fixed_point<30>.
+    /// delta_t is split into a high and a low part, since exp(-(high + low) / decay) is the product of
+    /// exp(-high / decay) and exp(-low / decay). Both tables have about sqrt(horizon) entries, where horizon is
+    /// decay * 31 * ln(2), the delay after which the factor rounds to zero.
+    /// The result is within 1.5 * 2^-30 of the exact value.
+    template <uint8_t fractional_bits>
+    class exponential_decay<fixed_point<fractional_bits>> {
+        public:
+        exponential_decay(uint64_t decay) :
+            _horizon(static_cast<uint64_t>(std::ceil(decay * 31 * std::log(2.0)))),
+            _shift(0) {
+            while ((uint64_t(1) << (2 * _shift)) < _horizon) {
+                ++_shift;
+            }
+            _low.reserve(std::size_t(1) << _shift);
+            for (uint64_t delta_t = 0; delta_t < (uint64_t(1) << _shift); ++delta_t) {
+                _low.emplace_back(std::exp(-static_cast<double>(delta_t) / decay));
+            }
+            for (uint64_t delta_t = 0; delta_t < _horizon; delta_t += (uint64_t(1) << _shift)) {
+                _high.emplace_back(std::exp(-static_cast<double>(delta_t) / decay));
+            }
+        }
+
+        /// operator() returns the decay factor after delta_t.
+        fixed_point<30> operator()(uint64_t delta_t) const {
+            if (delta_t >= _horizon) {
+                return fixed_point<30>();
+            }
+            return _high[delta_t >> _shift] * _low[delta_t & ((uint64_t(1) << _shift) - 1)];
+        }
+
+        protected:
+        uint64_t _horizon;
+        uint8_t _shift;
+        std::vector<fixed_point<30>> _low;
+        std::vector<fixed_point<30>> _high;
+    };
+}
@@ -0,0 +1,103 @@
+#pragma once
+
+#include "active_events.hpp"
+#include "state.hpp"
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+/// tarsier is a collection of event handlers.
+namespace tarsier {
+    /// guarded_active_events is a surface of active events for a sensor with a fixed geometry.
+    /// The map is surrounded by a guard band of guard pixels whose timestamps are always zero. Handlers given a
+    /// guarded_active_events read neighbourhoods up to guard pixels wide without bounds checks, and the index
+    /// arithmetic uses a compile-time stride. Allocator (rebound to the pixel type) can be one of the allocators in
+    /// allocators.hpp.
+    template <
+        typename Polarity,
+        uint16_t width_value,
+        uint16_t height_value,
+        uint16_t guard,
+        typename Allocator = std::allocator<uint64_t>>
+    class guarded_active_events {
+        public:
+        static_assert(width_value > 0 && height_value > 0, "the width and the height must be larger than zero");
+
+        typedef typename std::allocator_traits<Allocator>::template rebind_alloc<
+            typename active_events_pixel<Polarity>::type>
+            pixel_allocator;
+
+        guarded_active_events(Allocator allocator = Allocator()) :
+            _pixels(
+                static_cast<std::size_t>(stride) * (height_value + 2 * guard),
+                typename active_events_pixel<Polarity>::type(),
+                pixel_allocator(std::move(allocator))) {}
+        guarded_active_events(const guarded_active_events&) = delete;
+        guarded_active_events(guarded_active_events&&) = default;
+        guarded_active_events& operator=(const guarded_active_events&) = delete;
+        guarded_active_events& operator=(guarded_active_events&&) = default;
+        virtual ~guarded_active_events() {}
+
+        /// update stores an event's timestamp (and polarity).
+        template <typename Event>
+        void update(Event event) {
+            active_events_pixel<Polarity>::update(_pixels[index(event.x, event.y)], event);
+        }
+
+        /// t returns the most recent timestamp at the given pixel.
+        /// x and y may lie up to guard pixels outside the sensor.
+        uint64_t t(int32_t x, int32_t y) const {
+            return active_events_pixel<Polarity>::t(_pixels[index(x, y)]);
+        }
+
+        /// polarity returns the most recent polarity at the given pixel.
+        /// x and y may lie up to guard pixels outside the sensor.
+        Polarity polarity(int32_t x, int32_t y) const {
+            return active_events_pixel<Polarity>::polarity(_pixels[index(x, y)]);
+        }
+
+        /// width returns the number of pixels along the x axis.
+        uint16_t width() const {
+            return width_value;
+        }
+
+        /// height returns the number of pixels along the y axis.
+        uint16_t height() const {
+            return height_value;
+        }
+
+        /// write_state_sections writes the timestamps (and polarities) to a state stream.
+        void write_state_sections(std::ostream& stream) const {
+            write_state_section(stream, _pixels);
+        }
+
+        /// read_state_sections reads the timestamps (and polarities) from a state stream.
+        void read_state_sections(std::istream& stream) {
+            auto pixels = read_state_copy(stream, _pixels);
+            _pixels.swap(pixels);
+        }
+
+        protected:
+        /// stride is the number of pixels in a padded row.
+        static constexpr std::size_t stride = static_cast<std::size_t>(width_value) + 2 * guard;
+
+        /// index returns the position of a pixel in the padded map.
+        static std::size_t index(int32_t x, int32_t y) {
+            return static_cast<std::size_t>(x + guard) + static_cast<std::size_t>(y + guard) * stride;
+        }
+
+        std::vector<typename active_events_pixel<Polarity>::type, pixel_allocator> _pixels;
+    };
+
+    /// active_events_traits describes the geometry of a guarded surface of active events.
+    template <
+        typename Polarity,
+        uint16_t width_value,
+        uint16_t height_value,
+        uint16_t guard_value,
+        typename Allocator>
+    struct active_events_traits<guarded_active_events<Polarity, width_value, height_value, guard_value, Allocator>> {
+        static constexpr bool guarded = true;
+        static constexpr uint16_t guard = guard_value;
+    };
+}
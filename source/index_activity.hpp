@@ -0,0 +1,187 @@
+#pragma once
+
+#include "state.hpp"
+#include <cstdint>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+/// tarsier is a collection of event handlers.
+namespace tarsier {
+    /// index_activity counts recent events in 2D Fenwick trees, then propagates the events.
+    /// Time is divided into buckets of bucket_duration microseconds, and each of the last number_of_buckets buckets
+    /// (including the current one) has its own tree. An extra tree holds the sum of all the buckets. Hence an event
+    /// costs O(log(width) * log(height)), counting the events in a rectangle over the whole window costs
+    /// O(log(width) * log(height)), and counting over the latest k buckets costs O(k * log(width) * log(height)).
+    /// Expiring a bucket costs O(width * height), once every bucket_duration at most.
+    /// The counts are relative to the most recent event's bucket.
+    template <typename Event, typename HandleEvent>
+    class index_activity {
+        public:
+        index_activity(
+            uint16_t width,
+            uint16_t height,
+            uint64_t bucket_duration,
+            std::size_t number_of_buckets,
+            HandleEvent handle_event) :
+            _width(width),
+            _height(height),
+            _bucket_duration(bucket_duration),
+            _number_of_buckets(number_of_buckets),
+            _handle_event(std::forward<HandleEvent>(handle_event)),
+            _bucket(0),
+            _counts(number_of_buckets, 0),
+            _trees(static_cast<std::size_t>(width) * height * (number_of_buckets + 1), 0) {
+            if (bucket_duration == 0) {
+                throw std::logic_error("bucket_duration must be larger than zero");
+            }
+            if (number_of_buckets == 0) {
+                throw std::logic_error("number_of_buckets must be larger than zero");
+            }
+        }
+        index_activity(const index_activity&) = delete;
+        index_activity(index_activity&&) = default;
+        index_activity& operator=(const index_activity&) = delete;
+        index_activity& operator=(index_activity&&) = default;
+        virtual ~index_activity() {}
+
+        /// operator() handles an event.
+        virtual void operator()(Event event) {
+            const auto bucket = event.t / _bucket_duration;
+            if (bucket > _bucket) {
+                expire(bucket);
+            }
+            const auto index = static_cast<std::size_t>(_bucket % _number_of_buckets);
+            add(tree(index), event.x, event.y);
+            add(tree(_number_of_buckets), event.x, event.y);
+            ++_counts[index];
+            _handle_event(event);
+        }
+
+        /// count returns the number of events in the rectangle [left, right] x [bottom, top] during the whole window.
+        /// The rectangle must lie inside the sensor.
+        uint64_t count(uint16_t left, uint16_t bottom, uint16_t right, uint16_t top) const {
+            return tree_count(tree(_number_of_buckets), left, bottom, right, top);
+        }
+
+        /// count returns the number of events in the rectangle [left, right] x [bottom, top] during the latest
+        /// number_of_buckets buckets (including the current one).
+        /// The rectangle must lie inside the sensor.
+        uint64_t
+        count(uint16_t left, uint16_t bottom, uint16_t right, uint16_t top, std::size_t number_of_buckets) const {
+            if (number_of_buckets >= _number_of_buckets) {
+                return count(left, bottom, right, top);
+            }
+            uint64_t total = 0;
+            for (std::size_t offset = 0; offset < number_of_buckets && offset <= _bucket; ++offset) {
+                const auto index = static_cast<std::size_t>((_bucket - offset) % _number_of_buckets);
+                if (_counts[index] > 0) {
+                    total += tree_count(tree(index), left, bottom, right, top);
+                }
+            }
+            return total;
+        }
+
+        /// save_state writes the buckets to a stream.
+        void save_state(std::ostream& stream) const {
+            write_state_header(stream, "index_activity");
+            write_state_section(stream, &_bucket, 1);
+            write_state_section(stream, _counts);
+            write_state_section(stream, _trees);
+        }
+
+        /// load_state reads the buckets written by save_state.
+        void load_state(std::istream& stream) {
+            read_state_header(stream, "index_activity");
+            uint64_t bucket;
+            read_state_section(stream, &bucket, 1);
+            auto counts = read_state_copy(stream, _counts);
+            auto trees = read_state_copy(stream, _trees);
+            _bucket = bucket;
+            _counts.swap(counts);
+            _trees.swap(trees);
+        }
+
+        protected:
+        /// tree returns the Fenwick tree of the given bucket (number_of_buckets for the sum of the buckets).
+        uint32_t* tree(std::size_t index) {
+            return _trees.data() + static_cast<std::size_t>(_width) * _height * index;
+        }
+
+        /// tree returns the Fenwick tree of the given bucket (number_of_buckets for the sum of the buckets).
+        const uint32_t* tree(std::size_t index) const {
+            return _trees.data() + static_cast<std::size_t>(_width) * _height * index;
+        }
+
+        /// add increments the count of a pixel in a Fenwick tree.
+        void add(uint32_t* tree, uint16_t x, uint16_t y) {
+            for (uint32_t row = y; row < _height; row |= row + 1) {
+                const auto tree_row = tree + static_cast<std::size_t>(row) * _width;
+                for (uint32_t column = x; column < _width; column |= column + 1) {
+                    ++tree_row[column];
+                }
+            }
+        }
+
+        /// prefix returns the number of events in the rectangle [0, x[ x [0, y[.
+        uint64_t prefix(const uint32_t* tree, uint32_t x, uint32_t y) const {
+            uint64_t total = 0;
+            for (; y > 0; y &= y - 1) {
+                const auto tree_row = tree + static_cast<std::size_t>(y - 1) * _width;
+                for (auto column = x; column > 0; column &= column - 1) {
+                    total += tree_row[column - 1];
+                }
+            }
+            return total;
+        }
+
+        /// tree_count returns the number of events in a rectangle of a Fenwick tree.
+        uint64_t tree_count(const uint32_t* tree, uint16_t left, uint16_t bottom, uint16_t right, uint16_t top) const {
+            const uint32_t x_end = right + 1u;
+            const uint32_t y_end = top + 1u;
+            return prefix(tree, x_end, y_end) + prefix(tree, left, bottom) - prefix(tree, left, y_end)
+                   - prefix(tree, x_end, bottom);
+        }
+
+        /// expire clears the buckets that leave the window, and moves to the given bucket.
+        void expire(uint64_t bucket) {
+            const auto area = static_cast<std::size_t>(_width) * _height;
+            auto window = tree(_number_of_buckets);
+            for (uint64_t expired_bucket = _bucket + 1;
+                 expired_bucket <= bucket && expired_bucket <= _bucket + _number_of_buckets;
+                 ++expired_bucket) {
+                const auto index = static_cast<std::size_t>(expired_bucket % _number_of_buckets);
+                if (_counts[index] > 0) {
+                    auto expired_tree = tree(index);
+                    for (std::size_t position = 0; position < area; ++position) {
+                        window[position] -= expired_tree[position];
+                        expired_tree[position] = 0;
+                    }
+                    _counts[index] = 0;
+                }
+            }
+            _bucket = bucket;
+        }
+
+        const uint16_t _width;
+        const uint16_t _height;
+        const uint64_t _bucket_duration;
+        const std::size_t _number_of_buckets;
+        HandleEvent _handle_event;
+        uint64_t _bucket;
+        std::vector<uint64_t> _counts;
+        std::vector<uint32_t> _trees;
+    };
+
+    /// make_index_activity creates an index_activity from a functor.
+    template <typename Event, typename HandleEvent>
+    index_activity<Event, HandleEvent> make_index_activity(
+        uint16_t width,
+        uint16_t height,
+        uint64_t bucket_duration,
+        std::size_t number_of_buckets,
+        HandleEvent handle_event) {
+        return index_activity<Event, HandleEvent>(
+            width, height, bucket_duration, number_of_buckets, std::forward<HandleEvent>(handle_event));
+    }
+}
@@ -0,0 +1,146 @@
+#pragma once
+
+#include "fixed_point.hpp"
+#include "state.hpp"
+#include <cstdint>
+#include <stdexcept>
+
+/// tarsier is a collection of event handlers.
+namespace tarsier {
+    /// Inertia policies give the weight of the previous state in the exponential filters of average_position and
+    /// track_blob. A filter calls update(event) before each single-event update, then reads inertia() and
+    /// complement() (1 - inertia). A batch update calls weights(events, count, weights) instead, which stores the
+    /// weight of each event in the state after the batch (its complement times the inertias of the later events),
+    /// and returns the weight of the state before the batch (the product of the inertias). Hence a batch folds
+    /// into sums of independent products. The filters' save_state and load_state call write_state_sections and
+    /// read_state_sections to persist the policy's state.
+
+    /// time_constant selects time_inertia in the make_average_position and make_track_blob factories.
+    struct time_constant {
+        uint64_t value;
+    };
+
+    /// event_inertia applies the same inertia to every event. The filter's time constant depends on the event rate.
+    template <typename Number>
+    class event_inertia {
+        public:
+        typedef typename decay_factor<Number>::type factor;
+
+        event_inertia(float inertia) : _inertia(inertia), _complement(factor(1) - _inertia) {
+            if (inertia < 0 || inertia > 1) {
+                throw std::logic_error("inertia must be in the range [0, 1]");
+            }
+        }
+
+        /// update prepares the inertia of an event.
+        template <typename Event>
+        void update(Event) {}
+
+        /// inertia returns the weight of the previous state.
+        factor inertia() const {
+            return _inertia;
+        }
+
+        /// complement returns the weight of the event.
+        factor complement() const {
+            return _complement;
+        }
+
+        /// weights calculates the weights of a batch of events, and returns the weight of the previous state.
+        template <typename Event>
+        factor weights(const Event*, std::size_t count, factor* weights) {
+            auto tail = factor(1);
+            for (auto index = count; index > 0; --index) {
+                weights[index - 1] = _complement * tail;
+                tail = tail * _inertia;
+            }
+            return tail;
+        }
+
+        /// write_state_sections writes an empty section, since the inertia does not depend on past events.
+        void write_state_sections(std::ostream& stream) const {
+            write_state_section(stream, static_cast<const uint64_t*>(nullptr), 0);
+        }
+
+        /// read_state_sections reads the section written by write_state_sections.
+        void read_state_sections(std::istream& stream) {
+            read_state_section(stream, static_cast<uint64_t*>(nullptr), 0);
+        }
+
+        protected:
+        factor _inertia;
+        factor _complement;
+    };
+
+    /// time_inertia derives the inertia from the time elapsed since the previous event: exp(-delta_t / time_constant)
+    /// with delta_t and time_constant in microseconds. The filter's time constant does not depend on the event rate.
+    /// Events must have a t member.
+    template <typename Number>
+    class time_inertia {
+        public:
+        typedef typename decay_factor<Number>::type factor;
+
+        time_inertia(time_constant inertia_time_constant) :
+            _exponential_decay(inertia_time_constant.value),
+            _t(0),
+            _inertia(0),
+            _complement(1) {
+            if (inertia_time_constant.value == 0) {
+                throw std::logic_error("the time constant must be larger than zero");
+            }
+        }
+
+        /// update prepares the inertia of an event.
+        template <typename Event>
+        void update(Event event) {
+            _inertia = _exponential_decay(event.t - _t);
+            _complement = factor(1) - _inertia;
+            _t = event.t;
+        }
+
+        /// inertia returns the weight of the previous state.
+        factor inertia() const {
+            return _inertia;
+        }
+
+        /// complement returns the weight of the event.
+        factor complement() const {
+            return _complement;
+        }
+
+        /// weights calculates the weights of a batch of events, and returns the weight of the previous state.
+        /// The weight of the state after an event is exp(-(last_t - t) / time_constant), hence an event's weight is
+        /// the difference between its state weight and the previous one. Each event needs a single decay.
+        template <typename Event>
+        factor weights(const Event* events, std::size_t count, factor* weights) {
+            const auto last_t = events[count - 1].t;
+            const auto head = _exponential_decay(last_t - _t);
+            auto previous_state_weight = head;
+            for (std::size_t index = 0; index < count; ++index) {
+                const auto state_weight = _exponential_decay(last_t - events[index].t);
+                weights[index] = state_weight - previous_state_weight;
+                previous_state_weight = state_weight;
+            }
+            _t = last_t;
+            return head;
+        }
+
+        /// write_state_sections writes the timestamp of the last event.
+        void write_state_sections(std::ostream& stream) const {
+            write_state_section(stream, &_t, 1);
+        }
+
+        /// read_state_sections reads the timestamp written by write_state_sections.
+        void read_state_sections(std::istream& stream) {
+            uint64_t t;
+            read_state_section(stream, &t, 1);
+            _t = t;
+        }
+
+        protected:
+        exponential_decay<Number> _exponential_decay;
+        uint64_t _t;
+        factor _inertia;
+        factor _complement;
+    };
+}
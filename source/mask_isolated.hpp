@@ -1,14 +1,18 @@
 #pragma once
 
+#include "active_events.hpp"
+#include "state.hpp"
 #include <cstdint>
+#include <type_traits>
 #include <utility>
-#include <vector>
 
 /// tarsier is a collection of event handlers.
 namespace tarsier {
 
     /// mask_isolated propagates only events that are not isolated spatially or temporally.
-    template <typename Event, typename HandleEvent>
+    /// When ActiveEvents is a reference, the timestamps are shared with other handlers and must be updated before
+    /// each event reaches mask_isolated (see update_active_events). Otherwise, mask_isolated owns and updates them.
+    template <typename Event, typename HandleEvent, typename ActiveEvents = active_events<void>>
     class mask_isolated {
         public:
         mask_isolated(uint16_t width, uint16_t height, uint64_t temporal_window, HandleEvent handle_event) :
@@ -16,7 +20,15 @@ namespace tarsier {
             _height(height),
             _temporal_window(temporal_window),
             _handle_event(std::forward<HandleEvent>(handle_event)),
-            _ts(width * height, 0) {}
+            _active_events(width, height) {}
+        mask_isolated(ActiveEvents active_events, uint64_t temporal_window, HandleEvent handle_event) :
+            _width(active_events.width()),
+            _height(active_events.height()),
+            _temporal_window(temporal_window),
+            _handle_event(std::forward<HandleEvent>(handle_event)),
+            _active_events(std::forward<ActiveEvents>(active_events)) {
+            check_window<ActiveEvents>(1);
+        }
         mask_isolated(const mask_isolated&) = delete;
         mask_isolated(mask_isolated&&) = default;
         mask_isolated& operator=(const mask_isolated&) = delete;
@@ -25,21 +37,39 @@ namespace tarsier {
 
         /// operator() handles an event.
         virtual void operator()(Event event) {
-            const auto index = event.x + event.y * _width;
-            _ts[index] = event.t + _temporal_window;
-            if ((event.x > 0 && _ts[index - 1] > event.t) || (event.x < _width - 1 && _ts[index + 1] > event.t)
-                || (event.y > 0 && _ts[index - _width] > event.t)
-                || (event.y < _height - 1 && _ts[index + _width] > event.t)) {
+            if (!std::is_reference<ActiveEvents>::value) {
+                _active_events.update(event);
+            }
+            const auto t_threshold = (event.t <= _temporal_window ? 0 : event.t - _temporal_window);
+            const auto guarded = active_events_traits<typename std::decay<ActiveEvents>::type>::guarded;
+            const int32_t x = event.x;
+            const int32_t y = event.y;
+            if (((guarded || x > 0) && _active_events.t(x - 1, y) > t_threshold)
+                || ((guarded || x < _width - 1) && _active_events.t(x + 1, y) > t_threshold)
+                || ((guarded || y > 0) && _active_events.t(x, y - 1) > t_threshold)
+                || ((guarded || y < _height - 1) && _active_events.t(x, y + 1) > t_threshold)) {
                 _handle_event(event);
             }
         }
 
+        /// save_state writes the timestamps map to a stream.
+        void save_state(std::ostream& stream) const {
+            write_state_header(stream, "mask_isolated");
+            _active_events.write_state_sections(stream);
+        }
+
+        /// load_state reads the timestamps map written by save_state.
+        void load_state(std::istream& stream) {
+            read_state_header(stream, "mask_isolated");
+            _active_events.read_state_sections(stream);
+        }
+
         protected:
         const uint16_t _width;
         const uint16_t _height;
         const uint64_t _temporal_window;
         HandleEvent _handle_event;
-        std::vector<uint64_t> _ts;
+        ActiveEvents _active_events;
     };
 
     /// make_mask_isolated creates a mask_isolated from a functor.
@@ -49,4 +79,13 @@ namespace tarsier {
         return mask_isolated<Event, HandleEvent>(
             width, height, temporal_window, std::forward<HandleEvent>(handle_event));
     }
+
+    /// make_mask_isolated creates a mask_isolated from active events and a functor.
+    /// An lvalue active_events is shared (the handler keeps a reference), an rvalue is moved into the handler.
+    template <typename Event, typename ActiveEvents, typename HandleEvent>
+    mask_isolated<Event, HandleEvent, ActiveEvents>
+    make_mask_isolated(ActiveEvents&& active_events, uint64_t temporal_window, HandleEvent handle_event) {
+        return mask_isolated<Event, HandleEvent, ActiveEvents>(
+            std::forward<ActiveEvents>(active_events), temporal_window, std::forward<HandleEvent>(handle_event));
+    }
 }
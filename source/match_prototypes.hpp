@@ -0,0 +1,233 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+#ifdef __AVX__
+#include <immintrin.h>
+#endif
+
+/// tarsier is a collection of event handlers.
+namespace tarsier {
+    /// match_prototypes finds the prototype closest to each time surface (HOTS layer).
+    /// The time surface type must have a projections member with dimension elements convertible to float.
+    /// The prototypes are stored dimension-major (structure of arrays) in 32-bytes aligned memory, so that the
+    /// distances to eight prototypes are computed at once with AVX instructions, when available.
+    /// When learning_rate is strictly positive, the winning prototype is moved towards each time surface.
+    template <
+        typename TimeSurface,
+        typename Feature,
+        std::size_t dimension,
+        typename TimeSurfaceToFeature,
+        typename HandleFeature>
+    class match_prototypes {
+        public:
+        match_prototypes(
+            const std::vector<std::array<float, dimension>>& prototypes,
+            float learning_rate,
+            TimeSurfaceToFeature time_surface_to_feature,
+            HandleFeature handle_feature) :
+            _size(prototypes.size()),
+            _stride((prototypes.size() + lanes - 1) / lanes * lanes),
+            _learning_rate(learning_rate),
+            _time_surface_to_feature(std::forward<TimeSurfaceToFeature>(time_surface_to_feature)),
+            _handle_feature(std::forward<HandleFeature>(handle_feature)),
+            _storage(2 * dimension * _stride + tile * _stride + tile * padded_dimension + lanes, 0.0f),
+            _counts(_size, 0) {
+            if (_size == 0) {
+                throw std::logic_error("prototypes must not be empty");
+            }
+            if (_learning_rate < 0 || _learning_rate > 1) {
+                throw std::logic_error("learning_rate must be in the range [0, 1]");
+            }
+            _prototypes = reinterpret_cast<float*>(
+                (reinterpret_cast<std::uintptr_t>(_storage.data()) + lanes * sizeof(float) - 1)
+                & ~static_cast<std::uintptr_t>(lanes * sizeof(float) - 1));
+            _sums = _prototypes + dimension * _stride;
+            _distances = _sums + dimension * _stride;
+            _patches = _distances + tile * _stride;
+            for (std::size_t index = 0; index < _size; ++index) {
+                for (std::size_t coordinate = 0; coordinate < dimension; ++coordinate) {
+                    _prototypes[coordinate * _stride + index] = prototypes[index][coordinate];
+                }
+            }
+        }
+        match_prototypes(const match_prototypes&) = delete;
+        match_prototypes(match_prototypes&&) = default;
+        match_prototypes& operator=(const match_prototypes&) = delete;
+        match_prototypes& operator=(match_prototypes&&) = default;
+        virtual ~match_prototypes() {}
+
+        /// operator() handles a time surface.
+        virtual void operator()(TimeSurface time_surface) {
+            load(time_surface, 0);
+            compute_distances<1>(0);
+            const auto index = closest(0);
+            const auto distance = _distances[index];
+            if (_learning_rate > 0) {
+                for (std::size_t coordinate = 0; coordinate < dimension; ++coordinate) {
+                    auto& value = _prototypes[coordinate * _stride + index];
+                    value += _learning_rate * (_patches[coordinate] - value);
+                }
+            }
+            _handle_feature(_time_surface_to_feature(time_surface, index, distance));
+        }
+
+        /// train updates the prototypes with a batch of time surfaces (mini-batch k-means).
+        /// The time surfaces are matched against the prototypes as they were before the batch, four at a time,
+        /// then each prototype is moved towards the mean of the time surfaces it won, by learning_rate.
+        template <typename Iterator>
+        void train(Iterator begin, Iterator end) {
+            std::fill(_sums, _sums + dimension * _stride, 0.0f);
+            std::fill(_counts.begin(), _counts.end(), 0);
+            while (begin != end) {
+                std::size_t count = 0;
+                for (; count < tile && begin != end; ++count, ++begin) {
+                    load(*begin, count);
+                }
+                if (count == tile) {
+                    compute_distances<tile>(0);
+                } else {
+                    for (std::size_t patch = 0; patch < count; ++patch) {
+                        compute_distances<1>(patch);
+                    }
+                }
+                for (std::size_t patch = 0; patch < count; ++patch) {
+                    const auto index = closest(patch);
+                    ++_counts[index];
+                    for (std::size_t coordinate = 0; coordinate < dimension; ++coordinate) {
+                        _sums[coordinate * _stride + index] += _patches[patch * padded_dimension + coordinate];
+                    }
+                }
+            }
+            for (std::size_t index = 0; index < _size; ++index) {
+                if (_counts[index] > 0) {
+                    for (std::size_t coordinate = 0; coordinate < dimension; ++coordinate) {
+                        auto& value = _prototypes[coordinate * _stride + index];
+                        value += _learning_rate
+                                 * (_sums[coordinate * _stride + index] / static_cast<float>(_counts[index]) - value);
+                    }
+                }
+            }
+        }
+
+        /// prototype returns the coordinates of the given prototype.
+        std::array<float, dimension> prototype(std::size_t index) const {
+            std::array<float, dimension> coordinates;
+            for (std::size_t coordinate = 0; coordinate < dimension; ++coordinate) {
+                coordinates[coordinate] = _prototypes[coordinate * _stride + index];
+            }
+            return coordinates;
+        }
+
+        protected:
+        /// lanes is the number of prototypes processed by a single instruction.
+        static constexpr std::size_t lanes = 8;
+
+        /// tile is the number of time surfaces matched at once during training.
+        static constexpr std::size_t tile = 4;
+
+        /// padded_dimension is the dimension rounded up to a multiple of lanes.
+        static constexpr std::size_t padded_dimension = (dimension + lanes - 1) / lanes * lanes;
+
+        /// load copies a time surface's projections in the patches buffer.
+        template <typename Surface>
+        void load(const Surface& time_surface, std::size_t patch) {
+            for (std::size_t coordinate = 0; coordinate < dimension; ++coordinate) {
+                _patches[patch * padded_dimension + coordinate] =
+                    static_cast<float>(time_surface.projections[coordinate]);
+            }
+        }
+
+        /// compute_distances calculates the squared distances between consecutive patches and every prototype.
+        template <std::size_t patches>
+        void compute_distances(std::size_t first) {
+#ifdef __AVX__
+            for (std::size_t block = 0; block < _stride; block += lanes) {
+                __m256 sums[patches];
+                for (std::size_t patch = 0; patch < patches; ++patch) {
+                    sums[patch] = _mm256_setzero_ps();
+                }
+                for (std::size_t coordinate = 0; coordinate < dimension; ++coordinate) {
+                    const auto values = _mm256_load_ps(_prototypes + coordinate * _stride + block);
+                    for (std::size_t patch = 0; patch < patches; ++patch) {
+                        const auto delta = _mm256_sub_ps(
+                            values, _mm256_set1_ps(_patches[(first + patch) * padded_dimension + coordinate]));
+#ifdef __FMA__
+                        sums[patch] = _mm256_fmadd_ps(delta, delta, sums[patch]);
+#else
+                        sums[patch] = _mm256_add_ps(sums[patch], _mm256_mul_ps(delta, delta));
+#endif
+                    }
+                }
+                for (std::size_t patch = 0; patch < patches; ++patch) {
+                    _mm256_store_ps(_distances + (first + patch) * _stride + block, sums[patch]);
+                }
+            }
+#else
+            std::fill(_distances + first * _stride, _distances + (first + patches) * _stride, 0.0f);
+            for (std::size_t coordinate = 0; coordinate < dimension; ++coordinate) {
+                const auto values = _prototypes + coordinate * _stride;
+                for (std::size_t patch = 0; patch < patches; ++patch) {
+                    const auto value = _patches[(first + patch) * padded_dimension + coordinate];
+                    const auto distances = _distances + (first + patch) * _stride;
+                    for (std::size_t index = 0; index < _stride; ++index) {
+                        const auto delta = values[index] - value;
+                        distances[index] += delta * delta;
+                    }
+                }
+            }
+#endif
+        }
+
+        /// closest returns the index of the prototype closest to the given patch.
+        std::size_t closest(std::size_t patch) const {
+            const auto distances = _distances + patch * _stride;
+            std::size_t index = 0;
+            auto minimum = std::numeric_limits<float>::infinity();
+            for (std::size_t candidate = 0; candidate < _size; ++candidate) {
+                if (distances[candidate] < minimum) {
+                    minimum = distances[candidate];
+                    index = candidate;
+                }
+            }
+            return index;
+        }
+
+        const std::size_t _size;
+        const std::size_t _stride;
+        const float _learning_rate;
+        TimeSurfaceToFeature _time_surface_to_feature;
+        HandleFeature _handle_feature;
+        std::vector<float> _storage;
+        std::vector<std::size_t> _counts;
+        float* _prototypes;
+        float* _sums;
+        float* _distances;
+        float* _patches;
+    };
+
+    /// make_match_prototypes creates a match_prototypes from functors.
+    template <
+        typename TimeSurface,
+        typename Feature,
+        std::size_t dimension,
+        typename TimeSurfaceToFeature,
+        typename HandleFeature>
+    match_prototypes<TimeSurface, Feature, dimension, TimeSurfaceToFeature, HandleFeature> make_match_prototypes(
+        const std::vector<std::array<float, dimension>>& prototypes,
+        float learning_rate,
+        TimeSurfaceToFeature time_surface_to_feature,
+        HandleFeature handle_feature) {
+        return match_prototypes<TimeSurface, Feature, dimension, TimeSurfaceToFeature, HandleFeature>(
+            prototypes,
+            learning_rate,
+            std::forward<TimeSurfaceToFeature>(time_surface_to_feature),
+            std::forward<HandleFeature>(handle_feature));
+    }
+}
@@ -0,0 +1,361 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <deque>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+/// tarsier is a collection of event handlers.
+namespace tarsier {
+    /// match_stereo matches the events of two rectified and synchronised cameras.
+    /// Each row of each camera keeps its ring_size most recent events. An event is compared with the events of the
+    /// other camera on the same row, with the same polarity, at most temporal_window apart, and with a disparity
+    /// (left x minus right x) in [minimum_disparity, maximum_disparity]. Hence the matching cost does not depend on
+    /// the event rate of the other rows. The cost is the time difference divided by temporal_window, plus
+    /// patch_weight times the mean absolute difference of the two cameras' time surfaces (decay in microseconds) in a
+    /// (2 * patch_radius + 1)^2 neighbourhood. A zero patch_weight disables the time surfaces.
+    /// An event is matched, oldest first, once the other camera has passed its timestamp plus temporal_window, so
+    /// that later partners are candidates too. Matches are one-to-one: an event takes the candidate with the lowest
+    /// cost among those that are unmatched or matched with a higher cost, and the replaced partner looks for another
+    /// candidate. A match is final, and propagated, once both cameras have passed the older event's timestamp plus
+    /// three times temporal_window. ring_size must cover the events of a row over four times temporal_window, since
+    /// overwritten events are dropped.
+    /// The left and right methods handle the events of each camera (each camera's events in chronological order),
+    /// and event_to_depth_event(left_event, right_event) is called for each match. flush propagates the remaining
+    /// matches after the last event.
+    template <typename Event, typename DepthEvent, typename EventToDepthEvent, typename HandleDepthEvent>
+    class match_stereo {
+        public:
+        match_stereo(
+            uint16_t width,
+            uint16_t height,
+            std::size_t ring_size,
+            uint16_t minimum_disparity,
+            uint16_t maximum_disparity,
+            uint64_t temporal_window,
+            uint16_t patch_radius,
+            float patch_weight,
+            float decay,
+            EventToDepthEvent event_to_depth_event,
+            HandleDepthEvent handle_depth_event) :
+            _width(width),
+            _height(height),
+            _ring_size(ring_size),
+            _minimum_disparity(minimum_disparity),
+            _maximum_disparity(maximum_disparity),
+            _temporal_window(temporal_window),
+            _patch_radius(patch_radius),
+            _patch_weight(patch_weight),
+            _decay(decay),
+            _event_to_depth_event(std::forward<EventToDepthEvent>(event_to_depth_event)),
+            _handle_depth_event(std::forward<HandleDepthEvent>(handle_depth_event)),
+            _rings(
+                2 * static_cast<std::size_t>(height) * ring_size,
+                entry{Event(),
+                      0,
+                      2 * static_cast<std::size_t>(height) * ring_size,
+                      std::numeric_limits<float>::infinity(),
+                      false,
+                      false}),
+            _heads(2 * static_cast<std::size_t>(height), 0),
+            _sizes(2 * static_cast<std::size_t>(height), 0),
+            _ts(patch_weight > 0.0f ? 2 * static_cast<std::size_t>(width) * height : 0, 0),
+            _camera_ts{{0, 0}},
+            _sequence(0) {
+            if (ring_size == 0) {
+                throw std::logic_error("ring_size must be larger than zero");
+            }
+            if (minimum_disparity > maximum_disparity) {
+                throw std::logic_error("minimum_disparity must be smaller than or equal to maximum_disparity");
+            }
+            if (temporal_window == 0) {
+                throw std::logic_error("temporal_window must be larger than zero");
+            }
+            if (patch_weight > 0.0f && decay <= 0.0f) {
+                throw std::logic_error("decay must be larger than zero");
+            }
+        }
+        match_stereo(const match_stereo&) = delete;
+        match_stereo(match_stereo&&) = default;
+        match_stereo& operator=(const match_stereo&) = delete;
+        match_stereo& operator=(match_stereo&&) = default;
+        virtual ~match_stereo() {}
+
+        /// left handles an event from the left camera.
+        virtual void left(Event event) {
+            handle(event, 0);
+        }
+
+        /// right handles an event from the right camera.
+        virtual void right(Event event) {
+            handle(event, 1);
+        }
+
+        /// flush matches the pending events and propagates the matches, after the last event.
+        void flush() {
+            resolve(true);
+            propagate(true);
+        }
+
+        protected:
+        /// entry is an event stored in a ring, with its tentative match.
+        /// partner is the position of the matched event in the rings, or none.
+        struct entry {
+            Event event;
+            uint64_t sequence;
+            std::size_t partner;
+            float cost;
+            bool resolved;
+            bool propagated;
+        };
+
+        /// reference designates an entry, and becomes invalid when the entry is overwritten.
+        struct reference {
+            std::size_t position;
+            uint64_t sequence;
+        };
+
+        /// handle stores an event from the given camera (0 for left, 1 for right), matches the pending events whose
+        /// candidates have all been received, and propagates the final matches.
+        void handle(Event event, std::size_t camera) {
+            if (!_ts.empty()) {
+                _ts[pixel_index(camera, event.x, event.y)] = event.t;
+            }
+            _camera_ts[camera] = event.t;
+            const auto row = camera * _height + event.y;
+            const auto position = row * _ring_size + _heads[row];
+            release(position);
+            ++_sequence;
+            _rings[position] = entry{event, _sequence, none(), std::numeric_limits<float>::infinity(), false, false};
+            _heads[row] = (_heads[row] + 1) % _ring_size;
+            if (_sizes[row] < _ring_size) {
+                ++_sizes[row];
+            }
+            _pending[camera].push_back(reference{position, _sequence});
+            resolve(false);
+            propagate(false);
+        }
+
+        /// none is the partner of an unmatched entry.
+        std::size_t none() const {
+            return _rings.size();
+        }
+
+        /// valid returns whether a reference still designates its entry.
+        bool valid(reference target) const {
+            return _rings[target.position].sequence == target.sequence;
+        }
+
+        /// release unmatches an entry and its partner.
+        void release(std::size_t position) {
+            const auto partner = _rings[position].partner;
+            if (partner != none()) {
+                _rings[partner].partner = none();
+                _rings[partner].cost = std::numeric_limits<float>::infinity();
+                _rings[position].partner = none();
+                _rings[position].cost = std::numeric_limits<float>::infinity();
+            }
+        }
+
+        /// resolve matches the pending events, oldest first, whose candidates have all been received (or all of them
+        /// if all is true).
+        void resolve(bool all) {
+            for (;;) {
+                std::size_t camera = 2;
+                for (std::size_t candidate_camera = 0; candidate_camera < 2; ++candidate_camera) {
+                    if (_pending[candidate_camera].empty()) {
+                        continue;
+                    }
+                    const auto t = _rings[_pending[candidate_camera].front().position].event.t;
+                    if ((all || t + _temporal_window < _camera_ts[1 - candidate_camera])
+                        && (camera == 2 || t < _rings[_pending[camera].front().position].event.t)) {
+                        camera = candidate_camera;
+                    }
+                }
+                if (camera == 2) {
+                    return;
+                }
+                const auto pending = _pending[camera].front();
+                _pending[camera].pop_front();
+                if (valid(pending)) {
+                    _rings[pending.position].resolved = true;
+                    _resolved.push_back(pending);
+                    match(pending.position);
+                }
+            }
+        }
+
+        /// match looks for a better partner for a resolved entry. Replaced partners that are resolved look for
+        /// another partner in turn. Each replacement lowers the cost of a match, hence the process terminates.
+        void match(std::size_t position) {
+            _unmatched.assign(1, position);
+            while (!_unmatched.empty()) {
+                const auto entry_position = _unmatched.back();
+                _unmatched.pop_back();
+                const auto camera = entry_position / (static_cast<std::size_t>(_height) * _ring_size);
+                const auto event = _rings[entry_position].event;
+                const auto row = (1 - camera) * _height + event.y;
+                auto best_cost = _rings[entry_position].cost;
+                auto best_position = none();
+                for (std::size_t offset = 0; offset < _sizes[row]; ++offset) {
+                    const auto candidate_position =
+                        row * _ring_size + (_heads[row] + _ring_size - 1 - offset) % _ring_size;
+                    const auto& candidate = _rings[candidate_position];
+                    if (candidate.event.t + _temporal_window < event.t) {
+                        break;
+                    }
+                    const int32_t disparity = camera == 0 ? static_cast<int32_t>(event.x) - candidate.event.x :
+                                                            static_cast<int32_t>(candidate.event.x) - event.x;
+                    if (candidate.event.t > event.t + _temporal_window || candidate.propagated
+                        || disparity < _minimum_disparity || disparity > _maximum_disparity
+                        || candidate.event.polarity != event.polarity) {
+                        continue;
+                    }
+                    auto cost = static_cast<float>(
+                                    event.t >= candidate.event.t ? event.t - candidate.event.t :
+                                                                   candidate.event.t - event.t)
+                                / static_cast<float>(_temporal_window);
+                    if (!_ts.empty()) {
+                        cost += _patch_weight * patch_difference(event, camera, candidate.event.x);
+                    }
+                    if (cost < best_cost && cost < candidate.cost) {
+                        best_cost = cost;
+                        best_position = candidate_position;
+                    }
+                }
+                if (best_position != none()) {
+                    for (auto replaced : {_rings[entry_position].partner, _rings[best_position].partner}) {
+                        if (replaced != none()) {
+                            release(replaced);
+                            if (_rings[replaced].resolved) {
+                                _unmatched.push_back(replaced);
+                            }
+                        }
+                    }
+                    _rings[entry_position].partner = best_position;
+                    _rings[entry_position].cost = best_cost;
+                    _rings[best_position].partner = entry_position;
+                    _rings[best_position].cost = best_cost;
+                }
+            }
+        }
+
+        /// propagate sends the final matches, that is those whose events cannot be replaced anymore (or all of them
+        /// if all is true).
+        void propagate(bool all) {
+            const auto t_limit = std::min(_camera_ts[0], _camera_ts[1]);
+            while (!_resolved.empty()) {
+                const auto resolved = _resolved.front();
+                if (!valid(resolved)) {
+                    _resolved.pop_front();
+                    continue;
+                }
+                auto& resolved_entry = _rings[resolved.position];
+                if (!all && resolved_entry.event.t + 3 * _temporal_window >= t_limit) {
+                    return;
+                }
+                _resolved.pop_front();
+                resolved_entry.propagated = true;
+                if (resolved_entry.partner != none() && !_rings[resolved_entry.partner].propagated) {
+                    auto& partner_entry = _rings[resolved_entry.partner];
+                    partner_entry.propagated = true;
+                    if (resolved.position < resolved_entry.partner) {
+                        _handle_depth_event(_event_to_depth_event(resolved_entry.event, partner_entry.event));
+                    } else {
+                        _handle_depth_event(_event_to_depth_event(partner_entry.event, resolved_entry.event));
+                    }
+                }
+            }
+        }
+
+        /// pixel_index returns the position of a pixel in the timestamps map of a camera.
+        std::size_t pixel_index(std::size_t camera, uint16_t x, uint16_t y) const {
+            return (camera * _height + y) * static_cast<std::size_t>(_width) + x;
+        }
+
+        /// patch_difference returns the mean absolute difference between the time surfaces around the event and
+        /// around the candidate pixel (other_x, event.y) of the other camera. The surfaces hold the latest
+        /// timestamps, which may be later than the event's.
+        float patch_difference(Event event, std::size_t camera, uint16_t other_x) const {
+            const auto shift = static_cast<int32_t>(other_x) - event.x;
+            const int32_t x_first = std::max(static_cast<int32_t>(event.x) - _patch_radius, std::max(0, -shift));
+            const int32_t x_last = std::min(
+                static_cast<int32_t>(event.x) + _patch_radius, std::min(_width - 1, _width - 1 - shift));
+            const int32_t y_first = std::max(static_cast<int32_t>(event.y) - _patch_radius, 0);
+            const int32_t y_last = std::min(static_cast<int32_t>(event.y) + _patch_radius, _height - 1);
+            auto difference = 0.0f;
+            std::size_t count = 0;
+            for (auto y = y_first; y <= y_last; ++y) {
+                for (auto x = x_first; x <= x_last; ++x) {
+                    difference += std::abs(
+                        surface(event.t, _ts[pixel_index(camera, x, y)])
+                        - surface(event.t, _ts[pixel_index(1 - camera, x + shift, y)]));
+                    ++count;
+                }
+            }
+            return count == 0 ? 0.0f : difference / count;
+        }
+
+        /// surface returns the decayed value of a timestamp, relative to t.
+        float surface(uint64_t t, uint64_t pixel_t) const {
+            if (pixel_t == 0) {
+                return 0.0f;
+            }
+            return std::exp(-static_cast<float>(t >= pixel_t ? t - pixel_t : pixel_t - t) / _decay);
+        }
+
+        const uint16_t _width;
+        const uint16_t _height;
+        const std::size_t _ring_size;
+        const uint16_t _minimum_disparity;
+        const uint16_t _maximum_disparity;
+        const uint64_t _temporal_window;
+        const uint16_t _patch_radius;
+        const float _patch_weight;
+        const float _decay;
+        EventToDepthEvent _event_to_depth_event;
+        HandleDepthEvent _handle_depth_event;
+        std::vector<entry> _rings;
+        std::vector<std::size_t> _heads;
+        std::vector<std::size_t> _sizes;
+        std::vector<uint64_t> _ts;
+        std::array<uint64_t, 2> _camera_ts;
+        std::array<std::deque<reference>, 2> _pending;
+        std::deque<reference> _resolved;
+        std::vector<std::size_t> _unmatched;
+        uint64_t _sequence;
+    };
+
+    /// make_match_stereo creates a match_stereo from functors.
+    template <typename Event, typename DepthEvent, typename EventToDepthEvent, typename HandleDepthEvent>
+    match_stereo<Event, DepthEvent, EventToDepthEvent, HandleDepthEvent> make_match_stereo(
+        uint16_t width,
+        uint16_t height,
+        std::size_t ring_size,
+        uint16_t minimum_disparity,
+        uint16_t maximum_disparity,
+        uint64_t temporal_window,
+        uint16_t patch_radius,
+        float patch_weight,
+        float decay,
+        EventToDepthEvent event_to_depth_event,
+        HandleDepthEvent handle_depth_event) {
+        return match_stereo<Event, DepthEvent, EventToDepthEvent, HandleDepthEvent>(
+            width,
+            height,
+            ring_size,
+            minimum_disparity,
+            maximum_disparity,
+            temporal_window,
+            patch_radius,
+            patch_weight,
+            decay,
+            std::forward<EventToDepthEvent>(event_to_depth_event),
+            std::forward<HandleDepthEvent>(handle_depth_event));
+    }
+}
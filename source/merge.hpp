@@ -0,0 +1,115 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+/// tarsier is a collection of event handlers.
+namespace tarsier {
+    /// merge combines several ordered event streams into a single time-ordered stream.
+    /// Events are held back until the most recent timestamp among all the inputs exceeds theirs by maximum_lateness.
+    /// Events older than the last propagated event (or than the previous event of the same input) are dropped.
+    template <typename Event, typename HandleEvent>
+    class merge {
+        public:
+        merge(std::vector<std::pair<uint16_t, uint16_t>> offsets, uint64_t maximum_lateness, HandleEvent handle_event) :
+            _offsets(std::move(offsets)),
+            _maximum_lateness(maximum_lateness),
+            _handle_event(std::forward<HandleEvent>(handle_event)),
+            _queues(_offsets.size()),
+            _latest_t(0),
+            _propagated_t(0),
+            _late_events(0) {
+            if (_offsets.empty()) {
+                throw std::logic_error("offsets must contain at least one input");
+            }
+            _heads.reserve(_offsets.size());
+        }
+        merge(const merge&) = delete;
+        merge(merge&&) = default;
+        merge& operator=(const merge&) = delete;
+        merge& operator=(merge&&) = default;
+        virtual ~merge() {}
+
+        /// operator() handles an event from the given input.
+        virtual void operator()(std::size_t input, Event event) {
+            auto& queue = _queues[input];
+            if (event.t < _propagated_t || (!queue.empty() && event.t < queue.back().t)) {
+                ++_late_events;
+                return;
+            }
+            event.x += _offsets[input].first;
+            event.y += _offsets[input].second;
+            if (queue.empty()) {
+                push_head(event.t, input);
+            }
+            queue.push_back(event);
+            if (event.t > _latest_t) {
+                _latest_t = event.t;
+            }
+            if (_latest_t >= _maximum_lateness) {
+                propagate(_latest_t - _maximum_lateness);
+            }
+        }
+
+        /// flush propagates all the buffered events, for example at the end of the streams.
+        virtual void flush() {
+            propagate(std::numeric_limits<uint64_t>::max());
+        }
+
+        /// late_events returns the number of dropped events.
+        std::size_t late_events() const {
+            return _late_events;
+        }
+
+        protected:
+        /// propagate sends the buffered events up to the given timestamp (included), in order.
+        /// Consecutive events from the same input are sent as a run, without heap operations.
+        void propagate(uint64_t t) {
+            while (!_heads.empty() && _heads.front().first <= t) {
+                std::pop_heap(_heads.begin(), _heads.end(), std::greater<std::pair<uint64_t, std::size_t>>());
+                const auto input = _heads.back().second;
+                _heads.pop_back();
+                auto& queue = _queues[input];
+                const auto run_t = (_heads.empty() ? t : std::min(t, _heads.front().first));
+                do {
+                    _propagated_t = queue.front().t;
+                    _handle_event(queue.front());
+                    queue.pop_front();
+                } while (!queue.empty() && queue.front().t <= run_t);
+                if (!queue.empty()) {
+                    push_head(queue.front().t, input);
+                }
+            }
+        }
+
+        /// push_head inserts an input's oldest buffered timestamp in the heap.
+        void push_head(uint64_t t, std::size_t input) {
+            _heads.emplace_back(t, input);
+            std::push_heap(_heads.begin(), _heads.end(), std::greater<std::pair<uint64_t, std::size_t>>());
+        }
+
+        const std::vector<std::pair<uint16_t, uint16_t>> _offsets;
+        const uint64_t _maximum_lateness;
+        HandleEvent _handle_event;
+        std::vector<std::deque<Event>> _queues;
+        std::vector<std::pair<uint64_t, std::size_t>> _heads;
+        uint64_t _latest_t;
+        uint64_t _propagated_t;
+        std::size_t _late_events;
+    };
+
+    /// make_merge creates a merge from a functor.
+    template <typename Event, typename HandleEvent>
+    merge<Event, HandleEvent> make_merge(
+        std::vector<std::pair<uint16_t, uint16_t>> offsets,
+        uint64_t maximum_lateness,
+        HandleEvent handle_event) {
+        return merge<Event, HandleEvent>(std::move(offsets), maximum_lateness, std::forward<HandleEvent>(handle_event));
+    }
+}
@@ -0,0 +1,573 @@
+#pragma once
+
+#include "erased_handler.hpp"
+#include "mask_isolated.hpp"
+#include "mirror_x.hpp"
+#include "mirror_y.hpp"
+#include "select_disk.hpp"
+#include "select_rectangle.hpp"
+#include "shift_x.hpp"
+#include "shift_y.hpp"
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <limits>
+#include <map>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+/// tarsier is a collection of event handlers.
+namespace tarsier {
+    /// json_value is a parsed JSON value.
+    class json_value {
+        public:
+        /// type lists the JSON types.
+        enum class type {
+            null,
+            boolean,
+            number,
+            string,
+            array,
+            object,
+        };
+
+        json_value() : _type(type::null), _boolean(false), _number(0.0) {}
+
+        /// get_type returns the value's JSON type.
+        type get_type() const {
+            return _type;
+        }
+
+        /// as_boolean returns the value of a boolean.
+        bool as_boolean() const {
+            check(type::boolean, "a boolean");
+            return _boolean;
+        }
+
+        /// as_number returns the value of a number.
+        double as_number() const {
+            check(type::number, "a number");
+            return _number;
+        }
+
+        /// as_integer returns the value of a number, which must be an integer representable by Integer.
+        /// The upper bound is the exact power of two max() + 1, since max() rounds up to it for 64-bit types.
+        template <typename Integer>
+        Integer as_integer() const {
+            check(type::number, "a number");
+            if (std::floor(_number) != _number
+                || _number < static_cast<double>(std::numeric_limits<Integer>::lowest())
+                || _number >= std::ldexp(1.0, std::numeric_limits<Integer>::digits)) {
+                throw std::runtime_error("the number is not a valid integer for this parameter");
+            }
+            return static_cast<Integer>(_number);
+        }
+
+        /// as_string returns the value of a string.
+        const std::string& as_string() const {
+            check(type::string, "a string");
+            return _string;
+        }
+
+        /// as_array returns the elements of an array.
+        const std::vector<json_value>& as_array() const {
+            check(type::array, "an array");
+            return _array;
+        }
+
+        /// as_object returns the members of an object, in the document order.
+        const std::vector<std::pair<std::string, json_value>>& as_object() const {
+            check(type::object, "an object");
+            return _object;
+        }
+
+        /// contains determines whether an object has the given member.
+        bool contains(const std::string& key) const {
+            for (const auto& member : as_object()) {
+                if (member.first == key) {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        /// at returns the given member of an object.
+        const json_value& at(const std::string& key) const {
+            for (const auto& member : as_object()) {
+                if (member.first == key) {
+                    return member.second;
+                }
+            }
+            throw std::runtime_error(std::string("the object has no member \"") + key + "\"");
+        }
+
+        /// parse_json reads a JSON document.
+        friend json_value parse_json(const std::string& document);
+
+        protected:
+        /// parser reads a JSON document recursively.
+        class parser {
+            public:
+            parser(const std::string& document) : _document(document), _position(0) {}
+
+            /// parse_document reads the whole document.
+            json_value parse_document() {
+                auto value = parse_value(0);
+                skip_whitespace();
+                if (_position != _document.size()) {
+                    fail("unexpected characters after the value");
+                }
+                return value;
+            }
+
+            protected:
+            /// parse_value reads any value.
+            json_value parse_value(std::size_t depth) {
+                if (depth > 256) {
+                    fail("the document is nested too deeply");
+                }
+                skip_whitespace();
+                if (_position == _document.size()) {
+                    fail("unexpected end of document");
+                }
+                json_value value;
+                switch (_document[_position]) {
+                    case '{':
+                        value._type = type::object;
+                        ++_position;
+                        skip_whitespace();
+                        if (!consume('}')) {
+                            for (;;) {
+                                skip_whitespace();
+                                auto key = parse_string();
+                                skip_whitespace();
+                                expect(':');
+                                value._object.emplace_back(std::move(key), parse_value(depth + 1));
+                                skip_whitespace();
+                                if (consume('}')) {
+                                    break;
+                                }
+                                expect(',');
+                            }
+                        }
+                        break;
+                    case '[':
+                        value._type = type::array;
+                        ++_position;
+                        skip_whitespace();
+                        if (!consume(']')) {
+                            for (;;) {
+                                value._array.push_back(parse_value(depth + 1));
+                                skip_whitespace();
+                                if (consume(']')) {
+                                    break;
+                                }
+                                expect(',');
+                            }
+                        }
+                        break;
+                    case '"':
+                        value._type = type::string;
+                        value._string = parse_string();
+                        break;
+                    case 't':
+                        parse_literal("true");
+                        value._type = type::boolean;
+                        value._boolean = true;
+                        break;
+                    case 'f':
+                        parse_literal("false");
+                        value._type = type::boolean;
+                        break;
+                    case 'n':
+                        parse_literal("null");
+                        break;
+                    default:
+                        value._type = type::number;
+                        value._number = parse_number();
+                }
+                return value;
+            }
+
+            /// parse_string reads a string, including the quotes.
+            std::string parse_string() {
+                expect('"');
+                std::string result;
+                for (;;) {
+                    if (_position == _document.size()) {
+                        fail("unterminated string");
+                    }
+                    const auto character = _document[_position++];
+                    if (character == '"') {
+                        return result;
+                    }
+                    if (static_cast<unsigned char>(character) < 0x20) {
+                        fail("control character in a string");
+                    }
+                    if (character != '\\') {
+                        result.push_back(character);
+                        continue;
+                    }
+                    if (_position == _document.size()) {
+                        fail("unterminated string");
+                    }
+                    switch (_document[_position++]) {
+                        case '"':
+                            result.push_back('"');
+                            break;
+                        case '\\':
+                            result.push_back('\\');
+                            break;
+                        case '/':
+                            result.push_back('/');
+                            break;
+                        case 'b':
+                            result.push_back('\b');
+                            break;
+                        case 'f':
+                            result.push_back('\f');
+                            break;
+                        case 'n':
+                            result.push_back('\n');
+                            break;
+                        case 'r':
+                            result.push_back('\r');
+                            break;
+                        case 't':
+                            result.push_back('\t');
+                            break;
+                        case 'u': {
+                            const auto code_point = parse_hexadecimal();
+                            if (code_point < 0x80) {
+                                result.push_back(static_cast<char>(code_point));
+                            } else if (code_point < 0x800) {
+                                result.push_back(static_cast<char>(0xc0 | (code_point >> 6)));
+                                result.push_back(static_cast<char>(0x80 | (code_point & 0x3f)));
+                            } else {
+                                result.push_back(static_cast<char>(0xe0 | (code_point >> 12)));
+                                result.push_back(static_cast<char>(0x80 | ((code_point >> 6) & 0x3f)));
+                                result.push_back(static_cast<char>(0x80 | (code_point & 0x3f)));
+                            }
+                            break;
+                        }
+                        default:
+                            fail("unknown escape sequence");
+                    }
+                }
+            }
+
+            /// parse_hexadecimal reads the four digits of a \u escape sequence.
+            uint32_t parse_hexadecimal() {
+                if (_document.size() - _position < 4) {
+                    fail("truncated escape sequence");
+                }
+                uint32_t code_point = 0;
+                for (std::size_t index = 0; index < 4; ++index) {
+                    const auto character = _document[_position++];
+                    code_point <<= 4;
+                    if (character >= '0' && character <= '9') {
+                        code_point |= static_cast<uint32_t>(character - '0');
+                    } else if (character >= 'a' && character <= 'f') {
+                        code_point |= static_cast<uint32_t>(character - 'a' + 10);
+                    } else if (character >= 'A' && character <= 'F') {
+                        code_point |= static_cast<uint32_t>(character - 'A' + 10);
+                    } else {
+                        fail("invalid escape sequence");
+                    }
+                }
+                return code_point;
+            }
+
+            /// parse_number reads a number with the JSON grammar.
+            double parse_number() {
+                const auto begin = _position;
+                consume('-');
+                if (!consume('0') && !consume_digits()) {
+                    fail("unexpected character");
+                }
+                if (consume('.') && !consume_digits()) {
+                    fail("invalid number");
+                }
+                if (consume('e') || consume('E')) {
+                    if (!consume('+')) {
+                        consume('-');
+                    }
+                    if (!consume_digits()) {
+                        fail("invalid number");
+                    }
+                }
+                return std::strtod(_document.substr(begin, _position - begin).c_str(), nullptr);
+            }
+
+            /// parse_literal reads true, false or null.
+            void parse_literal(const std::string& literal) {
+                if (_document.compare(_position, literal.size(), literal) != 0) {
+                    fail("unexpected character");
+                }
+                _position += literal.size();
+            }
+
+            /// consume_digits skips digits, and returns false if there are none.
+            bool consume_digits() {
+                const auto begin = _position;
+                while (_position < _document.size() && _document[_position] >= '0' && _document[_position] <= '9') {
+                    ++_position;
+                }
+                return _position > begin;
+            }
+
+            /// consume skips the given character if it is the next one.
+            bool consume(char character) {
+                if (_position < _document.size() && _document[_position] == character) {
+                    ++_position;
+                    return true;
+                }
+                return false;
+            }
+
+            /// expect skips the given character, which must be the next one.
+            void expect(char character) {
+                if (!consume(character)) {
+                    fail(std::string("expected '") + character + "'");
+                }
+            }
+
+            /// skip_whitespace skips spaces, tabulations and line breaks.
+            void skip_whitespace() {
+                while (_position < _document.size()
+                       && (_document[_position] == ' ' || _document[_position] == '\t'
+                           || _document[_position] == '\n' || _document[_position] == '\r')) {
+                    ++_position;
+                }
+            }
+
+            /// fail throws a parse error.
+            [[noreturn]] void fail(const std::string& message) const {
+                throw std::runtime_error(
+                    std::string("JSON parse error at character ") + std::to_string(_position) + ": " + message);
+            }
+
+            const std::string& _document;
+            std::size_t _position;
+        };
+
+        /// check throws if the value does not have the given type.
+        void check(type expected_type, const char* name) const {
+            if (_type != expected_type) {
+                throw std::runtime_error(std::string("the JSON value is not ") + name);
+            }
+        }
+
+        type _type;
+        bool _boolean;
+        double _number;
+        std::string _string;
+        std::vector<json_value> _array;
+        std::vector<std::pair<std::string, json_value>> _object;
+    };
+
+    /// parse_json reads a JSON document.
+    inline json_value parse_json(const std::string& document) {
+        return json_value::parser(document).parse_document();
+    }
+
+    /// pipeline_sink appends a handler's output events to a buffer.
+    template <typename Event>
+    class pipeline_sink {
+        public:
+        pipeline_sink(std::vector<Event>* events) : _events(events) {}
+
+        /// operator() handles an event.
+        void operator()(Event event) {
+            _events->push_back(event);
+        }
+
+        protected:
+        std::vector<Event>* _events;
+    };
+
+    /// pipeline_stage runs a handler over batches of events, and passes its output to the next stage in one batch.
+    /// Handler must write its output events to a pipeline_sink bound to buffer. The handler is stored by value, so
+    /// its operator() is resolved at compile time, and the stage costs one indirect call per batch.
+    template <typename Event, typename Handler>
+    class pipeline_stage {
+        public:
+        pipeline_stage(Handler handler, std::unique_ptr<std::vector<Event>> buffer, erased_handler<Event> next) :
+            _handler(std::forward<Handler>(handler)),
+            _buffer(std::move(buffer)),
+            _next(std::move(next)) {}
+        pipeline_stage(const pipeline_stage&) = delete;
+        pipeline_stage(pipeline_stage&&) = default;
+        pipeline_stage& operator=(const pipeline_stage&) = delete;
+        pipeline_stage& operator=(pipeline_stage&&) = default;
+        virtual ~pipeline_stage() {}
+
+        /// operator() handles an event.
+        void operator()(Event event) {
+            _handler(event);
+            flush();
+        }
+
+        /// operator() handles a batch of events.
+        void operator()(const Event* events, std::size_t count) {
+            for (std::size_t index = 0; index < count; ++index) {
+                _handler(events[index]);
+            }
+            flush();
+        }
+
+        protected:
+        /// flush sends the buffered output to the next stage.
+        void flush() {
+            if (!_buffer->empty()) {
+                _next(_buffer->data(), _buffer->size());
+                _buffer->clear();
+            }
+        }
+
+        Handler _handler;
+        std::unique_ptr<std::vector<Event>> _buffer;
+        erased_handler<Event> _next;
+    };
+
+    /// make_pipeline_stage creates an erased pipeline_stage.
+    /// make_handler is called with a pipeline_sink and must return the stage's handler.
+    template <typename Event, typename MakeHandler>
+    erased_handler<Event> make_pipeline_stage(MakeHandler make_handler, erased_handler<Event> next) {
+        std::unique_ptr<std::vector<Event>> buffer(new std::vector<Event>());
+        auto handler = make_handler(pipeline_sink<Event>(buffer.get()));
+        return erased_handler<Event>(
+            pipeline_stage<Event, decltype(handler)>(std::move(handler), std::move(buffer), std::move(next)));
+    }
+
+    /// pipeline_stages maps stage types to functions that build a stage from its JSON parameters and the next stage.
+    template <typename Event>
+    using pipeline_stages =
+        std::map<std::string, std::function<erased_handler<Event>(const json_value&, erased_handler<Event>)>>;
+
+    /// default_pipeline_stages returns the built-in stage types.
+    /// Parameters have the names of the corresponding make_* arguments, and all of them are required.
+    template <typename Event>
+    pipeline_stages<Event> default_pipeline_stages() {
+        pipeline_stages<Event> stages;
+        stages["select_rectangle"] = [](const json_value& parameters, erased_handler<Event> next) {
+            const auto left = parameters.at("left").as_integer<uint16_t>();
+            const auto bottom = parameters.at("bottom").as_integer<uint16_t>();
+            const auto width = parameters.at("width").as_integer<uint16_t>();
+            const auto height = parameters.at("height").as_integer<uint16_t>();
+            return make_pipeline_stage<Event>(
+                [&](pipeline_sink<Event> sink) {
+                    return make_select_rectangle<Event>(left, bottom, width, height, sink);
+                },
+                std::move(next));
+        };
+        stages["select_disk"] = [](const json_value& parameters, erased_handler<Event> next) {
+            const auto x = static_cast<float>(parameters.at("x").as_number());
+            const auto y = static_cast<float>(parameters.at("y").as_number());
+            const auto radius = static_cast<float>(parameters.at("radius").as_number());
+            return make_pipeline_stage<Event>(
+                [&](pipeline_sink<Event> sink) { return make_select_disk<Event>(x, y, radius, sink); },
+                std::move(next));
+        };
+        stages["mirror_x"] = [](const json_value& parameters, erased_handler<Event> next) {
+            const auto width = parameters.at("width").as_integer<uint16_t>();
+            return make_pipeline_stage<Event>(
+                [&](pipeline_sink<Event> sink) { return make_mirror_x<Event>(width, sink); }, std::move(next));
+        };
+        stages["mirror_y"] = [](const json_value& parameters, erased_handler<Event> next) {
+            const auto height = parameters.at("height").as_integer<uint16_t>();
+            return make_pipeline_stage<Event>(
+                [&](pipeline_sink<Event> sink) { return make_mirror_y<Event>(height, sink); }, std::move(next));
+        };
+        stages["shift_x"] = [](const json_value& parameters, erased_handler<Event> next) {
+            const auto width = parameters.at("width").as_integer<uint16_t>();
+            const auto shift = parameters.at("shift").as_integer<int32_t>();
+            return make_pipeline_stage<Event>(
+                [&](pipeline_sink<Event> sink) { return make_shift_x<Event>(width, shift, sink); }, std::move(next));
+        };
+        stages["shift_y"] = [](const json_value& parameters, erased_handler<Event> next) {
+            const auto height = parameters.at("height").as_integer<uint16_t>();
+            const auto shift = parameters.at("shift").as_integer<int32_t>();
+            return make_pipeline_stage<Event>(
+                [&](pipeline_sink<Event> sink) { return make_shift_y<Event>(height, shift, sink); }, std::move(next));
+        };
+        stages["mask_isolated"] = [](const json_value& parameters, erased_handler<Event> next) {
+            const auto width = parameters.at("width").as_integer<uint16_t>();
+            const auto height = parameters.at("height").as_integer<uint16_t>();
+            const auto temporal_window = parameters.at("temporal_window").as_integer<uint64_t>();
+            return make_pipeline_stage<Event>(
+                [&](pipeline_sink<Event> sink) {
+                    return make_mask_isolated<Event>(width, height, temporal_window, sink);
+                },
+                std::move(next));
+        };
+        return stages;
+    }
+
+    /// pipeline chains handlers described by a JSON document at runtime.
+    /// The document is an object with a "stages" array. Each stage is an object with a "type" (a key of stages)
+    /// and the parameters expected by this type. Events go through the stages in order, then reach handle_event.
+    /// Batches of events cost one indirect call per stage, hence feeding the pipeline with batches (for instance,
+    /// the events decoded from a buffer) amortises the type erasure.
+    template <typename Event>
+    class pipeline {
+        public:
+        pipeline(
+            const std::string& description,
+            erased_handler<Event> handle_event,
+            const pipeline_stages<Event>& stages = default_pipeline_stages<Event>()) :
+            _first(build(parse_json(description), std::move(handle_event), stages)) {}
+        pipeline(const pipeline&) = delete;
+        pipeline(pipeline&&) = default;
+        pipeline& operator=(const pipeline&) = delete;
+        pipeline& operator=(pipeline&&) = default;
+        virtual ~pipeline() {}
+
+        /// operator() handles an event.
+        void operator()(Event event) {
+            _first(event);
+        }
+
+        /// operator() handles a batch of events.
+        void operator()(const Event* events, std::size_t count) {
+            _first(events, count);
+        }
+
+        protected:
+        /// build creates the stages from the last one to the first one.
+        static erased_handler<Event>
+        build(const json_value& description, erased_handler<Event> handle_event, const pipeline_stages<Event>& stages) {
+            const auto& stage_descriptions = description.at("stages").as_array();
+            auto next = std::move(handle_event);
+            for (auto stage_iterator = stage_descriptions.rbegin(); stage_iterator != stage_descriptions.rend();
+                 ++stage_iterator) {
+                const auto& type = stage_iterator->at("type").as_string();
+                const auto stage = stages.find(type);
+                if (stage == stages.end()) {
+                    throw std::runtime_error(std::string("unknown stage type \"") + type + "\"");
+                }
+                next = stage->second(*stage_iterator, std::move(next));
+            }
+            return next;
+        }
+
+        erased_handler<Event> _first;
+    };
+
+    /// make_pipeline creates a pipeline from a JSON description and a functor.
+    template <typename Event, typename HandleEvent>
+    pipeline<Event> make_pipeline(const std::string& description, HandleEvent handle_event) {
+        return pipeline<Event>(description, erased_handler<Event>(std::forward<HandleEvent>(handle_event)));
+    }
+
+    /// make_pipeline creates a pipeline from a JSON description, custom stage types and a functor.
+    template <typename Event, typename HandleEvent>
+    pipeline<Event>
+    make_pipeline(const std::string& description, const pipeline_stages<Event>& stages, HandleEvent handle_event) {
+        return pipeline<Event>(description, erased_handler<Event>(std::forward<HandleEvent>(handle_event)), stages);
+    }
+}
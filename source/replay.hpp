@@ -0,0 +1,146 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <iterator>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+
+/// tarsier is a collection of event handlers.
+namespace tarsier {
+    /// replay_chunk stores the outputs generated while processing a chunk of a recording.
+    template <typename Output>
+    struct replay_chunk {
+        std::vector<Output> outputs;
+        bool warming_up;
+        bool done;
+    };
+
+    /// replay_sink collects the outputs of a chunk's handler, ignoring those generated during the warm-up.
+    template <typename Output>
+    class replay_sink {
+        public:
+        replay_sink(replay_chunk<Output>& chunk) : _chunk(&chunk) {}
+        replay_sink(const replay_sink&) = default;
+        replay_sink(replay_sink&&) = default;
+        replay_sink& operator=(const replay_sink&) = default;
+        replay_sink& operator=(replay_sink&&) = default;
+        virtual ~replay_sink() {}
+
+        /// operator() handles an output.
+        virtual void operator()(Output output) {
+            if (!_chunk->warming_up) {
+                _chunk->outputs.push_back(output);
+            }
+        }
+
+        protected:
+        replay_chunk<Output>* _chunk;
+    };
+
+    /// replay processes a recording in parallel, and propagates the outputs in the same order as a serial run.
+    /// The events in [begin, end) must be sorted by timestamp. They are split into chunks of chunk_duration
+    /// microseconds, and each chunk is processed by a new handler created by make_handler(replay_sink<Output>).
+    /// Before processing its chunk, a handler is warmed up with the preceding warm_up_duration microseconds of
+    /// events (the handler's temporal window or decay horizon), and its outputs are ignored during the warm-up.
+    /// The outputs are passed to handle_output on the calling thread, chunk after chunk, as soon as they are ready.
+    template <typename Output, typename Iterator, typename MakeHandler, typename HandleOutput>
+    void replay(
+        Iterator begin,
+        Iterator end,
+        uint64_t chunk_duration,
+        uint64_t warm_up_duration,
+        std::size_t number_of_threads,
+        MakeHandler make_handler,
+        HandleOutput handle_output) {
+        if (chunk_duration == 0) {
+            throw std::logic_error("chunk_duration must be larger than zero");
+        }
+        if (number_of_threads == 0) {
+            throw std::logic_error("number_of_threads must be larger than zero");
+        }
+        if (begin == end) {
+            return;
+        }
+        typedef decltype(*begin) event_reference;
+        const uint64_t first_t = begin->t;
+        const uint64_t last_t = std::prev(end)->t;
+        const auto lower_bound = [&](uint64_t t) -> Iterator {
+            return std::lower_bound(
+                begin, end, t, [](event_reference event, uint64_t t) -> bool { return event.t < t; });
+        };
+        std::vector<replay_chunk<Output>> chunks((last_t - first_t) / chunk_duration + 1);
+        std::atomic<std::size_t> next_chunk(0);
+        std::atomic<bool> failed(false);
+        std::exception_ptr exception;
+        std::mutex mutex;
+        std::condition_variable chunk_done;
+        const auto work = [&]() {
+            for (;;) {
+                const auto index = next_chunk.fetch_add(1);
+                if (index >= chunks.size() || failed.load()) {
+                    return;
+                }
+                auto& chunk = chunks[index];
+                try {
+                    const uint64_t chunk_t = first_t + index * chunk_duration;
+                    auto handler = make_handler(replay_sink<Output>(chunk));
+                    const auto chunk_begin = lower_bound(chunk_t);
+                    const auto chunk_end = lower_bound(chunk_t + chunk_duration);
+                    chunk.warming_up = true;
+                    for (auto event_iterator =
+                             lower_bound(chunk_t - std::min(warm_up_duration, chunk_t - first_t));
+                         event_iterator != chunk_begin;
+                         ++event_iterator) {
+                        handler(*event_iterator);
+                    }
+                    chunk.warming_up = false;
+                    for (auto event_iterator = chunk_begin; event_iterator != chunk_end; ++event_iterator) {
+                        handler(*event_iterator);
+                    }
+                } catch (...) {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    if (!failed.load()) {
+                        exception = std::current_exception();
+                        failed.store(true);
+                    }
+                }
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    chunk.done = true;
+                }
+                chunk_done.notify_one();
+            }
+        };
+        std::vector<std::thread> threads;
+        threads.reserve(std::min(number_of_threads, chunks.size()));
+        for (std::size_t index = 0; index < std::min(number_of_threads, chunks.size()); ++index) {
+            threads.emplace_back(work);
+        }
+        for (auto& chunk : chunks) {
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                chunk_done.wait(lock, [&]() { return chunk.done || failed.load(); });
+                if (failed.load()) {
+                    break;
+                }
+            }
+            for (auto output : chunk.outputs) {
+                handle_output(output);
+            }
+            std::vector<Output>().swap(chunk.outputs);
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        if (exception) {
+            std::rethrow_exception(exception);
+        }
+    }
+}
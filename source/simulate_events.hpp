@@ -0,0 +1,574 @@
+#pragma once
+
+#include "erased_handler.hpp"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <istream>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <random>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+
+/// tarsier is a collection of event handlers.
+namespace tarsier {
+    /// simulate_events converts greyscale frames into DVS events and ATIS threshold crossings, to feed pipelines with
+    /// realistic streams at controlled rates and resolutions.
+    /// Each pixel fires an event whenever its log intensity, linearly interpolated between frames, moves by its
+    /// contrast threshold away from the level of its last event. The ON and OFF thresholds of each pixel are drawn
+    /// from a normal distribution (contrast_threshold, threshold_mismatch). Background noise events follow a Poisson
+    /// process with noise_rate events per second per pixel. The signal and noise events of each pixel are sorted by
+    /// timestamp, and events closer than refractory_period to the previous event of the pixel are dropped. If exposure
+    /// is not zero, each event also triggers an exposure measurement (unless
+    /// the pixel is already measuring): a pair of threshold crossings, compatible with stitch, separated by
+    /// exposure * 255 / intensity microseconds.
+    /// Rows are simulated by number_of_threads threads, created once and reused for every frame, and the outputs do
+    /// not depend on the number of threads. Each thread sorts its events, and the sorted runs are merged with a heap.
+    /// If handle_event accepts batches (const Event*, std::size_t, see has_batch_call), the merged events are passed
+    /// in batches, split before each threshold crossing so that both streams keep their relative order.
+    /// Event must be an aggregate initialisable with {t, x, y, is_increase}, and ThresholdCrossing with
+    /// {t, x, y, is_second}.
+    template <typename Event, typename ThresholdCrossing, typename HandleEvent, typename HandleThresholdCrossing>
+    class simulate_events {
+        public:
+        simulate_events(
+            uint16_t width,
+            uint16_t height,
+            float contrast_threshold,
+            float threshold_mismatch,
+            float noise_rate,
+            uint64_t refractory_period,
+            uint64_t exposure,
+            std::size_t number_of_threads,
+            uint64_t seed,
+            HandleEvent handle_event,
+            HandleThresholdCrossing handle_threshold_crossing) :
+            _width(width),
+            _height(height),
+            _noise_rate(noise_rate),
+            _refractory_period(refractory_period),
+            _exposure(exposure),
+            _number_of_threads(number_of_threads),
+            _seed(seed),
+            _handle_event(std::forward<HandleEvent>(handle_event)),
+            _handle_threshold_crossing(std::forward<HandleThresholdCrossing>(handle_threshold_crossing)),
+            _logs(static_cast<std::size_t>(width) * height),
+            _references(static_cast<std::size_t>(width) * height),
+            _on_thresholds(static_cast<std::size_t>(width) * height),
+            _off_thresholds(static_cast<std::size_t>(width) * height),
+            _next_ts(static_cast<std::size_t>(width) * height, 0),
+            _exposure_ends(static_cast<std::size_t>(width) * height, 0),
+            _unsorted_outputs(number_of_threads),
+            _outputs(number_of_threads),
+            _counts(number_of_threads),
+            _workers(new workers(number_of_threads)),
+            _t(0),
+            _frame_index(0) {
+            if (contrast_threshold <= 0.0f) {
+                throw std::logic_error("contrast_threshold must be larger than zero");
+            }
+            if (noise_rate < 0.0f) {
+                throw std::logic_error("noise_rate must be larger than or equal to zero");
+            }
+            if (number_of_threads == 0) {
+                throw std::logic_error("number_of_threads must be larger than zero");
+            }
+            for (std::size_t level = 0; level < _log_table.size(); ++level) {
+                _log_table[level] = std::log(static_cast<float>(level) + 1.0f);
+            }
+            std::mt19937_64 engine(seed);
+            std::normal_distribution<float> threshold_distribution(contrast_threshold, threshold_mismatch);
+            for (std::size_t index = 0; index < _on_thresholds.size(); ++index) {
+                _on_thresholds[index] = std::max(threshold_distribution(engine), minimum_threshold);
+                _off_thresholds[index] = std::max(threshold_distribution(engine), minimum_threshold);
+            }
+        }
+        simulate_events(const simulate_events&) = delete;
+        simulate_events(simulate_events&&) = default;
+        simulate_events& operator=(const simulate_events&) = delete;
+        simulate_events& operator=(simulate_events&&) = default;
+        virtual ~simulate_events() {}
+
+        /// operator() handles a frame (width * height bytes, row-major) taken at time t.
+        /// The first frame sets the initial state, and the following ones generate the events in ]previous t, t].
+        virtual void operator()(uint64_t t, const uint8_t* frame) {
+            if (_frame_index == 0) {
+                for (std::size_t index = 0; index < _logs.size(); ++index) {
+                    _logs[index] = _log_table[frame[index]];
+                    _references[index] = _logs[index];
+                }
+            } else {
+                if (t <= _t) {
+                    throw std::logic_error("the frames timestamps must be strictly increasing");
+                }
+                simulate(t, frame);
+                emit();
+            }
+            _t = t;
+            ++_frame_index;
+            flush_threshold_crossings(_t);
+        }
+
+        /// flush propagates the pending second threshold crossings, after the last frame.
+        void flush() {
+            flush_threshold_crossings(std::numeric_limits<uint64_t>::max());
+        }
+
+        /// width returns the number of pixels along the x axis.
+        uint16_t width() const {
+            return _width;
+        }
+
+        /// height returns the number of pixels along the y axis.
+        uint16_t height() const {
+            return _height;
+        }
+
+        protected:
+        /// minimum_threshold bounds the number of events generated by a frame.
+        static constexpr float minimum_threshold = 0.01f;
+
+        /// maximum_number_of_buckets is the largest frame duration sorted with a counting sort.
+        static constexpr uint64_t maximum_number_of_buckets = 1 << 16;
+
+        /// simulated_event is an event generated by a worker, before sorting.
+        /// The events are sorted by timestamp, then by row, then in generation order, which does not depend on the
+        /// number of threads since each row is generated by a single worker.
+        struct simulated_event {
+            uint64_t t;
+            uint16_t x;
+            uint16_t y;
+            bool is_increase;
+            uint8_t intensity;
+
+            bool operator<(const simulated_event& other) const {
+                return t < other.t || (t == other.t && y < other.y);
+            }
+        };
+
+        /// random_engine is a splitmix64 generator, seeded per row and per frame so that the outputs do not depend
+        /// on the number of threads.
+        class random_engine {
+            public:
+            random_engine(uint64_t state) : _state(state) {}
+
+            /// next returns a uniformly distributed 64-bit integer.
+            uint64_t next() {
+                _state += 0x9e3779b97f4a7c15ull;
+                auto value = _state;
+                value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9ull;
+                value = (value ^ (value >> 27)) * 0x94d049bb133111ebull;
+                return value ^ (value >> 31);
+            }
+
+            /// uniform returns a uniformly distributed number in ]0, 1].
+            float uniform() {
+                return (static_cast<float>(next() >> 40) + 1.0f) / 16777216.0f;
+            }
+
+            protected:
+            uint64_t _state;
+        };
+
+        /// workers runs a task on persistent threads, so that no thread is created per frame.
+        class workers {
+            public:
+            workers(std::size_t number_of_threads) : _task(nullptr), _generation(0), _remaining(0), _running(true) {
+                for (std::size_t thread_index = 1; thread_index < number_of_threads; ++thread_index) {
+                    _threads.emplace_back([this, thread_index]() { loop(thread_index); });
+                }
+            }
+            workers(const workers&) = delete;
+            workers(workers&&) = delete;
+            workers& operator=(const workers&) = delete;
+            workers& operator=(workers&&) = delete;
+            virtual ~workers() {
+                {
+                    std::lock_guard<std::mutex> lock(_mutex);
+                    _running = false;
+                }
+                _start.notify_all();
+                for (auto& thread : _threads) {
+                    thread.join();
+                }
+            }
+
+            /// run calls task(thread_index) for every thread, and returns when all the calls are done.
+            /// The calling thread has the index 0. The task must not throw.
+            void run(const std::function<void(std::size_t)>& task) {
+                {
+                    std::lock_guard<std::mutex> lock(_mutex);
+                    _task = &task;
+                    _remaining = _threads.size();
+                    ++_generation;
+                }
+                _start.notify_all();
+                task(0);
+                std::unique_lock<std::mutex> lock(_mutex);
+                _done.wait(lock, [this]() { return _remaining == 0; });
+            }
+
+            protected:
+            /// loop waits for tasks and runs them until the workers are destroyed.
+            void loop(std::size_t thread_index) {
+                uint64_t generation = 0;
+                for (;;) {
+                    const std::function<void(std::size_t)>* task;
+                    {
+                        std::unique_lock<std::mutex> lock(_mutex);
+                        _start.wait(lock, [&]() { return !_running || _generation != generation; });
+                        if (!_running) {
+                            return;
+                        }
+                        generation = _generation;
+                        task = _task;
+                    }
+                    (*task)(thread_index);
+                    bool done;
+                    {
+                        std::lock_guard<std::mutex> lock(_mutex);
+                        --_remaining;
+                        done = _remaining == 0;
+                    }
+                    if (done) {
+                        _done.notify_one();
+                    }
+                }
+            }
+
+            std::vector<std::thread> _threads;
+            std::mutex _mutex;
+            std::condition_variable _start;
+            std::condition_variable _done;
+            const std::function<void(std::size_t)>* _task;
+            uint64_t _generation;
+            std::size_t _remaining;
+            bool _running;
+        };
+
+        /// run is a sorted run of simulated events, represented by its current and end positions.
+        typedef std::pair<const simulated_event*, const simulated_event*> run;
+
+        /// later returns whether the first run's current event comes after the second's (min-heap order).
+        static bool later(const run& first, const run& second) {
+            return *second.first < *first.first;
+        }
+
+        /// simulate generates the events of all the rows, using the worker threads.
+        void simulate(uint64_t t, const uint8_t* frame) {
+            const auto rows_per_thread = (_height + _number_of_threads - 1) / _number_of_threads;
+            std::vector<std::exception_ptr> exceptions(_number_of_threads);
+            const std::function<void(std::size_t)> work = [&](std::size_t thread_index) {
+                try {
+                    auto& outputs = _unsorted_outputs[thread_index];
+                    outputs.clear();
+                    const auto begin = std::min<std::size_t>(thread_index * rows_per_thread, _height);
+                    const auto end = std::min<std::size_t>(begin + rows_per_thread, _height);
+                    for (auto y = begin; y < end; ++y) {
+                        simulate_row(static_cast<uint16_t>(y), t, frame, outputs);
+                    }
+                    sort(t, outputs, _outputs[thread_index], _counts[thread_index]);
+                } catch (...) {
+                    exceptions[thread_index] = std::current_exception();
+                }
+            };
+            _workers->run(work);
+            for (auto exception : exceptions) {
+                if (exception) {
+                    std::rethrow_exception(exception);
+                }
+            }
+        }
+
+        /// sort orders a worker's events by timestamp, preserving the generation order of simultaneous events.
+        /// Events within a frame span at most t - previous t microseconds, hence a counting sort is used unless the
+        /// frames are far apart.
+        void sort(
+            uint64_t t,
+            const std::vector<simulated_event>& events,
+            std::vector<simulated_event>& sorted_events,
+            std::vector<std::size_t>& counts) {
+            const auto duration = t - _t;
+            if (duration > maximum_number_of_buckets) {
+                sorted_events = events;
+                std::stable_sort(sorted_events.begin(), sorted_events.end());
+                return;
+            }
+            counts.assign(static_cast<std::size_t>(duration) + 1, 0);
+            for (const auto& event : events) {
+                ++counts[event.t - _t];
+            }
+            std::size_t position = 0;
+            for (auto& count : counts) {
+                const auto bucket_count = count;
+                count = position;
+                position += bucket_count;
+            }
+            sorted_events.resize(events.size());
+            for (const auto& event : events) {
+                sorted_events[counts[event.t - _t]++] = event;
+            }
+        }
+
+        /// simulate_row generates the events of a row between the previous frame and the given one.
+        void simulate_row(uint16_t y, uint64_t t, const uint8_t* frame, std::vector<simulated_event>& outputs) {
+            const auto duration = static_cast<float>(t - _t);
+            random_engine engine(_seed ^ (_frame_index * 0xd1b54a32d192ed03ull) ^ (y * 0x8cb92ba72f3d8dd7ull));
+            const auto offset = static_cast<std::size_t>(y) * _width;
+            // the noise is a Poisson process over the row's pixels laid end to end in time, hence the noise
+            // position is measured in microseconds from the beginning of the first pixel
+            const auto span = static_cast<double>(t - _t);
+            const auto noise_rate = static_cast<double>(_noise_rate) * 1e-6;
+            auto noise_position = std::numeric_limits<double>::infinity();
+            if (noise_rate > 0.0) {
+                noise_position = -std::log(engine.uniform()) / noise_rate;
+            }
+            for (uint16_t x = 0; x < _width; ++x) {
+                const auto index = offset + x;
+                const auto begin = outputs.size();
+                const auto previous_log = _logs[index];
+                const auto log = _log_table[frame[index]];
+                _logs[index] = log;
+                auto reference = _references[index];
+                if (log >= reference + _on_thresholds[index]) {
+                    do {
+                        reference += _on_thresholds[index];
+                        outputs.push_back(simulated_event{
+                            crossing_t(reference, previous_log, log, duration), x, y, true, frame[index]});
+                    } while (log >= reference + _on_thresholds[index]);
+                } else if (log <= reference - _off_thresholds[index]) {
+                    do {
+                        reference -= _off_thresholds[index];
+                        outputs.push_back(simulated_event{
+                            crossing_t(reference, previous_log, log, duration), x, y, false, frame[index]});
+                    } while (log <= reference - _off_thresholds[index]);
+                }
+                _references[index] = reference;
+                const auto middle = outputs.size();
+                const auto pixel_begin = span * x;
+                for (; noise_position < pixel_begin + span; noise_position -= std::log(engine.uniform()) / noise_rate) {
+                    outputs.push_back(simulated_event{
+                        _t + 1 + std::min(static_cast<uint64_t>(noise_position - pixel_begin), t - _t - 1),
+                        x,
+                        y,
+                        (engine.next() & 1) == 1,
+                        frame[index]});
+                }
+                std::inplace_merge(outputs.begin() + begin, outputs.begin() + middle, outputs.end());
+                apply_refractory_period(index, begin, outputs);
+            }
+        }
+
+        /// crossing_t returns the time at which the interpolated log intensity reaches the reference.
+        uint64_t crossing_t(float reference, float previous_log, float log, float duration) const {
+            if (log == previous_log) {
+                return _t + static_cast<uint64_t>(duration);
+            }
+            const auto ratio = std::min(std::max((reference - previous_log) / (log - previous_log), 0.0f), 1.0f);
+            return _t + std::max(static_cast<uint64_t>(ratio * duration), static_cast<uint64_t>(1));
+        }
+
+        /// apply_refractory_period drops the events of a pixel (the outputs from begin, sorted by timestamp) that
+        /// are closer than refractory_period to the previous event of the pixel.
+        void apply_refractory_period(std::size_t index, std::size_t begin, std::vector<simulated_event>& outputs) {
+            auto end = begin;
+            for (auto position = begin; position < outputs.size(); ++position) {
+                if (outputs[position].t >= _next_ts[index]) {
+                    _next_ts[index] = outputs[position].t + _refractory_period;
+                    outputs[end] = outputs[position];
+                    ++end;
+                }
+            }
+            outputs.resize(end);
+        }
+
+        /// emit merges the workers' sorted outputs and propagates them in timestamp order.
+        /// A heap holds the run with the earliest event on top, and events are taken from it as long as they precede
+        /// the other runs' events. Rows are owned by a single worker, hence two runs never have equivalent events.
+        void emit() {
+            _runs.clear();
+            for (const auto& outputs : _outputs) {
+                if (!outputs.empty()) {
+                    _runs.emplace_back(outputs.data(), outputs.data() + outputs.size());
+                }
+            }
+            std::make_heap(_runs.begin(), _runs.end(), later);
+            while (!_runs.empty()) {
+                std::pop_heap(_runs.begin(), _runs.end(), later);
+                auto current = _runs.back();
+                _runs.pop_back();
+                do {
+                    propagate(*current.first);
+                    ++current.first;
+                } while (current.first != current.second && (_runs.empty() || *current.first < *_runs.front().first));
+                if (current.first != current.second) {
+                    _runs.push_back(current);
+                    std::push_heap(_runs.begin(), _runs.end(), later);
+                }
+            }
+            flush_events(batch_call());
+        }
+
+        /// batch_call is std::true_type if handle_event accepts batches of events.
+        typedef std::integral_constant<bool, has_batch_call<HandleEvent, Event>::value> batch_call;
+
+        /// propagate sends an event, and starts an exposure measurement if needed.
+        void propagate(const simulated_event& event) {
+            if (!_pending.empty() && _pending.top().first <= event.t) {
+                flush_events(batch_call());
+                flush_threshold_crossings(event.t);
+            }
+            handle_event(Event{event.t, event.x, event.y, event.is_increase}, batch_call());
+            if (_exposure > 0) {
+                auto& exposure_end = _exposure_ends[event.x + static_cast<std::size_t>(event.y) * _width];
+                if (event.t >= exposure_end) {
+                    flush_events(batch_call());
+                    exposure_end = event.t + _exposure * 255 / std::max(event.intensity, static_cast<uint8_t>(1));
+                    _handle_threshold_crossing(ThresholdCrossing{event.t, event.x, event.y, false});
+                    _pending.emplace(
+                        exposure_end, static_cast<uint32_t>(event.x) | (static_cast<uint32_t>(event.y) << 16));
+                }
+            }
+        }
+
+        /// handle_event appends an event to the batch, or sends it if handle_event does not accept batches.
+        void handle_event(Event event, std::true_type) {
+            _events.push_back(event);
+        }
+        void handle_event(Event event, std::false_type) {
+            _handle_event(event);
+        }
+
+        /// flush_events sends the batched events.
+        void flush_events(std::true_type) {
+            if (!_events.empty()) {
+                _handle_event(static_cast<const Event*>(_events.data()), _events.size());
+                _events.clear();
+            }
+        }
+        void flush_events(std::false_type) {}
+
+        /// flush_threshold_crossings propagates the pending second threshold crossings up to t.
+        void flush_threshold_crossings(uint64_t t) {
+            while (!_pending.empty() && _pending.top().first <= t) {
+                const auto t_and_position = _pending.top();
+                _pending.pop();
+                _handle_threshold_crossing(ThresholdCrossing{
+                    t_and_position.first,
+                    static_cast<uint16_t>(t_and_position.second & 0xffff),
+                    static_cast<uint16_t>(t_and_position.second >> 16),
+                    true});
+            }
+        }
+
+        const uint16_t _width;
+        const uint16_t _height;
+        const float _noise_rate;
+        const uint64_t _refractory_period;
+        const uint64_t _exposure;
+        const std::size_t _number_of_threads;
+        const uint64_t _seed;
+        HandleEvent _handle_event;
+        HandleThresholdCrossing _handle_threshold_crossing;
+        std::array<float, 256> _log_table;
+        std::vector<float> _logs;
+        std::vector<float> _references;
+        std::vector<float> _on_thresholds;
+        std::vector<float> _off_thresholds;
+        std::vector<uint64_t> _next_ts;
+        std::vector<uint64_t> _exposure_ends;
+        std::vector<std::vector<simulated_event>> _unsorted_outputs;
+        std::vector<std::vector<simulated_event>> _outputs;
+        std::vector<std::vector<std::size_t>> _counts;
+        std::vector<run> _runs;
+        std::vector<Event> _events;
+        std::unique_ptr<workers> _workers;
+        std::priority_queue<
+            std::pair<uint64_t, uint32_t>,
+            std::vector<std::pair<uint64_t, uint32_t>>,
+            std::greater<std::pair<uint64_t, uint32_t>>>
+            _pending;
+        uint64_t _t;
+        uint64_t _frame_index;
+    };
+
+    template <typename Event, typename ThresholdCrossing, typename HandleEvent, typename HandleThresholdCrossing>
+    constexpr float simulate_events<Event, ThresholdCrossing, HandleEvent, HandleThresholdCrossing>::minimum_threshold;
+
+    template <typename Event, typename ThresholdCrossing, typename HandleEvent, typename HandleThresholdCrossing>
+    constexpr uint64_t
+        simulate_events<Event, ThresholdCrossing, HandleEvent, HandleThresholdCrossing>::maximum_number_of_buckets;
+
+    /// make_simulate_events creates a simulate_events from functors.
+    template <typename Event, typename ThresholdCrossing, typename HandleEvent, typename HandleThresholdCrossing>
+    simulate_events<Event, ThresholdCrossing, HandleEvent, HandleThresholdCrossing> make_simulate_events(
+        uint16_t width,
+        uint16_t height,
+        float contrast_threshold,
+        float threshold_mismatch,
+        float noise_rate,
+        uint64_t refractory_period,
+        uint64_t exposure,
+        std::size_t number_of_threads,
+        uint64_t seed,
+        HandleEvent handle_event,
+        HandleThresholdCrossing handle_threshold_crossing) {
+        return simulate_events<Event, ThresholdCrossing, HandleEvent, HandleThresholdCrossing>(
+            width,
+            height,
+            contrast_threshold,
+            threshold_mismatch,
+            noise_rate,
+            refractory_period,
+            exposure,
+            number_of_threads,
+            seed,
+            std::forward<HandleEvent>(handle_event),
+            std::forward<HandleThresholdCrossing>(handle_threshold_crossing));
+    }
+
+    /// simulate_raw_frames reads frames (width * height bytes each, row-major) from a stream and passes them to
+    /// a simulate_events, with frame_duration microseconds between consecutive frames.
+    template <typename SimulateEvents>
+    void simulate_raw_frames(std::istream& stream, uint64_t frame_duration, SimulateEvents& simulate_events) {
+        std::vector<uint8_t> frame(static_cast<std::size_t>(simulate_events.width()) * simulate_events.height());
+        for (uint64_t t = 0;; t += frame_duration) {
+            stream.read(reinterpret_cast<char*>(frame.data()), frame.size());
+            if (stream.gcount() != static_cast<std::streamsize>(frame.size())) {
+                break;
+            }
+            simulate_events(t, frame.data());
+        }
+        simulate_events.flush();
+    }
+
+    /// render_grating draws a sinusoidal grating drifting at speed pixels per second, a procedural scene for
+    /// simulate_events. The bars are tilted by slope pixels along x per pixel along y.
+    inline void render_grating(
+        std::vector<uint8_t>& frame,
+        uint16_t width,
+        uint16_t height,
+        uint64_t t,
+        float period,
+        float speed,
+        float slope) {
+        frame.resize(static_cast<std::size_t>(width) * height);
+        const auto shift = speed * static_cast<float>(t) * 1e-6f;
+        const auto angular_frequency = 6.283185307179586f / period;
+        for (uint16_t y = 0; y < height; ++y) {
+            for (uint16_t x = 0; x < width; ++x) {
+                frame[x + static_cast<std::size_t>(y) * width] = static_cast<uint8_t>(
+                    127.5f + 127.0f * std::sin(angular_frequency * (static_cast<float>(x) + slope * y - shift)));
+            }
+        }
+    }
+}
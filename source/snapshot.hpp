@@ -0,0 +1,55 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+/// tarsier is a collection of event handlers.
+namespace tarsier {
+    /// snapshot passes values from a writer thread to a reader thread without locks (triple buffering).
+    /// The writer fills back() and calls publish(). The reader calls load() to get the most recently published value.
+    /// Each buffer is owned by one side at a time, and ownership changes with a single atomic exchange, so neither
+    /// thread ever waits for the other. There must be at most one writer and one reader.
+    template <typename Value>
+    class snapshot {
+        public:
+        snapshot() : snapshot(Value()) {}
+        snapshot(const Value& value) : _values{{value, value, value}}, _back(0), _middle(1), _front(2) {}
+        snapshot(const snapshot&) = delete;
+        snapshot(snapshot&&) = delete;
+        snapshot& operator=(const snapshot&) = delete;
+        snapshot& operator=(snapshot&&) = delete;
+        virtual ~snapshot() {}
+
+        /// back returns the value owned by the writer.
+        Value& back() {
+            return _values[_back];
+        }
+
+        /// publish makes the writer's value available to the reader.
+        void publish() {
+            _back = _middle.exchange(_back | fresh, std::memory_order_acq_rel) & index_mask;
+        }
+
+        /// load returns the most recently published value.
+        /// The reference remains valid and unchanged until the next call to load.
+        const Value& load() {
+            if ((_middle.load(std::memory_order_relaxed) & fresh) != 0) {
+                _front = _middle.exchange(_front, std::memory_order_acq_rel) & index_mask;
+            }
+            return _values[_front];
+        }
+
+        protected:
+        /// fresh flags a middle buffer that has not been read yet.
+        static constexpr uint8_t fresh = 4;
+
+        /// index_mask extracts a buffer index.
+        static constexpr uint8_t index_mask = 3;
+
+        std::array<Value, 3> _values;
+        uint8_t _back;
+        std::atomic<uint8_t> _middle;
+        uint8_t _front;
+    };
+}
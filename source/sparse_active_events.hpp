@@ -0,0 +1,271 @@
+#pragma once
+
+#include "active_events.hpp"
+#include "state.hpp"
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+/// tarsier is a collection of event handlers.
+namespace tarsier {
+    /// sparse_active_events is a surface of active events that allocates memory only for active 8 x 8 blocks.
+    /// It can replace active_events when most of a large (or multi-sensor) coordinate space is inactive.
+    /// Blocks are stored in a fixed pool and indexed by an open-addressing hash table. When a block is needed, the
+    /// least recently updated block is recycled if it is older than temporal_window or if the pool is full.
+    /// Reading a pixel of a missing block yields a zero timestamp.
+    template <typename Polarity>
+    class sparse_active_events {
+        public:
+        sparse_active_events(
+            uint16_t width,
+            uint16_t height,
+            uint64_t temporal_window,
+            std::size_t maximum_number_of_blocks) :
+            _width(width),
+            _height(height),
+            _temporal_window(temporal_window),
+            _maximum_number_of_blocks(maximum_number_of_blocks),
+            _blocks(),
+            _oldest(none),
+            _newest(none),
+            _cached_key(none),
+            _cached_index(none),
+            _evictions(0) {
+            if (maximum_number_of_blocks == 0 || maximum_number_of_blocks >= none / 2) {
+                throw std::logic_error("maximum_number_of_blocks must be in the range [1, 2^31[");
+            }
+            std::size_t table_size = 1;
+            _shift = 32;
+            while (table_size < maximum_number_of_blocks * 2) {
+                table_size *= 2;
+                --_shift;
+            }
+            _table.resize(table_size, none);
+            _blocks.reserve(maximum_number_of_blocks);
+        }
+        sparse_active_events(const sparse_active_events&) = delete;
+        sparse_active_events(sparse_active_events&&) = default;
+        sparse_active_events& operator=(const sparse_active_events&) = delete;
+        sparse_active_events& operator=(sparse_active_events&&) = default;
+        virtual ~sparse_active_events() {}
+
+        /// update stores an event's timestamp (and polarity).
+        template <typename Event>
+        void update(Event event) {
+            const auto key = block_key(event.x, event.y);
+            auto index = cached_find(key);
+            if (index == none) {
+                index = allocate(key, event.t);
+            } else {
+                unlink(index);
+            }
+            auto& block = _blocks[index];
+            block.t = event.t;
+            active_events_pixel<Polarity>::update(block.pixels[(event.x & 7) | ((event.y & 7) << 3)], event);
+            link(index);
+        }
+
+        /// t returns the most recent timestamp at the given pixel.
+        uint64_t t(uint16_t x, uint16_t y) const {
+            const auto index = find(block_key(x, y));
+            if (index == none) {
+                return 0;
+            }
+            return active_events_pixel<Polarity>::t(_blocks[index].pixels[(x & 7) | ((y & 7) << 3)]);
+        }
+
+        /// polarity returns the most recent polarity at the given pixel.
+        Polarity polarity(uint16_t x, uint16_t y) const {
+            const auto index = find(block_key(x, y));
+            if (index == none) {
+                return Polarity();
+            }
+            return active_events_pixel<Polarity>::polarity(_blocks[index].pixels[(x & 7) | ((y & 7) << 3)]);
+        }
+
+        /// width returns the number of pixels along the x axis.
+        uint16_t width() const {
+            return _width;
+        }
+
+        /// height returns the number of pixels along the y axis.
+        uint16_t height() const {
+            return _height;
+        }
+
+        /// number_of_blocks returns the number of allocated blocks.
+        std::size_t number_of_blocks() const {
+            return _blocks.size();
+        }
+
+        /// evictions returns the number of blocks recycled while still within the temporal window.
+        std::size_t evictions() const {
+            return _evictions;
+        }
+
+        /// write_state_sections writes the blocks and the hash table to a state stream.
+        void write_state_sections(std::ostream& stream) const {
+            const std::array<uint64_t, 3> header{{_blocks.size(), _oldest, _newest}};
+            write_state_section(stream, header.data(), header.size());
+            write_state_section(stream, _blocks);
+            write_state_section(stream, _table);
+        }
+
+        /// read_state_sections reads the blocks and the hash table from a state stream.
+        void read_state_sections(std::istream& stream) {
+            std::array<uint64_t, 3> header;
+            read_state_section(stream, header.data(), header.size());
+            if (header[0] > _maximum_number_of_blocks) {
+                throw std::runtime_error("the state has too many blocks");
+            }
+            std::vector<block> blocks(header[0]);
+            read_state_section(stream, blocks);
+            auto table = read_state_copy(stream, _table);
+            _blocks.swap(blocks);
+            _table.swap(table);
+            _oldest = static_cast<uint32_t>(header[1]);
+            _newest = static_cast<uint32_t>(header[2]);
+            _cached_key = none;
+            _cached_index = none;
+        }
+
+        protected:
+        /// none represents a missing block index or key.
+        static constexpr uint32_t none = std::numeric_limits<uint32_t>::max();
+
+        /// block stores 8 x 8 pixels, and the links of the least recently updated list.
+        struct block {
+            uint32_t key;
+            uint32_t older;
+            uint32_t newer;
+            uint64_t t;
+            std::array<typename active_events_pixel<Polarity>::type, 64> pixels;
+        };
+
+        /// block_key returns the key of the block containing the given pixel.
+        static uint32_t block_key(uint16_t x, uint16_t y) {
+            return static_cast<uint32_t>(x >> 3) | (static_cast<uint32_t>(y >> 3) << 13);
+        }
+
+        /// slot returns the preferred hash table slot of a key (Fibonacci hashing).
+        std::size_t slot(uint32_t key) const {
+            return static_cast<uint32_t>(key * 2654435769u) >> _shift;
+        }
+
+        /// find returns the index of the block with the given key, or none.
+        /// find does not modify the surface, so that concurrent readers do not race.
+        uint32_t find(uint32_t key) const {
+            const auto mask = _table.size() - 1;
+            for (auto position = slot(key);; position = (position + 1) & mask) {
+                const auto index = _table[position];
+                if (index == none || _blocks[index].key == key) {
+                    return index;
+                }
+            }
+        }
+
+        /// cached_find is the writer's find, which remembers the last key since consecutive events often hit the
+        /// same block.
+        uint32_t cached_find(uint32_t key) {
+            if (key != _cached_key) {
+                _cached_index = find(key);
+                _cached_key = key;
+            }
+            return _cached_index;
+        }
+
+        /// allocate inserts a zeroed block, recycling the least recently updated block if needed.
+        uint32_t allocate(uint32_t key, uint64_t t) {
+            uint32_t index;
+            if (_oldest != none
+                && (_blocks.size() == _maximum_number_of_blocks || t - _blocks[_oldest].t > _temporal_window)) {
+                index = _oldest;
+                if (t - _blocks[index].t <= _temporal_window) {
+                    ++_evictions;
+                }
+                unlink(index);
+                erase(_blocks[index].key);
+                _blocks[index].pixels.fill(typename active_events_pixel<Polarity>::type());
+            } else {
+                index = static_cast<uint32_t>(_blocks.size());
+                _blocks.emplace_back();
+            }
+            _blocks[index].key = key;
+            const auto mask = _table.size() - 1;
+            auto position = slot(key);
+            while (_table[position] != none) {
+                position = (position + 1) & mask;
+            }
+            _table[position] = index;
+            _cached_key = key;
+            _cached_index = index;
+            return index;
+        }
+
+        /// erase removes a key from the hash table, shifting the following entries back (no tombstones).
+        void erase(uint32_t key) {
+            const auto mask = _table.size() - 1;
+            auto position = slot(key);
+            while (_blocks[_table[position]].key != key) {
+                position = (position + 1) & mask;
+            }
+            for (auto next = (position + 1) & mask; _table[next] != none; next = (next + 1) & mask) {
+                const auto preferred = slot(_blocks[_table[next]].key);
+                if (((next - preferred) & mask) >= ((next - position) & mask)) {
+                    _table[position] = _table[next];
+                    position = next;
+                }
+            }
+            _table[position] = none;
+            _cached_key = none;
+            _cached_index = none;
+        }
+
+        /// unlink removes a block from the least recently updated list.
+        void unlink(uint32_t index) {
+            auto& block = _blocks[index];
+            if (block.older == none) {
+                _oldest = block.newer;
+            } else {
+                _blocks[block.older].newer = block.newer;
+            }
+            if (block.newer == none) {
+                _newest = block.older;
+            } else {
+                _blocks[block.newer].older = block.older;
+            }
+        }
+
+        /// link appends a block to the least recently updated list.
+        void link(uint32_t index) {
+            auto& block = _blocks[index];
+            block.older = _newest;
+            block.newer = none;
+            if (_newest == none) {
+                _oldest = index;
+            } else {
+                _blocks[_newest].newer = index;
+            }
+            _newest = index;
+        }
+
+        const uint16_t _width;
+        const uint16_t _height;
+        const uint64_t _temporal_window;
+        const std::size_t _maximum_number_of_blocks;
+        std::vector<block> _blocks;
+        std::vector<uint32_t> _table;
+        uint32_t _shift;
+        uint32_t _oldest;
+        uint32_t _newest;
+        uint32_t _cached_key;
+        uint32_t _cached_index;
+        std::size_t _evictions;
+    };
+
+    template <typename Polarity>
+    constexpr uint32_t sparse_active_events<Polarity>::none;
+}
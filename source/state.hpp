@@ -0,0 +1,179 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+/// tarsier is a collection of event handlers.
+namespace tarsier {
+    /// state_version is the version of the state files format.
+    /// A state file starts with a 64 bytes header (the signature "tarsier", the version and the handler name),
+    /// followed by sections. Each section has a 64 bytes header (the element size and the number of elements)
+    /// followed by the raw elements, padded to 64 bytes. Every payload starts at a 64 bytes boundary, so that a state
+    /// file can be memory-mapped and its sections used in place.
+    constexpr uint32_t state_version = 1;
+
+    /// state_alignment is the alignment of headers and payloads in state files.
+    constexpr std::size_t state_alignment = 64;
+
+    /// write_state_padding writes zeros up to the next alignment boundary.
+    inline void write_state_padding(std::ostream& stream, std::size_t size) {
+        const std::array<char, state_alignment> zeros{};
+        if (size % state_alignment != 0) {
+            stream.write(zeros.data(), state_alignment - size % state_alignment);
+        }
+    }
+
+    /// write_state_header writes the header of a state file.
+    inline void write_state_header(std::ostream& stream, const std::string& name) {
+        std::array<char, state_alignment> header{};
+        std::memcpy(header.data(), "tarsier", 7);
+        std::memcpy(header.data() + 8, &state_version, sizeof(state_version));
+        if (name.size() >= header.size() - 16) {
+            throw std::logic_error("the state name is too long");
+        }
+        std::memcpy(header.data() + 16, name.data(), name.size());
+        stream.write(header.data(), header.size());
+    }
+
+    /// write_state_section writes a section of a state file.
+    template <typename Element>
+    void write_state_section(std::ostream& stream, const Element* elements, std::size_t count) {
+        std::array<char, state_alignment> header{};
+        const uint64_t element_size = sizeof(Element);
+        const uint64_t elements_count = count;
+        std::memcpy(header.data(), &element_size, sizeof(element_size));
+        std::memcpy(header.data() + 8, &elements_count, sizeof(elements_count));
+        stream.write(header.data(), header.size());
+        stream.write(reinterpret_cast<const char*>(elements), sizeof(Element) * count);
+        write_state_padding(stream, sizeof(Element) * count);
+        if (!stream.good()) {
+            throw std::runtime_error("writing the state failed");
+        }
+    }
+
+    /// write_state_section writes a vector as a section of a state file.
+    template <typename Element, typename Allocator>
+    void write_state_section(std::ostream& stream, const std::vector<Element, Allocator>& elements) {
+        write_state_section(stream, elements.data(), elements.size());
+    }
+
+    /// check_state_header checks the version and the handler name of a state file header.
+    inline void check_state_header(const char* header, const std::string& name) {
+        if (std::memcmp(header, "tarsier", 8) != 0) {
+            throw std::runtime_error("the stream is not a tarsier state");
+        }
+        uint32_t version;
+        std::memcpy(&version, header + 8, sizeof(version));
+        if (version != state_version) {
+            throw std::runtime_error("unsupported state version " + std::to_string(version));
+        }
+        if (std::strncmp(header + 16, name.c_str(), state_alignment - 16) != 0) {
+            throw std::runtime_error("the state does not belong to a " + name);
+        }
+    }
+
+    /// read_state_header reads the header of a state file, and checks the version and the handler name.
+    inline void read_state_header(std::istream& stream, const std::string& name) {
+        std::array<char, state_alignment> header;
+        stream.read(header.data(), header.size());
+        if (!stream.good()) {
+            throw std::runtime_error("the stream is not a tarsier state");
+        }
+        check_state_header(header.data(), name);
+    }
+
+    /// read_state_section reads a section of a state file, and checks the element size and count.
+    /// The elements may be partially overwritten if the section is truncated.
+    template <typename Element>
+    void read_state_section(std::istream& stream, Element* elements, std::size_t count) {
+        std::array<char, state_alignment> header;
+        stream.read(header.data(), header.size());
+        uint64_t element_size;
+        uint64_t elements_count;
+        std::memcpy(&element_size, header.data(), sizeof(element_size));
+        std::memcpy(&elements_count, header.data() + 8, sizeof(elements_count));
+        if (!stream.good() || element_size != sizeof(Element) || elements_count != count) {
+            throw std::runtime_error("the state section does not match the handler");
+        }
+        stream.read(reinterpret_cast<char*>(elements), sizeof(Element) * count);
+        if (sizeof(Element) * count % state_alignment != 0) {
+            stream.ignore(state_alignment - sizeof(Element) * count % state_alignment);
+        }
+        if (!stream.good()) {
+            throw std::runtime_error("the state is truncated");
+        }
+    }
+
+    /// read_state_section reads a section of a state file into a vector with the expected size.
+    template <typename Element, typename Allocator>
+    void read_state_section(std::istream& stream, std::vector<Element, Allocator>& elements) {
+        read_state_section(stream, elements.data(), elements.size());
+    }
+
+    /// read_state_copy reads a section of a state file into a new vector with the size and the allocator of
+    /// elements, which is left untouched.
+    /// Handlers read every section into copies, and swap them into place once all of them are read, so that a
+    /// failed load_state leaves the handler's state unchanged.
+    template <typename Element, typename Allocator>
+    std::vector<Element, Allocator>
+    read_state_copy(std::istream& stream, const std::vector<Element, Allocator>& elements) {
+        std::vector<Element, Allocator> copy(elements.size(), Element(), elements.get_allocator());
+        read_state_section(stream, copy);
+        return copy;
+    }
+
+    /// state_view reads a state file in place, for instance from a memory-mapped file.
+    /// data must be aligned on state_alignment bytes (memory maps are page-aligned), and must outlive the view.
+    /// section checks the next section's header and returns a pointer to its payload, without copying it.
+    class state_view {
+        public:
+        state_view(const char* data, std::size_t size, const std::string& name) : _data(data), _end(data + size) {
+            if (reinterpret_cast<uintptr_t>(data) % state_alignment != 0) {
+                throw std::logic_error("the state data must be aligned on state_alignment bytes");
+            }
+            if (size < state_alignment) {
+                throw std::runtime_error("the stream is not a tarsier state");
+            }
+            check_state_header(_data, name);
+            _data += state_alignment;
+        }
+        state_view(const state_view&) = default;
+        state_view(state_view&&) = default;
+        state_view& operator=(const state_view&) = default;
+        state_view& operator=(state_view&&) = default;
+        virtual ~state_view() {}
+
+        /// section returns the payload of the next section, and checks the element size and count.
+        template <typename Element>
+        const Element* section(std::size_t count) {
+            if (static_cast<std::size_t>(_end - _data) < state_alignment) {
+                throw std::runtime_error("the state is truncated");
+            }
+            uint64_t element_size;
+            uint64_t elements_count;
+            std::memcpy(&element_size, _data, sizeof(element_size));
+            std::memcpy(&elements_count, _data + 8, sizeof(elements_count));
+            if (element_size != sizeof(Element) || elements_count != count) {
+                throw std::runtime_error("the state section does not match the handler");
+            }
+            const auto payload_size = sizeof(Element) * count;
+            const auto padded_size = (payload_size + state_alignment - 1) / state_alignment * state_alignment;
+            if (static_cast<std::size_t>(_end - _data) - state_alignment < padded_size) {
+                throw std::runtime_error("the state is truncated");
+            }
+            const auto elements = reinterpret_cast<const Element*>(_data + state_alignment);
+            _data += state_alignment + padded_size;
+            return elements;
+        }
+
+        protected:
+        const char* _data;
+        const char* _end;
+    };
+}
@@ -1,6 +1,8 @@
 #pragma once
 
+#include "state.hpp"
 #include <cstdint>
+#include <memory>
 #include <utility>
 #include <vector>
 
@@ -8,19 +10,32 @@
 namespace tarsier {
 
     /// stitch turns a stream of threshold crossings into a stream of time deltas.
-    template <typename ThresholdCrossing, typename Event, typename ThresholdCrossingToEvent, typename HandleEvent>
+    /// Allocator (rebound to the pixel type) can be one of the allocators in allocators.hpp.
+    template <
+        typename ThresholdCrossing,
+        typename Event,
+        typename ThresholdCrossingToEvent,
+        typename HandleEvent,
+        typename Allocator = std::allocator<std::pair<bool, uint64_t>>>
     class stitch {
         public:
+        typedef typename std::allocator_traits<Allocator>::template rebind_alloc<std::pair<bool, uint64_t>>
+            pixel_allocator;
+
         stitch(
             uint16_t width,
             uint16_t height,
             ThresholdCrossingToEvent threshold_crossing_to_event,
-            HandleEvent handle_event) :
+            HandleEvent handle_event,
+            Allocator allocator = Allocator()) :
             _width(width),
             _height(height),
             _threshold_crossing_to_event(std::forward<ThresholdCrossingToEvent>(threshold_crossing_to_event)),
             _handle_event(std::forward<HandleEvent>(handle_event)),
-            _are_triggered_and_ts(width * height, {false, 0}) {}
+            _are_triggered_and_ts(
+                static_cast<std::size_t>(width) * height,
+                {false, 0},
+                pixel_allocator(std::move(allocator))) {}
         stitch(const stitch&) = delete;
         stitch(stitch&&) = default;
         stitch& operator=(const stitch&) = delete;
@@ -46,25 +61,45 @@ namespace tarsier {
             }
         }
 
+        /// save_state writes the triggers and timestamps map to a stream.
+        void save_state(std::ostream& stream) const {
+            write_state_header(stream, "stitch");
+            write_state_section(stream, _are_triggered_and_ts);
+        }
+
+        /// load_state reads the triggers and timestamps map written by save_state.
+        void load_state(std::istream& stream) {
+            read_state_header(stream, "stitch");
+            auto are_triggered_and_ts = read_state_copy(stream, _are_triggered_and_ts);
+            _are_triggered_and_ts.swap(are_triggered_and_ts);
+        }
+
         protected:
         const uint16_t _width;
         const uint16_t _height;
         ThresholdCrossingToEvent _threshold_crossing_to_event;
         HandleEvent _handle_event;
-        std::vector<std::pair<bool, uint64_t>> _are_triggered_and_ts;
+        std::vector<std::pair<bool, uint64_t>, pixel_allocator> _are_triggered_and_ts;
     };
 
     /// make_stitch creates a stitch from functors.
-    template <typename ThresholdCrossing, typename Event, typename ThresholdCrossingToEvent, typename HandleEvent>
-    stitch<ThresholdCrossing, Event, ThresholdCrossingToEvent, HandleEvent> make_stitch(
+    template <
+        typename ThresholdCrossing,
+        typename Event,
+        typename ThresholdCrossingToEvent,
+        typename HandleEvent,
+        typename Allocator = std::allocator<std::pair<bool, uint64_t>>>
+    stitch<ThresholdCrossing, Event, ThresholdCrossingToEvent, HandleEvent, Allocator> make_stitch(
         uint16_t width,
         uint16_t height,
         ThresholdCrossingToEvent threshold_crossing_to_event,
-        HandleEvent handle_event) {
-        return stitch<ThresholdCrossing, Event, ThresholdCrossingToEvent, HandleEvent>(
+        HandleEvent handle_event,
+        Allocator allocator = Allocator()) {
+        return stitch<ThresholdCrossing, Event, ThresholdCrossingToEvent, HandleEvent, Allocator>(
             width,
             height,
             std::forward<ThresholdCrossingToEvent>(threshold_crossing_to_event),
-            std::forward<HandleEvent>(handle_event));
+            std::forward<HandleEvent>(handle_event),
+            std::move(allocator));
     }
 }
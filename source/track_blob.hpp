@@ -1,13 +1,32 @@
 #pragma once
 
+#include "emission.hpp"
+#include "fixed_point.hpp"
+#include "inertia.hpp"
+#include "snapshot.hpp"
+#include "state.hpp"
+#include <array>
 #include <cmath>
 #include <stdexcept>
 #include <utility>
+#include <vector>
 
 /// tarsier is a collection of event handlers.
 namespace tarsier {
     /// track_blob averages the incoming events with a gaussian blob.
-    template <typename Event, typename Blob, typename EventToBlob, typename HandleBlob>
+    /// Number can be float or a fixed_point (see average_position for the error bound). Variances must stay in the
+    /// fixed-point range: Q16.16 covers standard deviations up to 181 pixels, fixed_point<8> up to 2896 pixels.
+    /// Emission selects the events that trigger an output (see emission.hpp).
+    /// Inertia gives the weight of the previous position and covariance (see inertia.hpp): fixed inertias per event
+    /// by default, or time constants with time_inertia.
+    template <
+        typename Event,
+        typename Blob,
+        typename EventToBlob,
+        typename HandleBlob,
+        typename Number = float,
+        typename Emission = emit_always,
+        typename Inertia = event_inertia<Number>>
     class track_blob {
         public:
         track_blob(
@@ -16,26 +35,22 @@ namespace tarsier {
             float sigma_x_squared,
             float sigma_xy,
             float sigma_y_squared,
-            float position_inertia,
-            float variance_inertia,
+            Inertia position_inertia,
+            Inertia variance_inertia,
             EventToBlob event_to_blob,
-            HandleBlob handle_blob) :
+            HandleBlob handle_blob,
+            Emission emission = Emission()) :
             _x(x),
             _y(y),
             _sigma_x_squared(sigma_x_squared),
             _sigma_xy(sigma_xy),
             _sigma_y_squared(sigma_y_squared),
-            _position_inertia(position_inertia),
-            _variance_inertia(variance_inertia),
+            _position_inertia(std::move(position_inertia)),
+            _variance_inertia(std::move(variance_inertia)),
             _event_to_blob(std::forward<EventToBlob>(event_to_blob)),
-            _handle_blob(std::forward<HandleBlob>(handle_blob)) {
-            if (_position_inertia < 0 || _position_inertia > 1) {
-                throw std::logic_error("position_inertia must be in the range [0, 1]");
-            }
-            if (_variance_inertia < 0 || _variance_inertia > 1) {
-                throw std::logic_error("variance_inertia must be in the range [0, 1]");
-            }
-        }
+            _handle_blob(std::forward<HandleBlob>(handle_blob)),
+            _emission(std::move(emission)),
+            _snapshot(nullptr) {}
         track_blob(const track_blob&) = delete;
         track_blob(track_blob&&) = default;
         track_blob& operator=(const track_blob&) = delete;
@@ -44,56 +59,159 @@ namespace tarsier {
 
         /// operator() handles an event.
         virtual void operator()(Event event) {
-            const auto x_delta = event.x - _x;
-            const auto y_delta = event.y - _y;
-            _x = _position_inertia * _x + (1 - _position_inertia) * event.x;
-            _y = _position_inertia * _y + (1 - _position_inertia) * event.y;
-            _sigma_x_squared = _variance_inertia * _sigma_x_squared + (1 - _variance_inertia) * x_delta * x_delta;
-            _sigma_xy = _variance_inertia * _sigma_xy + (1 - _variance_inertia) * x_delta * y_delta;
-            _sigma_y_squared = _variance_inertia * _sigma_y_squared + (1 - _variance_inertia) * y_delta * y_delta;
-            _handle_blob(_event_to_blob(event, _x, _y, _sigma_x_squared, _sigma_xy, _sigma_y_squared));
+            _position_inertia.update(event);
+            _variance_inertia.update(event);
+            const auto x_delta = Number(event.x) - _x;
+            const auto y_delta = Number(event.y) - _y;
+            _x = _x * _position_inertia.inertia() + Number(event.x) * _position_inertia.complement();
+            _y = _y * _position_inertia.inertia() + Number(event.y) * _position_inertia.complement();
+            const auto variance_inertia = _variance_inertia.inertia();
+            const auto variance_complement = _variance_inertia.complement();
+            _sigma_x_squared = _sigma_x_squared * variance_inertia + x_delta * x_delta * variance_complement;
+            _sigma_xy = _sigma_xy * variance_inertia + x_delta * y_delta * variance_complement;
+            _sigma_y_squared = _sigma_y_squared * variance_inertia + y_delta * y_delta * variance_complement;
+            publish(event, _emission.due(event));
+        }
+
+        /// operator() handles a batch of events.
+        /// The batch is split after each event due for an output (see emission.hpp), and the covariance is updated
+        /// once per part, with the weights of the events in closed form, hence its sums have no dependency between
+        /// events. Each event's contribution depends on the position before the event, which is still calculated
+        /// sequentially (two products per coordinate). The outputs match the single-event updates up to rounding.
+        virtual void operator()(const Event* events, std::size_t count) {
+            std::size_t begin = 0;
+            while (begin < count) {
+                auto end = begin;
+                auto due = false;
+                while (!due && end < count) {
+                    due = _emission.due(events[end]);
+                    ++end;
+                }
+                update(events + begin, end - begin);
+                publish(events[end - 1], due);
+                begin = end;
+            }
         }
 
         /// x returns the blob's center's x coordinate.
-        float x() const {
+        Number x() const {
             return _x;
         }
 
         /// y returns the blob's center's y coordinate.
-        float y() const {
+        Number y() const {
             return _y;
         }
 
         /// sigma_x_squared returns the blob's variance along the x axis.
-        float sigma_x_squared() const {
+        Number sigma_x_squared() const {
             return _sigma_x_squared;
         }
 
         /// sigma_xy returns the blob's covariance.
-        float sigma_xy() const {
+        Number sigma_xy() const {
             return _sigma_xy;
         }
 
         /// sigma_y_squared returns the blob's variance along the y axis.
-        float sigma_y_squared() const {
+        Number sigma_y_squared() const {
             return _sigma_y_squared;
         }
 
+        /// publish_to makes the blob (x, y, sigma_x_squared, sigma_xy, sigma_y_squared) available to another thread
+        /// after each event.
+        void publish_to(snapshot<std::array<Number, 5>>& blob_snapshot) {
+            _snapshot = &blob_snapshot;
+        }
+
+        /// save_state writes the blob's position and covariance, and the inertias' states, to a stream.
+        void save_state(std::ostream& stream) const {
+            write_state_header(stream, "track_blob");
+            const std::array<Number, 5> values{{_x, _y, _sigma_x_squared, _sigma_xy, _sigma_y_squared}};
+            write_state_section(stream, values.data(), values.size());
+            _position_inertia.write_state_sections(stream);
+            _variance_inertia.write_state_sections(stream);
+        }
+
+        /// load_state reads the blob's position and covariance, and the inertias' states, written by save_state.
+        void load_state(std::istream& stream) {
+            read_state_header(stream, "track_blob");
+            std::array<Number, 5> values;
+            read_state_section(stream, values.data(), values.size());
+            auto position_inertia = _position_inertia;
+            position_inertia.read_state_sections(stream);
+            auto variance_inertia = _variance_inertia;
+            variance_inertia.read_state_sections(stream);
+            _position_inertia = std::move(position_inertia);
+            _variance_inertia = std::move(variance_inertia);
+            _x = values[0];
+            _y = values[1];
+            _sigma_x_squared = values[2];
+            _sigma_xy = values[3];
+            _sigma_y_squared = values[4];
+        }
+
         protected:
-        float _x;
-        float _y;
-        float _sigma_x_squared;
-        float _sigma_xy;
-        float _sigma_y_squared;
-        const float _position_inertia;
-        const float _variance_inertia;
+        /// update applies a part of a batch to the blob.
+        void update(const Event* events, std::size_t count) {
+            _weights.resize(count);
+            _deltas.resize(count);
+            for (std::size_t index = 0; index < count; ++index) {
+                _position_inertia.update(events[index]);
+                _deltas[index] = {{Number(events[index].x) - _x, Number(events[index].y) - _y}};
+                _x = _x * _position_inertia.inertia() + Number(events[index].x) * _position_inertia.complement();
+                _y = _y * _position_inertia.inertia() + Number(events[index].y) * _position_inertia.complement();
+            }
+            const auto head = _variance_inertia.weights(events, count, _weights.data());
+            auto sigma_x_squared = _sigma_x_squared * head;
+            auto sigma_xy = _sigma_xy * head;
+            auto sigma_y_squared = _sigma_y_squared * head;
+            for (std::size_t index = 0; index < count; ++index) {
+                const auto& delta = _deltas[index];
+                sigma_x_squared = sigma_x_squared + delta[0] * delta[0] * _weights[index];
+                sigma_xy = sigma_xy + delta[0] * delta[1] * _weights[index];
+                sigma_y_squared = sigma_y_squared + delta[1] * delta[1] * _weights[index];
+            }
+            _sigma_x_squared = sigma_x_squared;
+            _sigma_xy = sigma_xy;
+            _sigma_y_squared = sigma_y_squared;
+        }
+
+        /// publish sends the blob to the snapshot, and to the handler if the event is due for an output.
+        void publish(Event event, bool due) {
+            if (_snapshot != nullptr) {
+                _snapshot->back() = {{_x, _y, _sigma_x_squared, _sigma_xy, _sigma_y_squared}};
+                _snapshot->publish();
+            }
+            if (due && _emission.emit(_x, _y, _sigma_x_squared, _sigma_xy, _sigma_y_squared)) {
+                _handle_blob(_event_to_blob(event, _x, _y, _sigma_x_squared, _sigma_xy, _sigma_y_squared));
+            }
+        }
+
+        Number _x;
+        Number _y;
+        Number _sigma_x_squared;
+        Number _sigma_xy;
+        Number _sigma_y_squared;
+        Inertia _position_inertia;
+        Inertia _variance_inertia;
         EventToBlob _event_to_blob;
         HandleBlob _handle_blob;
+        Emission _emission;
+        snapshot<std::array<Number, 5>>* _snapshot;
+        std::vector<typename decay_factor<Number>::type> _weights;
+        std::vector<std::array<Number, 2>> _deltas;
     };
 
     /// make_track_blob creates a track_blob from functors.
-    template <typename Event, typename Blob, typename EventToBlob, typename HandleBlob>
-    track_blob<Event, Blob, EventToBlob, HandleBlob> make_track_blob(
+    template <
+        typename Event,
+        typename Blob,
+        typename Number = float,
+        typename EventToBlob,
+        typename HandleBlob,
+        typename Emission = emit_always>
+    track_blob<Event, Blob, EventToBlob, HandleBlob, Number, Emission> make_track_blob(
         float x,
         float y,
         float sigma_x_squared,
@@ -102,8 +220,9 @@ namespace tarsier {
         float position_inertia,
         float variance_inertia,
         EventToBlob event_to_blob,
-        HandleBlob handle_blob) {
-        return track_blob<Event, Blob, EventToBlob, HandleBlob>(
+        HandleBlob handle_blob,
+        Emission emission = Emission()) {
+        return track_blob<Event, Blob, EventToBlob, HandleBlob, Number, Emission>(
             x,
             y,
             sigma_x_squared,
@@ -112,6 +231,39 @@ namespace tarsier {
             position_inertia,
             variance_inertia,
             std::forward<EventToBlob>(event_to_blob),
-            std::forward<HandleBlob>(handle_blob));
+            std::forward<HandleBlob>(handle_blob),
+            std::move(emission));
+    }
+
+    /// make_track_blob creates a track_blob with time-based inertias from functors.
+    template <
+        typename Event,
+        typename Blob,
+        typename Number = float,
+        typename EventToBlob,
+        typename HandleBlob,
+        typename Emission = emit_always>
+    track_blob<Event, Blob, EventToBlob, HandleBlob, Number, Emission, time_inertia<Number>> make_track_blob(
+        float x,
+        float y,
+        float sigma_x_squared,
+        float sigma_xy,
+        float sigma_y_squared,
+        time_constant position_time_constant,
+        time_constant variance_time_constant,
+        EventToBlob event_to_blob,
+        HandleBlob handle_blob,
+        Emission emission = Emission()) {
+        return track_blob<Event, Blob, EventToBlob, HandleBlob, Number, Emission, time_inertia<Number>>(
+            x,
+            y,
+            sigma_x_squared,
+            sigma_xy,
+            sigma_y_squared,
+            position_time_constant,
+            variance_time_constant,
+            std::forward<EventToBlob>(event_to_blob),
+            std::forward<HandleBlob>(handle_blob),
+            std::move(emission));
     }
 }
@@ -0,0 +1,341 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+/// tarsier is a collection of event handlers.
+namespace tarsier {
+    /// hough_line represents a tracked straight line x * cos(angle) + y * sin(angle) = rho.
+    /// angle is in radians in the range [0, pi[, rho is in pixels, and votes is the decayed number of events in the
+    /// line's accumulator cell.
+    struct hough_line {
+        uint64_t id;
+        uint64_t t;
+        float angle;
+        float rho;
+        float votes;
+    };
+
+    /// track_lines detects and tracks straight lines with a decayed Hough accumulator.
+    /// Events vote for cells along their sinusoid (number_of_angles angles, one-pixel rho bins), using precomputed
+    /// fixed-point cos / sin tables and integer additions. Instead of decaying the accumulator, the vote weight grows
+    /// as exp(t / decay), and the accumulator is rescaled with a shift every decay * ln(256) microseconds. A cell
+    /// must not receive more than about 2^16 decayed votes.
+    /// Peaks are tracked incrementally rather than by scanning the accumulator. An event within suppression_radius
+    /// pixels of a tracked line belongs to the closest one, and only votes for the angles within
+    /// suppression_radius bins of the line's angle. Otherwise, it votes for every angle. This keeps the sides of a
+    /// segment's butterfly-shaped peak from growing, and makes line events cheaper. Two cells represent the same
+    /// line if their angles are within suppression_radius bins, and their rhos are within suppression_radius bins
+    /// or the lines cross inside the sensor. A line moves to the cells that represent it, reach threshold decayed
+    /// votes and exceed its own.
+    /// An event that does not belong to a line starts one at its strongest cell above threshold, if one of the
+    /// maximum_number_of_lines slots is free (lines below threshold free their slot).
+    /// event_to_line_event(event, line) is called when a line is created, and then at most once every
+    /// minimum_interval microseconds per line, when it receives a vote.
+    template <typename Event, typename LineEvent, typename EventToLineEvent, typename HandleLineEvent>
+    class track_lines {
+        public:
+        track_lines(
+            uint16_t width,
+            uint16_t height,
+            uint16_t number_of_angles,
+            uint64_t decay,
+            float threshold,
+            uint16_t suppression_radius,
+            std::size_t maximum_number_of_lines,
+            uint64_t minimum_interval,
+            EventToLineEvent event_to_line_event,
+            HandleLineEvent handle_line_event) :
+            _width(width),
+            _height(height),
+            _number_of_angles(number_of_angles),
+            _angle_step(std::acos(-1.0) / std::max(number_of_angles, static_cast<uint16_t>(1))),
+            _offset(static_cast<int32_t>(std::ceil(std::hypot(static_cast<double>(width), height)))),
+            _number_of_rhos(2 * _offset + 1),
+            _decay(static_cast<float>(decay)),
+            _rescale_interval(static_cast<uint64_t>(std::round(decay * std::log(256.0)))),
+            _threshold(threshold),
+            _suppression_radius(suppression_radius),
+            _minimum_interval(minimum_interval),
+            _event_to_line_event(std::forward<EventToLineEvent>(event_to_line_event)),
+            _handle_line_event(std::forward<HandleLineEvent>(handle_line_event)),
+            _cosines(number_of_angles),
+            _sines(number_of_angles),
+            _cells(static_cast<std::size_t>(number_of_angles) * _number_of_rhos, 0),
+            _lines(maximum_number_of_lines, line{0, 0, 0, false}),
+            _cells_indices(number_of_angles),
+            _t(0),
+            _next_id(0) {
+            if (number_of_angles == 0) {
+                throw std::logic_error("number_of_angles must be larger than zero");
+            }
+            if (decay == 0) {
+                throw std::logic_error("decay must be larger than zero");
+            }
+            if (threshold <= 0.0f) {
+                throw std::logic_error("threshold must be larger than zero");
+            }
+            if (2 * suppression_radius + 1 > number_of_angles) {
+                throw std::logic_error("suppression_radius must be smaller than number_of_angles / 2");
+            }
+            if (maximum_number_of_lines == 0) {
+                throw std::logic_error("maximum_number_of_lines must be larger than zero");
+            }
+            for (uint16_t angle = 0; angle < number_of_angles; ++angle) {
+                _cosines[angle] = static_cast<int32_t>(std::lround(std::cos(angle * _angle_step) * (1 << precision)));
+                _sines[angle] = static_cast<int32_t>(std::lround(std::sin(angle * _angle_step) * (1 << precision)));
+            }
+        }
+        track_lines(const track_lines&) = delete;
+        track_lines(track_lines&&) = default;
+        track_lines& operator=(const track_lines&) = delete;
+        track_lines& operator=(track_lines&&) = default;
+        virtual ~track_lines() {}
+
+        /// operator() handles an event.
+        virtual void operator()(Event event) {
+            if (event.t - _t >= _rescale_interval) {
+                const auto steps = (event.t - _t) / _rescale_interval;
+                if (steps >= 4) {
+                    std::fill(_cells.begin(), _cells.end(), 0);
+                } else {
+                    const auto shift = static_cast<uint32_t>(steps * 8);
+                    for (auto& cell : _cells) {
+                        cell >>= shift;
+                    }
+                }
+                _t += steps * _rescale_interval;
+            }
+            const auto increment =
+                static_cast<uint32_t>(256.0f * std::exp(static_cast<float>(event.t - _t) / _decay));
+            const auto threshold = static_cast<uint64_t>(_threshold * increment);
+            const int32_t x = event.x;
+            const int32_t y = event.y;
+            const int32_t bias = (_offset << precision) + (1 << (precision - 1));
+            const auto none = _lines.size();
+            auto owner = none;
+            auto owner_distance = (_suppression_radius << precision) + 1;
+            for (std::size_t index = 0; index < _lines.size(); ++index) {
+                auto& tracked_line = _lines[index];
+                if (tracked_line.active) {
+                    if (_cells[tracked_line.cell_index] < threshold) {
+                        tracked_line.active = false;
+                    } else {
+                        const auto angle = tracked_line.cell_index / _number_of_rhos;
+                        const auto rho = static_cast<int32_t>(tracked_line.cell_index % _number_of_rhos) - _offset;
+                        const auto distance = std::abs(x * _cosines[angle] + y * _sines[angle] - (rho << precision));
+                        if (distance < owner_distance) {
+                            owner = index;
+                            owner_distance = distance;
+                        }
+                    }
+                }
+            }
+            std::size_t number_of_votes = _number_of_angles;
+            if (owner == none) {
+                for (uint16_t angle = 0; angle < _number_of_angles; ++angle) {
+                    _cells_indices[angle] =
+                        angle * _number_of_rhos + ((x * _cosines[angle] + y * _sines[angle] + bias) >> precision);
+                }
+            } else {
+                number_of_votes = 2 * _suppression_radius + 1;
+                const auto owner_angle = static_cast<int32_t>(_lines[owner].cell_index / _number_of_rhos);
+                for (std::size_t vote = 0; vote < number_of_votes; ++vote) {
+                    const auto angle =
+                        (owner_angle + _number_of_angles - _suppression_radius + static_cast<int32_t>(vote))
+                        % _number_of_angles;
+                    _cells_indices[vote] =
+                        angle * _number_of_rhos + ((x * _cosines[angle] + y * _sines[angle] + bias) >> precision);
+                }
+            }
+            std::size_t number_of_candidates = 0;
+            for (std::size_t vote = 0; vote < number_of_votes; ++vote) {
+                auto& cell = _cells[_cells_indices[vote]];
+                const auto sum = cell + increment;
+                cell = sum < cell ? std::numeric_limits<uint32_t>::max() : sum;
+                if (cell >= threshold) {
+                    _cells_indices[number_of_candidates] = _cells_indices[vote];
+                    ++number_of_candidates;
+                }
+            }
+            if (owner == none) {
+                if (number_of_candidates > 0) {
+                    create(event, number_of_candidates, increment);
+                }
+            } else {
+                move(owner, number_of_candidates);
+                if (_lines[owner].active && event.t - _lines[owner].emitted_t >= _minimum_interval) {
+                    emit(event, _lines[owner], increment);
+                }
+            }
+        }
+
+        protected:
+        /// precision is the number of fractional bits of the cos / sin tables.
+        static constexpr int32_t precision = 12;
+
+        /// line is a tracked peak of the accumulator.
+        struct line {
+            uint64_t id;
+            uint64_t emitted_t;
+            uint32_t cell_index;
+            bool active;
+        };
+
+        /// create starts a line at the strongest candidate (cells that reached the threshold, stored at the
+        /// beginning of _cells_indices), unless it is near a tracked line or there is no free slot.
+        void create(Event event, std::size_t number_of_candidates, uint32_t increment) {
+            auto strongest = _cells_indices[0];
+            for (std::size_t candidate = 1; candidate < number_of_candidates; ++candidate) {
+                if (_cells[_cells_indices[candidate]] > _cells[strongest]) {
+                    strongest = _cells_indices[candidate];
+                }
+            }
+            const auto none = _lines.size();
+            auto free = none;
+            for (std::size_t index = 0; index < _lines.size(); ++index) {
+                if (!_lines[index].active) {
+                    if (free == none) {
+                        free = index;
+                    }
+                } else if (near(_lines[index].cell_index, strongest)) {
+                    return;
+                }
+            }
+            if (free != none) {
+                _lines[free] = line{_next_id, event.t, strongest, true};
+                ++_next_id;
+                emit(event, _lines[free], increment);
+            }
+        }
+
+        /// move climbs a line to the strongest candidate in its neighbourhood. If the line reaches another line,
+        /// the weaker one is dropped.
+        void move(std::size_t index, std::size_t number_of_candidates) {
+            auto& tracked_line = _lines[index];
+            auto moved = false;
+            for (std::size_t candidate = 0; candidate < number_of_candidates; ++candidate) {
+                const auto cell_index = _cells_indices[candidate];
+                if (_cells[cell_index] > _cells[tracked_line.cell_index] && near(tracked_line.cell_index, cell_index)) {
+                    tracked_line.cell_index = cell_index;
+                    moved = true;
+                }
+            }
+            if (moved) {
+                for (std::size_t other_index = 0; other_index < _lines.size(); ++other_index) {
+                    auto& other_line = _lines[other_index];
+                    if (other_index != index && other_line.active
+                        && near(other_line.cell_index, tracked_line.cell_index)) {
+                        if (_cells[other_line.cell_index] > _cells[tracked_line.cell_index]) {
+                            tracked_line.active = false;
+                            return;
+                        }
+                        other_line.active = false;
+                    }
+                }
+            }
+        }
+
+        /// near determines whether two cells represent the same line: their angles are within the suppression
+        /// radius, and either their rhos are within the suppression radius or the lines cross inside the sensor
+        /// (the sides of a segment's peak). Angles wrap around: the cell (angle + number_of_angles, rho) is the
+        /// cell (angle, -rho).
+        bool near(uint32_t first, uint32_t second) const {
+            const auto first_angle = static_cast<int32_t>(first / _number_of_rhos);
+            const auto first_rho = static_cast<int32_t>(first % _number_of_rhos) - _offset;
+            const auto second_angle = static_cast<int32_t>(second / _number_of_rhos);
+            const auto second_rho = static_cast<int32_t>(second % _number_of_rhos) - _offset;
+            auto angle_distance = std::abs(first_angle - second_angle);
+            auto rho_distance = std::abs(first_rho - second_rho);
+            if (angle_distance > _number_of_angles / 2) {
+                angle_distance = _number_of_angles - angle_distance;
+                rho_distance = std::abs(first_rho + second_rho);
+            }
+            if (angle_distance > _suppression_radius) {
+                return false;
+            }
+            if (rho_distance <= _suppression_radius) {
+                return true;
+            }
+            if (angle_distance == 0) {
+                return false;
+            }
+            const auto first_cosine = static_cast<float>(_cosines[first_angle]);
+            const auto first_sine = static_cast<float>(_sines[first_angle]);
+            const auto second_cosine = static_cast<float>(_cosines[second_angle]);
+            const auto second_sine = static_cast<float>(_sines[second_angle]);
+            const auto determinant = (first_cosine * second_sine - first_sine * second_cosine) / (1 << precision);
+            const auto x = (first_rho * second_sine - second_rho * first_sine) / determinant;
+            const auto y = (second_rho * first_cosine - first_rho * second_cosine) / determinant;
+            return x >= 0.0f && y >= 0.0f && x < _width && y < _height;
+        }
+
+        /// emit calls the handler with a tracked line.
+        void emit(Event event, line& tracked_line, uint32_t increment) {
+            tracked_line.emitted_t = event.t;
+            _handle_line_event(_event_to_line_event(
+                event,
+                hough_line{
+                    tracked_line.id,
+                    event.t,
+                    static_cast<float>((tracked_line.cell_index / _number_of_rhos) * _angle_step),
+                    static_cast<float>(static_cast<int32_t>(tracked_line.cell_index % _number_of_rhos) - _offset),
+                    static_cast<float>(_cells[tracked_line.cell_index]) / increment}));
+        }
+
+        const uint16_t _width;
+        const uint16_t _height;
+        const uint16_t _number_of_angles;
+        const double _angle_step;
+        const int32_t _offset;
+        const int32_t _number_of_rhos;
+        const float _decay;
+        const uint64_t _rescale_interval;
+        const float _threshold;
+        const int32_t _suppression_radius;
+        const uint64_t _minimum_interval;
+        EventToLineEvent _event_to_line_event;
+        HandleLineEvent _handle_line_event;
+        std::vector<int32_t> _cosines;
+        std::vector<int32_t> _sines;
+        std::vector<uint32_t> _cells;
+        std::vector<line> _lines;
+        std::vector<uint32_t> _cells_indices;
+        uint64_t _t;
+        uint64_t _next_id;
+    };
+
+    template <typename Event, typename LineEvent, typename EventToLineEvent, typename HandleLineEvent>
+    constexpr int32_t track_lines<Event, LineEvent, EventToLineEvent, HandleLineEvent>::precision;
+
+    /// make_track_lines creates a track_lines from functors.
+    template <typename Event, typename LineEvent, typename EventToLineEvent, typename HandleLineEvent>
+    track_lines<Event, LineEvent, EventToLineEvent, HandleLineEvent> make_track_lines(
+        uint16_t width,
+        uint16_t height,
+        uint16_t number_of_angles,
+        uint64_t decay,
+        float threshold,
+        uint16_t suppression_radius,
+        std::size_t maximum_number_of_lines,
+        uint64_t minimum_interval,
+        EventToLineEvent event_to_line_event,
+        HandleLineEvent handle_line_event) {
+        return track_lines<Event, LineEvent, EventToLineEvent, HandleLineEvent>(
+            width,
+            height,
+            number_of_angles,
+            decay,
+            threshold,
+            suppression_radius,
+            maximum_number_of_lines,
+            minimum_interval,
+            std::forward<EventToLineEvent>(event_to_line_event),
+            std::forward<HandleLineEvent>(handle_line_event));
+    }
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include "active_events.hpp"
+#include <utility>
+
+/// tarsier is a collection of event handlers.
+namespace tarsier {
+    /// update_active_events writes each event to a shared surface of active events, then propagates it.
+    /// Handlers constructed with a reference to the same active events read it without updating it.
+    template <typename Event, typename ActiveEvents, typename HandleEvent>
+    class update_active_events {
+        public:
+        update_active_events(ActiveEvents& active_events, HandleEvent handle_event) :
+            _active_events(active_events),
+            _handle_event(std::forward<HandleEvent>(handle_event)) {}
+        update_active_events(const update_active_events&) = delete;
+        update_active_events(update_active_events&&) = default;
+        update_active_events& operator=(const update_active_events&) = delete;
+        update_active_events& operator=(update_active_events&&) = default;
+        virtual ~update_active_events() {}
+
+        /// operator() handles an event.
+        virtual void operator()(Event event) {
+            _active_events.update(event);
+            _handle_event(event);
+        }
+
+        protected:
+        ActiveEvents& _active_events;
+        HandleEvent _handle_event;
+    };
+
+    /// make_update_active_events creates an update_active_events from a functor.
+    template <typename Event, typename ActiveEvents, typename HandleEvent>
+    update_active_events<Event, ActiveEvents, HandleEvent>
+    make_update_active_events(ActiveEvents& active_events, HandleEvent handle_event) {
+        return update_active_events<Event, ActiveEvents, HandleEvent>(
+            active_events, std::forward<HandleEvent>(handle_event));
+    }
+}
@@ -0,0 +1,285 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+/// tarsier is a collection of event handlers.
+namespace tarsier {
+    /// pinhole_bearings calculates the bearings of a pinhole camera without distortion, row by row.
+    inline std::vector<std::array<float, 2>>
+    pinhole_bearings(uint16_t width, uint16_t height, float fx, float fy, float cx, float cy) {
+        if (fx == 0.0f || fy == 0.0f) {
+            throw std::logic_error("the focal lengths must not be zero");
+        }
+        std::vector<std::array<float, 2>> bearings(static_cast<std::size_t>(width) * height);
+        for (uint16_t y = 0; y < height; ++y) {
+            for (uint16_t x = 0; x < width; ++x) {
+                bearings[x + y * static_cast<std::size_t>(width)] = {{(x - cx) / fx, (y - cy) / fy}};
+            }
+        }
+        return bearings;
+    }
+
+    /// warp_events compensates the camera rotation: each event is reprojected to the start of its time window.
+    /// The rotation is integrated from angular velocity samples (radians per second in the camera frame, x to the
+    /// right, y down and z forward), held constant until the next sample. A constant model needs a single sample.
+    /// Each pixel has a precomputed bearing (x / z, y / z) on the normalised image plane, which can include the
+    /// lens undistortion. The rotated bearing is projected with the pinhole model (fx, fy, cx, cy). The rotation
+    /// uses the second-order expansion of the exponential map, accurate for rotations of up to a few degrees per
+    /// window. event_to_warped_event(event, x, y) is called with the warped coordinates, which may lie outside the
+    /// sensor.
+    template <typename Event, typename WarpedEvent, typename EventToWarpedEvent, typename HandleWarpedEvent>
+    class warp_events {
+        public:
+        warp_events(
+            uint16_t width,
+            uint16_t height,
+            float fx,
+            float fy,
+            float cx,
+            float cy,
+            uint64_t window,
+            EventToWarpedEvent event_to_warped_event,
+            HandleWarpedEvent handle_warped_event) :
+            warp_events(
+                width,
+                height,
+                pinhole_bearings(width, height, fx, fy, cx, cy),
+                fx,
+                fy,
+                cx,
+                cy,
+                window,
+                std::forward<EventToWarpedEvent>(event_to_warped_event),
+                std::forward<HandleWarpedEvent>(handle_warped_event)) {}
+        warp_events(
+            uint16_t width,
+            uint16_t height,
+            std::vector<std::array<float, 2>> bearings,
+            float fx,
+            float fy,
+            float cx,
+            float cy,
+            uint64_t window,
+            EventToWarpedEvent event_to_warped_event,
+            HandleWarpedEvent handle_warped_event) :
+            _width(width),
+            _fx(fx),
+            _fy(fy),
+            _cx(cx),
+            _cy(cy),
+            _window(window),
+            _event_to_warped_event(std::forward<EventToWarpedEvent>(event_to_warped_event)),
+            _handle_warped_event(std::forward<HandleWarpedEvent>(handle_warped_event)),
+            _bearings(std::move(bearings)),
+            _reference_t(0),
+            _sample_t(0),
+            _angular_velocity{{0.0f, 0.0f, 0.0f}},
+            _sample_rotation{{0.0f, 0.0f, 0.0f}} {
+            if (_bearings.size() != static_cast<std::size_t>(width) * height) {
+                throw std::logic_error("bearings must have width * height elements");
+            }
+            if (window == 0) {
+                throw std::logic_error("window must be larger than zero");
+            }
+        }
+        warp_events(const warp_events&) = delete;
+        warp_events(warp_events&&) = default;
+        warp_events& operator=(const warp_events&) = delete;
+        warp_events& operator=(warp_events&&) = default;
+        virtual ~warp_events() {}
+
+        /// angular_velocity sets the angular velocity (radians per second) from t on.
+        /// Samples and events must be given in chronological order.
+        void angular_velocity(uint64_t t, float x, float y, float z) {
+            advance(t);
+            _sample_rotation = rotation(t);
+            _sample_t = t;
+            _angular_velocity = {{x, y, z}};
+        }
+
+        /// operator() handles an event.
+        virtual void operator()(Event event) {
+            advance(event.t);
+            const auto& bearing = _bearings[event.x + event.y * static_cast<std::size_t>(_width)];
+            auto x = bearing[0];
+            auto y = bearing[1];
+            const auto delta_t = static_cast<float>(event.t - _sample_t) * 1e-6f;
+            warp(
+                _sample_rotation[0] + _angular_velocity[0] * delta_t,
+                _sample_rotation[1] + _angular_velocity[1] * delta_t,
+                _sample_rotation[2] + _angular_velocity[2] * delta_t,
+                _fx,
+                _fy,
+                _cx,
+                _cy,
+                x,
+                y);
+            _handle_warped_event(_event_to_warped_event(event, x, y));
+        }
+
+        /// operator() handles a batch of events.
+        /// The bearings are gathered first, so that the warp loop has no memory indirection and vectorises.
+        virtual void operator()(const Event* events, std::size_t count) {
+            _xs.resize(count);
+            _ys.resize(count);
+            _delta_ts.resize(count);
+            std::size_t begin = 0;
+            while (begin < count) {
+                advance(events[begin].t);
+                const auto window_end_t = _reference_t + _window;
+                auto end = begin + 1;
+                while (end < count && events[end].t < window_end_t) {
+                    ++end;
+                }
+                for (auto index = begin; index < end; ++index) {
+                    const auto& bearing =
+                        _bearings[events[index].x + events[index].y * static_cast<std::size_t>(_width)];
+                    _xs[index] = bearing[0];
+                    _ys[index] = bearing[1];
+                    _delta_ts[index] = static_cast<float>(events[index].t - _sample_t) * 1e-6f;
+                }
+                const auto sample_rotation = _sample_rotation;
+                const auto angular_velocity = _angular_velocity;
+                const auto fx = _fx;
+                const auto fy = _fy;
+                const auto cx = _cx;
+                const auto cy = _cy;
+                auto xs = _xs.data();
+                auto ys = _ys.data();
+                const auto delta_ts = _delta_ts.data();
+                for (auto index = begin; index < end; ++index) {
+                    warp(
+                        sample_rotation[0] + angular_velocity[0] * delta_ts[index],
+                        sample_rotation[1] + angular_velocity[1] * delta_ts[index],
+                        sample_rotation[2] + angular_velocity[2] * delta_ts[index],
+                        fx,
+                        fy,
+                        cx,
+                        cy,
+                        xs[index],
+                        ys[index]);
+                }
+                begin = end;
+            }
+            for (std::size_t index = 0; index < count; ++index) {
+                _handle_warped_event(_event_to_warped_event(events[index], _xs[index], _ys[index]));
+            }
+        }
+
+        /// reference_t returns the start of the current window, to which events are warped.
+        uint64_t reference_t() const {
+            return _reference_t;
+        }
+
+        protected:
+        /// advance moves the reference to the window that contains t.
+        void advance(uint64_t t) {
+            if (t >= _reference_t + _window) {
+                const auto reference_t = t - t % _window;
+                const auto reference_rotation = rotation(reference_t);
+                for (std::size_t index = 0; index < 3; ++index) {
+                    _sample_rotation[index] -= reference_rotation[index];
+                }
+                _reference_t = reference_t;
+            }
+        }
+
+        /// rotation returns the rotation vector between the reference and t (t must not precede the last sample).
+        std::array<float, 3> rotation(uint64_t t) const {
+            const auto delta_t = static_cast<float>(t - _sample_t) * 1e-6f;
+            return {{
+                _sample_rotation[0] + _angular_velocity[0] * delta_t,
+                _sample_rotation[1] + _angular_velocity[1] * delta_t,
+                _sample_rotation[2] + _angular_velocity[2] * delta_t,
+            }};
+        }
+
+        /// warp rotates a bearing (x, y) by the rotation vector (rx, ry, rz), and replaces it with the pixel
+        /// coordinates of the result.
+        static void warp(float rx, float ry, float rz, float fx, float fy, float cx, float cy, float& x, float& y) {
+            const auto bx = x;
+            const auto by = y;
+            const auto cross_x = ry - rz * by;
+            const auto cross_y = rz * bx - rx;
+            const auto cross_z = rx * by - ry * bx;
+            const auto dot = rx * bx + ry * by + rz;
+            const auto squared_norm = rx * rx + ry * ry + rz * rz;
+            const auto warped_x = bx + cross_x + 0.5f * (rx * dot - bx * squared_norm);
+            const auto warped_y = by + cross_y + 0.5f * (ry * dot - by * squared_norm);
+            const auto inverse_warped_z = 1.0f / (1.0f + cross_z + 0.5f * (rz * dot - squared_norm));
+            x = fx * warped_x * inverse_warped_z + cx;
+            y = fy * warped_y * inverse_warped_z + cy;
+        }
+
+        const uint16_t _width;
+        const float _fx;
+        const float _fy;
+        const float _cx;
+        const float _cy;
+        const uint64_t _window;
+        EventToWarpedEvent _event_to_warped_event;
+        HandleWarpedEvent _handle_warped_event;
+        std::vector<std::array<float, 2>> _bearings;
+        uint64_t _reference_t;
+        uint64_t _sample_t;
+        std::array<float, 3> _angular_velocity;
+        std::array<float, 3> _sample_rotation;
+        std::vector<float> _xs;
+        std::vector<float> _ys;
+        std::vector<float> _delta_ts;
+    };
+
+    /// make_warp_events creates a warp_events for a pinhole camera from functors.
+    template <typename Event, typename WarpedEvent, typename EventToWarpedEvent, typename HandleWarpedEvent>
+    warp_events<Event, WarpedEvent, EventToWarpedEvent, HandleWarpedEvent> make_warp_events(
+        uint16_t width,
+        uint16_t height,
+        float fx,
+        float fy,
+        float cx,
+        float cy,
+        uint64_t window,
+        EventToWarpedEvent event_to_warped_event,
+        HandleWarpedEvent handle_warped_event) {
+        return warp_events<Event, WarpedEvent, EventToWarpedEvent, HandleWarpedEvent>(
+            width,
+            height,
+            fx,
+            fy,
+            cx,
+            cy,
+            window,
+            std::forward<EventToWarpedEvent>(event_to_warped_event),
+            std::forward<HandleWarpedEvent>(handle_warped_event));
+    }
+
+    /// make_warp_events creates a warp_events with precomputed bearings from functors.
+    template <typename Event, typename WarpedEvent, typename EventToWarpedEvent, typename HandleWarpedEvent>
+    warp_events<Event, WarpedEvent, EventToWarpedEvent, HandleWarpedEvent> make_warp_events(
+        uint16_t width,
+        uint16_t height,
+        std::vector<std::array<float, 2>> bearings,
+        float fx,
+        float fy,
+        float cx,
+        float cy,
+        uint64_t window,
+        EventToWarpedEvent event_to_warped_event,
+        HandleWarpedEvent handle_warped_event) {
+        return warp_events<Event, WarpedEvent, EventToWarpedEvent, HandleWarpedEvent>(
+            width,
+            height,
+            std::move(bearings),
+            fx,
+            fy,
+            cx,
+            cy,
+            window,
+            std::forward<EventToWarpedEvent>(event_to_warped_event),
+            std::forward<HandleWarpedEvent>(handle_warped_event));
+    }
+}
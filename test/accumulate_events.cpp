@@ -0,0 +1,28 @@
+#include "../source/accumulate_events.hpp"
+#include "../third_party/Catch2/single_include/catch.hpp"
+
+struct warped_event {
+    uint64_t t;
+    float x;
+    float y;
+} __attribute__((packed));
+
+TEST_CASE("Accumulate events with bilinear weights", "[accumulate_events]") {
+    auto accumulate_events = tarsier::make_accumulate_events<warped_event>(4, 3);
+    accumulate_events(warped_event{0, 1.25f, 0.5f});
+    REQUIRE(std::abs(accumulate_events.frame()[1] - 0.375f) < 1e-6f);
+    REQUIRE(std::abs(accumulate_events.frame()[2] - 0.125f) < 1e-6f);
+    REQUIRE(std::abs(accumulate_events.frame()[1 + 4] - 0.375f) < 1e-6f);
+    REQUIRE(std::abs(accumulate_events.frame()[2 + 4] - 0.125f) < 1e-6f);
+    const std::vector<warped_event> events{{1, 3.5f, 2.0f}, {2, -0.5f, 0.0f}, {3, 10.0f, 1.0f}, {4, 0.0f, -2.0f}};
+    accumulate_events(events.data(), events.size());
+    REQUIRE(std::abs(accumulate_events.frame()[3 + 2 * 4] - 0.5f) < 1e-6f);
+    REQUIRE(std::abs(accumulate_events.frame()[0] - 0.5f) < 1e-6f);
+    float sum = 0.0f;
+    for (auto value : accumulate_events.frame()) {
+        sum += value;
+    }
+    REQUIRE(std::abs(sum - 2.0f) < 1e-6f);
+    accumulate_events.clear();
+    REQUIRE(accumulate_events.frame()[1] == 0.0f);
+}
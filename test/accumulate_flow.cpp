@@ -0,0 +1,42 @@
+#include "../source/accumulate_flow.hpp"
+#include "../third_party/Catch2/single_include/catch.hpp"
+
+struct flow {
+    uint64_t t;
+    uint16_t x;
+    uint16_t y;
+    float vx;
+    float vy;
+} __attribute__((packed));
+
+TEST_CASE("Accumulate optical flow events on a grid", "[accumulate_flow]") {
+    auto accumulate_flow = tarsier::make_accumulate_flow<flow>(320, 240, 16, 1000, true);
+    REQUIRE(accumulate_flow.columns() == 20);
+    REQUIRE(accumulate_flow.rows() == 15);
+    accumulate_flow(flow{1000, 100, 100, 1.0f, 2.0f});
+    accumulate_flow(flow{1000, 101, 102, 1.0f, 2.0f});
+    accumulate_flow(flow{1000, 102, 100, 50.0f, -50.0f});
+    accumulate_flow(flow{1000, 103, 101, 1.0f, 2.0f});
+    std::vector<tarsier::accumulate_flow<flow>::cell> cells(accumulate_flow.columns() * accumulate_flow.rows());
+    accumulate_flow.snapshot(2000, cells.data());
+    const auto& cell = cells[100 / 16 + (100 / 16) * accumulate_flow.columns()];
+    REQUIRE(std::abs(cell.vx - 1.0f) < 1e-6f);
+    REQUIRE(std::abs(cell.vy - 2.0f) < 1e-6f);
+    REQUIRE(std::abs(cell.confidence - 4.0f * std::exp(-1.0f)) < 1e-5f);
+    REQUIRE(cells[0].confidence == 0.0f);
+    REQUIRE_THROWS_AS((tarsier::make_accumulate_flow<flow>(320, 240, 16, 0, true)), std::logic_error);
+    tarsier::snapshot<std::vector<tarsier::accumulate_flow<flow>::cell>> cells_snapshot;
+    auto published_accumulate_flow = tarsier::make_accumulate_flow<flow>(32, 16, 16, 1000, false);
+    published_accumulate_flow.publish_to(cells_snapshot, 500);
+    published_accumulate_flow(flow{1000, 20, 5, 3.0f, 0.0f});
+    REQUIRE(cells_snapshot.load().size() == 2);
+    REQUIRE(cells_snapshot.load()[1].vx == 3.0f);
+    REQUIRE(cells_snapshot.load()[1].confidence == 1.0f);
+    published_accumulate_flow(flow{1200, 20, 5, 1.0f, 0.0f});
+    REQUIRE(cells_snapshot.load()[1].vx == 3.0f);
+    published_accumulate_flow(flow{1500, 2, 5, -1.0f, 0.0f});
+    const auto& published_cells = cells_snapshot.load();
+    REQUIRE(published_cells[0].vx == -1.0f);
+    REQUIRE(std::abs(published_cells[1].vx - (3.0f * std::exp(-0.2f) + 1.0f) / (std::exp(-0.2f) + 1.0f)) < 1e-5f);
+    REQUIRE(std::abs(published_cells[1].confidence - (std::exp(-0.5f) + std::exp(-0.3f))) < 1e-5f);
+}
@@ -0,0 +1,80 @@
+#include "../source/allocators.hpp"
+#include "../source/compute_activity.hpp"
+#include "../source/compute_flow.hpp"
+#include "../source/guarded_active_events.hpp"
+#include "../source/stitch.hpp"
+#include "../third_party/Catch2/single_include/catch.hpp"
+
+struct event {
+    uint64_t t;
+    uint16_t x;
+    uint16_t y;
+} __attribute__((packed));
+
+struct output {
+    uint64_t t;
+    float value;
+} __attribute__((packed));
+
+struct threshold_crossing {
+    uint64_t t;
+    uint16_t x;
+    uint16_t y;
+    bool is_second;
+} __attribute__((packed));
+
+TEST_CASE("Allocate pixel maps with alignment, huge pages and NUMA-local pages", "[allocators]") {
+    std::vector<uint64_t, tarsier::aligned_allocator<uint64_t>> aligned_ts(1000, 1);
+    REQUIRE(reinterpret_cast<uintptr_t>(aligned_ts.data()) % tarsier::cache_line_size == 0);
+    std::vector<uint64_t, tarsier::huge_page_allocator<uint64_t>> huge_page_ts(1280 * 720, 2);
+    REQUIRE(reinterpret_cast<uintptr_t>(huge_page_ts.data()) % tarsier::huge_page_size == 0);
+    REQUIRE(huge_page_ts.back() == 2);
+    std::vector<uint64_t, tarsier::numa_local_allocator<uint64_t>> numa_local_ts(1280 * 720, 3);
+    REQUIRE(numa_local_ts.front() == 3);
+
+    std::vector<float> potentials;
+    auto compute_activity = tarsier::make_compute_activity<event, output>(
+        1280,
+        720,
+        10000,
+        [](event event, float potential) -> output {
+            return {event.t, potential};
+        },
+        [&](output output) -> void { potentials.push_back(output.value); },
+        tarsier::emit_always(),
+        tarsier::huge_page_allocator<uint8_t>());
+    std::vector<float> flows;
+    auto compute_flow = tarsier::make_compute_flow<event, output>(
+        tarsier::guarded_active_events<void, 1280, 720, 3, tarsier::aligned_allocator<uint64_t>>(),
+        3,
+        1000000,
+        5,
+        [](event event, float vx, float) -> output {
+            return {event.t, vx};
+        },
+        [&](output output) -> void { flows.push_back(output.value); });
+    for (uint64_t t = 0; t < 100; ++t) {
+        const event event{1000 + t * 1000, static_cast<uint16_t>(1270 + t % 10), static_cast<uint16_t>(715 + t % 5)};
+        compute_activity(event);
+        compute_flow(event);
+    }
+    REQUIRE(potentials.size() == 100);
+    REQUIRE(std::abs(potentials.back() - 1.0f / (1.0f - std::exp(-1.0f))) < 1e-3f);
+    REQUIRE(!flows.empty());
+
+    std::size_t count = 0;
+    auto stitch = tarsier::make_stitch<threshold_crossing, output>(
+        1280,
+        720,
+        [](threshold_crossing threshold_crossing, uint64_t delta_t) -> output {
+            return {threshold_crossing.t, static_cast<float>(delta_t)};
+        },
+        [&](output output) -> void {
+            REQUIRE(output.value == 200.0f);
+            ++count;
+        },
+        tarsier::numa_local_allocator<uint8_t>());
+    stitch(threshold_crossing{0, 1279, 719, false});
+    stitch(threshold_crossing{200, 1279, 719, true});
+    REQUIRE(count == 1);
+}
@@ -0,0 +1,63 @@
+#include "../source/cluster_events.hpp"
+#include "../third_party/Catch2/single_include/catch.hpp"
+#include <string>
+
+struct event {
+    uint64_t t;
+    uint16_t x;
+    uint16_t y;
+} __attribute__((packed));
+
+struct cluster_event {
+    uint64_t t;
+    uint16_t x;
+    uint16_t y;
+    uint64_t cluster;
+} __attribute__((packed));
+
+TEST_CASE("Cluster connected events", "[cluster_events]") {
+    std::vector<uint64_t> clusters;
+    std::string changes;
+    auto cluster_events = tarsier::make_cluster_events<event, cluster_event>(
+        100,
+        100,
+        1,
+        1000,
+        [](event event, uint64_t cluster) -> cluster_event {
+            return {event.t, event.x, event.y, cluster};
+        },
+        [&](cluster_event cluster_event) -> void { clusters.push_back(cluster_event.cluster); },
+        [&](uint64_t, tarsier::cluster_change change, uint64_t cluster, uint64_t other_cluster) -> void {
+            switch (change) {
+                case tarsier::cluster_change::create:
+                    changes += "c" + std::to_string(cluster) + " ";
+                    break;
+                case tarsier::cluster_change::merge:
+                    changes += "m" + std::to_string(cluster) + ">" + std::to_string(other_cluster) + " ";
+                    break;
+                case tarsier::cluster_change::end:
+                    changes += "e" + std::to_string(cluster) + " ";
+                    break;
+            }
+        });
+    cluster_events(event{10, 10, 10});
+    cluster_events(event{20, 11, 10});
+    cluster_events(event{30, 12, 11});
+    cluster_events(event{40, 16, 10});
+    cluster_events(event{50, 15, 10});
+    REQUIRE(cluster_events.number_of_clusters() == 2);
+    cluster_events(event{60, 14, 10});
+    REQUIRE(cluster_events.number_of_clusters() == 2);
+    cluster_events(event{70, 13, 11});
+    REQUIRE(cluster_events.number_of_clusters() == 1);
+    cluster_events(event{80, 50, 50});
+    cluster_events(event{1075, 51, 50});
+    REQUIRE(cluster_events.number_of_clusters() == 1);
+    cluster_events(event{1090, 11, 11});
+    REQUIRE(cluster_events.number_of_clusters() == 2);
+    REQUIRE(clusters == std::vector<uint64_t>({0, 0, 0, 1, 1, 1, 1, 2, 2, 3}));
+    REQUIRE(changes == "c0 c1 m0>1 c2 e1 c3 ");
+    cluster_events(event{1000, 90, 90});
+    REQUIRE(cluster_events.number_of_clusters() == 3);
+    REQUIRE(changes == "c0 c1 m0>1 c2 e1 c3 c4 ");
+}
@@ -0,0 +1,42 @@
+#include "../source/cluster_frequencies.hpp"
+#include "../third_party/Catch2/single_include/catch.hpp"
+#include <cmath>
+
+struct pixel_frequency {
+    uint64_t t;
+    uint16_t x;
+    uint16_t y;
+    float frequency;
+};
+
+TEST_CASE("Cluster pixels by frequency", "[cluster_frequencies]") {
+    std::vector<tarsier::frequency_marker> markers;
+    auto cluster_frequencies = tarsier::make_cluster_frequencies<pixel_frequency, tarsier::frequency_marker>(
+        5.0f,
+        0.05f,
+        0.1f,
+        10000,
+        2,
+        [](pixel_frequency, const tarsier::frequency_marker& marker) -> tarsier::frequency_marker { return marker; },
+        [&](tarsier::frequency_marker marker) {
+            if (marker.id >= markers.size()) {
+                markers.resize(marker.id + 1);
+            }
+            markers[marker.id] = marker;
+        });
+    for (uint64_t t = 1; t < 1000; ++t) {
+        cluster_frequencies(pixel_frequency{t, static_cast<uint16_t>(9 + t % 3), static_cast<uint16_t>(10), 500.0f});
+        cluster_frequencies(pixel_frequency{t, static_cast<uint16_t>(10), static_cast<uint16_t>(11), 1250.0f});
+        cluster_frequencies(pixel_frequency{t, static_cast<uint16_t>(100), static_cast<uint16_t>(50), 505.0f});
+    }
+    REQUIRE(markers.size() == 2);
+    REQUIRE(std::abs(markers[0].x - 10.0f) < 1.0f);
+    REQUIRE(std::abs(markers[0].y - 10.0f) < 0.01f);
+    REQUIRE(std::abs(markers[0].frequency - 500.0f) < 0.01f);
+    REQUIRE(markers[0].count == 999);
+    REQUIRE(std::abs(markers[1].frequency - 1250.0f) < 0.01f);
+    REQUIRE(markers[1].count == 999);
+    cluster_frequencies(pixel_frequency{20000, static_cast<uint16_t>(100), static_cast<uint16_t>(50), 505.0f});
+    REQUIRE(markers.size() == 3);
+    REQUIRE(markers[2].x == 100.0f);
+}
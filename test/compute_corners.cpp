@@ -0,0 +1,72 @@
+#include "../source/compute_corners.hpp"
+#include "../third_party/Catch2/single_include/catch.hpp"
+
+struct event {
+    uint64_t t;
+    uint16_t x;
+    uint16_t y;
+    bool polarity;
+} __attribute__((packed));
+
+struct corner {
+    uint64_t t;
+    uint16_t x;
+    uint16_t y;
+} __attribute__((packed));
+
+TEST_CASE("Detect corners on the surface of active events", "[compute_corners]") {
+    std::vector<corner> corners;
+    auto compute_corners = tarsier::make_compute_corners<event, corner>(
+        320,
+        240,
+        true,
+        [](event event) -> corner {
+            return {event.t, event.x, event.y};
+        },
+        [&](corner corner) -> void { corners.push_back(corner); });
+    uint64_t t = 1000;
+    for (uint16_t y = 90; y <= 100; ++y) {
+        for (uint16_t x = 90; x <= 160; ++x) {
+            compute_corners(event{t, x, y, true});
+        }
+        t += 100;
+    }
+    corners.clear();
+    for (uint16_t y = 96; y <= 100; ++y) {
+        for (uint16_t x = 96; x <= 100; ++x) {
+            compute_corners(event{t, x, y, true});
+            ++t;
+        }
+    }
+    REQUIRE(!corners.empty());
+    REQUIRE(corners.back().x == 100);
+    REQUIRE(corners.back().y == 100);
+    corners.clear();
+    compute_corners(event{t, 100, 100, false});
+    compute_corners(event{t, 150, 100, true});
+    REQUIRE(corners.empty());
+    const std::array<std::pair<int32_t, int32_t>, 16> inner_circle{{
+        {0, 3}, {1, 3}, {2, 2}, {3, 1}, {3, 0}, {3, -1}, {2, -2}, {1, -3},
+        {0, -3}, {-1, -3}, {-2, -2}, {-3, -1}, {-3, 0}, {-3, 1}, {-2, 2}, {-1, 3},
+    }};
+    auto unrefined_compute_corners = tarsier::make_compute_corners<event, corner>(
+        320,
+        240,
+        false,
+        [](event event) -> corner {
+            return {event.t, event.x, event.y};
+        },
+        [&](corner corner) -> void { corners.push_back(corner); });
+    // the 11 newest pixels form an arc, but none of the 3 to 6 newest do
+    for (std::size_t index = 0; index < inner_circle.size(); ++index) {
+        unrefined_compute_corners(event{
+            index < 11 ? 2000 + index + (index % 2 == 0 ? 100 : 0) : 1000 + index,
+            static_cast<uint16_t>(50 + inner_circle[index].first),
+            static_cast<uint16_t>(50 + inner_circle[index].second),
+            true});
+    }
+    corners.clear();
+    unrefined_compute_corners(event{3000, 50, 50, true});
+    REQUIRE(corners.size() == 1);
+    REQUIRE(corners.back().x == 50);
+}
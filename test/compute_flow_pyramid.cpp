@@ -0,0 +1,137 @@
+#include "../source/compute_flow.hpp"
+#include "../source/compute_flow_pyramid.hpp"
+#include "../third_party/Catch2/single_include/catch.hpp"
+#include <algorithm>
+
+struct event {
+    uint64_t t;
+    uint16_t x;
+    uint16_t y;
+} __attribute__((packed));
+
+struct flow {
+    uint64_t t;
+    uint16_t x;
+    uint16_t y;
+    float vx;
+    float vy;
+} __attribute__((packed));
+
+TEST_CASE("Compute the optical flow on a pyramid of timestamp maps", "[compute_flow_pyramid]") {
+    std::vector<flow> flows;
+    auto compute_flow_pyramid = tarsier::make_compute_flow_pyramid<event, flow>(
+        320,
+        240,
+        3,
+        2,
+        100000,
+        10,
+        500,
+        [](event event, float vx, float vy) -> flow {
+            return {event.t, event.x, event.y, vx, vy};
+        },
+        [&](flow flow) -> void { flows.push_back(flow); });
+    for (uint16_t x = 60; x < 100; ++x) {
+        for (uint16_t y = 80; y < 120; ++y) {
+            compute_flow_pyramid(event{1000000 + x * 100ull, x, y});
+        }
+    }
+    REQUIRE(!flows.empty());
+    REQUIRE(flows.back().x == 99);
+    REQUIRE(std::abs(flows.back().vx - 0.01f) < 1e-3f);
+    REQUIRE(std::abs(flows.back().vy) < 1e-3f);
+
+    // a single level yields the same flow events as compute_flow
+    std::vector<flow> single_level_flows;
+    auto single_level_compute_flow_pyramid = tarsier::make_compute_flow_pyramid<event, flow>(
+        320,
+        240,
+        1,
+        2,
+        100000,
+        10,
+        500,
+        [](event event, float vx, float vy) -> flow {
+            return {event.t, event.x, event.y, vx, vy};
+        },
+        [&](flow flow) -> void { single_level_flows.push_back(flow); });
+    std::vector<flow> reference_flows;
+    auto compute_flow = tarsier::make_compute_flow<event, flow>(
+        320,
+        240,
+        2,
+        100000,
+        10,
+        [](event event, float vx, float vy) -> flow {
+            return {event.t, event.x, event.y, vx, vy};
+        },
+        [&](flow flow) -> void { reference_flows.push_back(flow); });
+    uint64_t seed = 1;
+    for (uint16_t x = 60; x < 100; ++x) {
+        for (uint16_t y = 80; y < 120; ++y) {
+            seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+            const event event{1000000 + x * 700ull + y * 300ull + (seed >> 57), x, y};
+            single_level_compute_flow_pyramid(event);
+            compute_flow(event);
+        }
+    }
+    REQUIRE(!reference_flows.empty());
+    REQUIRE(single_level_flows.size() == reference_flows.size());
+    for (std::size_t index = 0; index < reference_flows.size(); ++index) {
+        REQUIRE(single_level_flows[index].t == reference_flows[index].t);
+        REQUIRE(single_level_flows[index].x == reference_flows[index].x);
+        REQUIRE(single_level_flows[index].y == reference_flows[index].y);
+        REQUIRE(single_level_flows[index].vx == reference_flows[index].vx);
+        REQUIRE(single_level_flows[index].vy == reference_flows[index].vy);
+    }
+
+    // a slow motion is first fitted on the coarsest level, then refined down to the finest one
+    for (auto period : {1000ull, 10ull}) {
+        std::vector<flow> pyramid_flows;
+        auto coarse_to_fine_compute_flow_pyramid = tarsier::make_compute_flow_pyramid<event, flow>(
+            320,
+            240,
+            3,
+            2,
+            100000,
+            10,
+            500,
+            [](event event, float vx, float vy) -> flow {
+                return {event.t, event.x, event.y, vx, vy};
+            },
+            [&](flow flow) -> void { pyramid_flows.push_back(flow); });
+        std::vector<flow> finest_flows;
+        auto finest_compute_flow = tarsier::make_compute_flow<event, flow>(
+            320,
+            240,
+            2,
+            100000,
+            10,
+            [](event event, float vx, float vy) -> flow {
+                return {event.t, event.x, event.y, vx, vy};
+            },
+            [&](flow flow) -> void { finest_flows.push_back(flow); });
+        for (uint16_t x = 60; x < 100; ++x) {
+            for (uint16_t y = 80; y < 120; ++y) {
+                seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+                const event event{1000000 + x * period + (seed >> 62), x, y};
+                coarse_to_fine_compute_flow_pyramid(event);
+                finest_compute_flow(event);
+            }
+        }
+        // the flows are compared inside the edge, on the last column of a level 2 cell
+        const auto is_probe = [](flow flow) { return flow.x == 83 && flow.y == 100; };
+        const auto pyramid_flow = std::find_if(pyramid_flows.begin(), pyramid_flows.end(), is_probe);
+        const auto finest_flow = std::find_if(finest_flows.begin(), finest_flows.end(), is_probe);
+        REQUIRE(pyramid_flow != pyramid_flows.end());
+        REQUIRE(finest_flow != finest_flows.end());
+        if (period == 1000) {
+            REQUIRE(pyramid_flow->vx == finest_flow->vx);
+            REQUIRE(pyramid_flow->vy == finest_flow->vy);
+        } else {
+            // a fast motion crosses the finer windows too quickly, and keeps the (jitter-dependent) coarse estimate
+            REQUIRE(pyramid_flow->vx != finest_flow->vx);
+            REQUIRE(std::abs(pyramid_flow->vx - 0.1f) < 0.02f);
+        }
+    }
+}
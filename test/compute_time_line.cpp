@@ -0,0 +1,55 @@
+#include "../source/compute_time_line.hpp"
+#include "../third_party/Catch2/single_include/catch.hpp"
+
+struct event {
+    uint64_t t;
+    uint16_t x;
+    uint16_t y;
+    bool polarity;
+} __attribute__((packed));
+
+TEST_CASE("Compute time lines from events", "[compute_time_line]") {
+    REQUIRE(sizeof(tarsier::pixel_time_line<bool, 4>) == 32);
+    REQUIRE(sizeof(tarsier::pixel_time_line<bool, 10>) == 64);
+    REQUIRE(alignof(tarsier::pixel_time_line<bool, 10>) == 64);
+    REQUIRE(sizeof(tarsier::pixel_time_line<void, 2>) == 32);
+    std::vector<uint64_t> intervals;
+    auto compute_time_line = tarsier::make_compute_time_line<event, bool, uint64_t, 4>(
+        320,
+        240,
+        [](event event, const tarsier::pixel_time_line<bool, 4>& time_line) -> uint64_t {
+            REQUIRE(time_line.t(0) == event.t);
+            REQUIRE(time_line.polarity(0) == event.polarity);
+            return time_line.size() < 2 ? 0 : time_line.interval(0);
+        },
+        [&](uint64_t interval) { intervals.push_back(interval); });
+    compute_time_line(event{100, 5, 6, true});
+    compute_time_line(event{200, 6, 6, true});
+    compute_time_line(event{250, 5, 6, true});
+    compute_time_line(event{400, 5, 6, false});
+    compute_time_line(event{1000, 5, 6, true});
+    compute_time_line(event{1600, 5, 6, true});
+    compute_time_line(event{(1ull << 33) + 1600, 6, 6, false});
+    REQUIRE((intervals == std::vector<uint64_t>{0, 0, 150, 150, 600, 600, 4294967295ull}));
+    const auto& time_line = compute_time_line.time_line(5, 6);
+    REQUIRE(time_line.size() == 4);
+    REQUIRE(time_line.t(0) == 1600);
+    REQUIRE(time_line.t(1) == 1000);
+    REQUIRE(time_line.t(2) == 400);
+    REQUIRE(time_line.t(3) == 250);
+    REQUIRE(!time_line.polarity(2));
+    REQUIRE(time_line.polarity(3));
+    const auto& saturated_time_line = compute_time_line.time_line(6, 6);
+    REQUIRE(saturated_time_line.size() == 2);
+    REQUIRE(saturated_time_line.t(1) == (1ull << 33) + 1600 - 4294967295ull);
+    REQUIRE(compute_time_line.time_line(0, 0).size() == 0);
+    tarsier::pixel_time_line<void, 255> full_time_line;
+    for (uint64_t t = 1; t <= 300; ++t) {
+        full_time_line.update(event{t * 10, 0, 0, false});
+        REQUIRE(full_time_line.size() == std::min(t, static_cast<uint64_t>(255)));
+    }
+    REQUIRE(full_time_line.t(0) == 3000);
+    REQUIRE(full_time_line.t(1) == 2990);
+    REQUIRE(full_time_line.t(254) == 460);
+    REQUIRE(full_time_line.interval(253) == 10);
+}
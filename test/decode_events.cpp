@@ -0,0 +1,51 @@
+#include "../source/decode_events.hpp"
+#include "../source/encode_events.hpp"
+#include "../third_party/Catch2/single_include/catch.hpp"
+#include <vector>
+
+struct event {
+    uint64_t t;
+    uint16_t x;
+    uint16_t y;
+} __attribute__((packed));
+
+TEST_CASE("Decode delta-encoded events", "[decode_events]") {
+    std::vector<event> events;
+    uint64_t t = 0;
+    uint32_t state = 1;
+    for (std::size_t index = 0; index < 100000; ++index) {
+        state = state * 1664525 + 1013904223;
+        t += (index % 1000 == 999 ? 1ull << 40 : (state >> 24) % 64);
+        const auto row_change = (state >> 8) % 4 == 0;
+        events.push_back(event{
+            t,
+            static_cast<uint16_t>(
+                index == 0 || row_change ? (state >> 4) % 640 : (events.back().x + (state >> 12) % 5) % 640),
+            static_cast<uint16_t>(index == 0 || row_change ? (state >> 14) % 480 : events.back().y)});
+    }
+    events[500].t = events[499].t - 10;
+    std::vector<uint8_t> buffer(1 << 12);
+    std::size_t total_size = 0;
+    std::vector<event> decoded_events;
+    auto decode_events =
+        tarsier::make_decode_events<event>([&](event event) -> void { decoded_events.push_back(event); });
+    auto encode_events = tarsier::make_encode_events<event>(
+        buffer.data(), buffer.size(), [&](const uint8_t* data, std::size_t size) -> void {
+            total_size += size;
+            decode_events(data, size);
+        });
+    for (auto event : events) {
+        encode_events(event);
+    }
+    encode_events.flush();
+    REQUIRE(static_cast<float>(total_size) / events.size() < 4.0f);
+    REQUIRE(decoded_events.size() == events.size());
+    auto identical = true;
+    for (std::size_t index = 0; index < events.size(); ++index) {
+        identical &= decoded_events[index].t == events[index].t && decoded_events[index].x == events[index].x
+                     && decoded_events[index].y == events[index].y;
+    }
+    REQUIRE(identical);
+    const uint8_t truncated[] = {0xe8};
+    REQUIRE_THROWS_AS(decode_events(truncated, sizeof(truncated)), std::runtime_error);
+}
@@ -0,0 +1,68 @@
+#include "../source/detect_frequency.hpp"
+#include "../third_party/Catch2/single_include/catch.hpp"
+
+struct event {
+    uint64_t t;
+    uint16_t x;
+    uint16_t y;
+    bool polarity;
+} __attribute__((packed));
+
+struct pixel_frequency {
+    uint64_t t;
+    uint16_t x;
+    uint16_t y;
+    float frequency;
+};
+
+TEST_CASE("Detect the frequency of blinking pixels", "[detect_frequency]") {
+    std::size_t count = 0;
+    auto detect_frequency = tarsier::make_detect_frequency<event, pixel_frequency>(
+        320,
+        240,
+        100.0f,
+        2000.0f,
+        0.05f,
+        0.1f,
+        4,
+        [](event event, float frequency) -> pixel_frequency {
+            return {event.t, event.x, event.y, frequency};
+        },
+        [&](pixel_frequency pixel_frequency) {
+            ++count;
+            if (pixel_frequency.x < 20) {
+                REQUIRE(std::abs(pixel_frequency.frequency - 500.0f) < 1.0f);
+            } else {
+                REQUIRE(pixel_frequency.x == 100);
+                REQUIRE(std::abs(pixel_frequency.frequency - 1250.0f) < 1.0f);
+            }
+        });
+    uint64_t irregular_t = 1000;
+    bool irregular_polarity = true;
+    uint64_t seed = 1;
+    for (uint64_t t = 10; t < 100000; t += 10) {
+        for (uint64_t offset : {100, 110, 1100, 1110}) {
+            if (t % 2000 == offset) {
+                for (uint16_t y = 9; y <= 11; ++y) {
+                    for (uint16_t x = 9; x <= 11; ++x) {
+                        detect_frequency(event{t, x, y, offset < 1000});
+                    }
+                }
+            }
+        }
+        if (t % 800 == 30 || t % 800 == 430) {
+            detect_frequency(event{t, 100, 50, t % 800 == 30});
+        }
+        if (t == irregular_t) {
+            detect_frequency(event{t, 200, 200, irregular_polarity});
+            irregular_polarity = !irregular_polarity;
+            seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+            irregular_t += 300 + (seed >> 33) % 2700 / 10 * 10;
+        }
+    }
+    REQUIRE(count > 500);
+    REQUIRE(std::abs(detect_frequency.frequency(10, 10) - 500.0f) < 1.0f);
+    REQUIRE(std::abs(detect_frequency.frequency(100, 50) - 1250.0f) < 1.0f);
+    REQUIRE(detect_frequency.frequency(200, 200) == 0.0f);
+    REQUIRE(detect_frequency.frequency(0, 0) == 0.0f);
+}
@@ -0,0 +1,88 @@
+#include "../source/average_position.hpp"
+#include "../source/compute_activity.hpp"
+#include "../source/compute_flow.hpp"
+#include "../source/emission.hpp"
+#include "../source/track_blob.hpp"
+#include "../third_party/Catch2/single_include/catch.hpp"
+
+struct event {
+    uint64_t t;
+    uint16_t x;
+    uint16_t y;
+} __attribute__((packed));
+
+TEST_CASE("Decimate the outputs of per-event handlers", "[emission]") {
+    std::vector<uint64_t> positions_ts;
+    auto average_position = tarsier::make_average_position<event, uint64_t>(
+        0.0f,
+        0.0f,
+        0.5f,
+        [](event event, float, float) -> uint64_t { return event.t; },
+        [&](uint64_t t) -> void { positions_ts.push_back(t); },
+        tarsier::emit_on_change(10.0f));
+    std::vector<uint64_t> blobs_ts;
+    auto track_blob = tarsier::make_track_blob<event, uint64_t>(
+        0.0f,
+        0.0f,
+        1.0f,
+        0.0f,
+        1.0f,
+        0.9f,
+        0.9f,
+        [](event event, float, float, float, float, float) -> uint64_t { return event.t; },
+        [&](uint64_t t) -> void { blobs_ts.push_back(t); },
+        tarsier::emit_every_events(3));
+    std::vector<uint64_t> activities_ts;
+    auto compute_activity = tarsier::make_compute_activity<event, uint64_t>(
+        64,
+        64,
+        1000,
+        [](event event, float) -> uint64_t { return event.t; },
+        [&](uint64_t t) -> void { activities_ts.push_back(t); },
+        tarsier::emit_every_duration(250));
+    for (auto event : std::vector<event>{
+             {0, 0, 0},
+             {100, 4, 4},
+             {200, 8, 8},
+             {300, 40, 40},
+             {400, 40, 40},
+             {500, 40, 40},
+             {600, 40, 40},
+             {700, 41, 41},
+         }) {
+        average_position(event);
+        track_blob(event);
+        compute_activity(event);
+    }
+    REQUIRE(positions_ts == std::vector<uint64_t>({0, 300, 500}));
+    REQUIRE(blobs_ts == std::vector<uint64_t>({200, 500}));
+    REQUIRE(activities_ts == std::vector<uint64_t>({0, 300, 600}));
+
+    tarsier::active_events<void> active_events(320, 240);
+    std::size_t flows = 0;
+    std::size_t decimated_flows = 0;
+    auto compute_flow = tarsier::make_compute_flow<event, uint64_t>(
+        320,
+        240,
+        2,
+        1000000,
+        3,
+        [](event event, float, float) -> uint64_t { return event.t; },
+        [&](uint64_t) -> void { ++flows; });
+    auto decimated_compute_flow = tarsier::make_compute_flow<event, uint64_t>(
+        active_events,
+        2,
+        1000000,
+        3,
+        [](event event, float, float) -> uint64_t { return event.t; },
+        [&](uint64_t) -> void { ++decimated_flows; },
+        tarsier::emit_every_events(4));
+    for (uint64_t t = 0; t < 100; ++t) {
+        const event event{1000 + t * 1000, static_cast<uint16_t>(100 + t % 5), static_cast<uint16_t>(100 + t / 5)};
+        compute_flow(event);
+        active_events.update(event);
+        decimated_compute_flow(event);
+    }
+    REQUIRE(flows > 90);
+    REQUIRE(decimated_flows == 25);
+}
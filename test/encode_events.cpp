@@ -0,0 +1,29 @@
+#include "../source/encode_events.hpp"
+#include "../third_party/Catch2/single_include/catch.hpp"
+#include <array>
+#include <vector>
+
+struct event {
+    uint64_t t;
+    uint16_t x;
+    uint16_t y;
+} __attribute__((packed));
+
+TEST_CASE("Encode events as deltas", "[encode_events]") {
+    std::array<uint8_t, 24> buffer;
+    std::vector<std::vector<uint8_t>> blocks;
+    auto encode_events = tarsier::make_encode_events<event>(
+        buffer.data(), buffer.size(), [&](const uint8_t* data, std::size_t size) -> void {
+            blocks.emplace_back(data, data + size);
+        });
+    encode_events(event{1000, 10, 5});
+    encode_events(event{1010, 11, 5});
+    encode_events(event{1015, 9, 6});
+    REQUIRE(blocks.empty());
+    encode_events(event{1020, 9, 6});
+    REQUIRE(blocks.size() == 1);
+    REQUIRE(blocks[0] == std::vector<uint8_t>({0xe8, 0x07, 0x29, 0x0a, 0x0a, 0x04, 0x05, 0x07, 0x02}));
+    encode_events.flush();
+    REQUIRE(blocks.size() == 2);
+    REQUIRE(blocks[1] == std::vector<uint8_t>({0xfc, 0x07, 0x25, 0x0c}));
+}
@@ -0,0 +1,45 @@
+#include "../source/erased_handler.hpp"
+#include "../third_party/Catch2/single_include/catch.hpp"
+#include <array>
+#include <vector>
+
+struct event {
+    uint64_t t;
+    uint16_t x;
+    uint16_t y;
+} __attribute__((packed));
+
+TEST_CASE("Call erased handlers with single events and batches", "[erased_handler]") {
+    std::vector<uint64_t> small_ts;
+    auto small = tarsier::make_erased_handler<event>([&](event event) { small_ts.push_back(event.t); });
+    std::array<uint64_t, 32> large_ts{};
+    std::size_t large_count = 0;
+    auto large = tarsier::make_erased_handler<event>([=, &large_count](event event) mutable {
+        large_ts[large_count % large_ts.size()] = event.t;
+        ++large_count;
+    });
+    std::size_t batches = 0;
+    std::size_t batch_events = 0;
+    auto batch = tarsier::make_erased_handler<event>([&](const event* events, std::size_t count) {
+        ++batches;
+        batch_events += count;
+        REQUIRE(events[0].t == 0);
+    });
+    const std::vector<event> events{{0, 1, 2}, {1, 3, 4}, {2, 5, 6}};
+    small(events[0]);
+    small(events.data() + 1, events.size() - 1);
+    large(events.data(), events.size());
+    batch(events.data(), events.size());
+    REQUIRE((small_ts == std::vector<uint64_t>{0, 1, 2}));
+    REQUIRE(large_count == 3);
+    REQUIRE(batches == 1);
+    REQUIRE(batch_events == 3);
+    auto moved = std::move(large);
+    moved(events[2]);
+    REQUIRE(large_count == 4);
+    REQUIRE_THROWS_AS(large(events[0]), std::logic_error);
+    small = std::move(moved);
+    small(events[0]);
+    REQUIRE(large_count == 5);
+    REQUIRE(small_ts.size() == 3);
+}
@@ -0,0 +1,121 @@
+#include "../source/average_position.hpp"
+#include "../source/compute_activity.hpp"
+#include "../source/fixed_point.hpp"
+#include "../source/track_blob.hpp"
+#include "../third_party/Catch2/single_include/catch.hpp"
+#include <limits>
+
+struct event {
+    uint64_t t;
+    uint16_t x;
+    uint16_t y;
+} __attribute__((packed));
+
+struct output {
+    uint64_t t;
+} __attribute__((packed));
+
+TEST_CASE("Filter events with fixed-point numbers", "[fixed_point]") {
+    typedef tarsier::fixed_point<16> q16_16;
+    REQUIRE((q16_16(1.5f) * q16_16(-2)).raw() == -3 * 65536);
+    REQUIRE(static_cast<float>(q16_16(0.25) + q16_16(3)) == 3.25f);
+    const auto maximum = q16_16::from_raw(std::numeric_limits<int32_t>::max());
+    const auto minimum = q16_16::from_raw(std::numeric_limits<int32_t>::min());
+    REQUIRE((maximum + q16_16::from_raw(1)) == minimum);
+    REQUIRE((minimum - q16_16::from_raw(1)) == maximum);
+    REQUIRE(-minimum == minimum);
+    REQUIRE(q16_16(int32_t(32768)).raw() == std::numeric_limits<int32_t>::min());
+    REQUIRE((q16_16(30000) * q16_16(2)).raw() == static_cast<int32_t>(60000ll * 65536 - 4294967296ll));
+    tarsier::exponential_decay<q16_16> exponential_decay(10000);
+    auto maximum_decay_error = 0.0f;
+    for (uint64_t delta_t = 0; delta_t < 200000; delta_t += 7) {
+        maximum_decay_error = std::max(
+            maximum_decay_error,
+            std::abs(
+                static_cast<float>(exponential_decay(delta_t)) - std::exp(-static_cast<float>(delta_t) / 10000.0f)));
+    }
+    REQUIRE(maximum_decay_error < 1e-6f);
+
+    std::vector<event> events;
+    for (uint64_t t = 0; t < 20000; ++t) {
+        events.push_back(event{t * 50, static_cast<uint16_t>(100 + (t * 7) % 40), static_cast<uint16_t>(60 + t % 30)});
+    }
+    auto maximum_position_error = 0.0f;
+    float x;
+    auto average_position = tarsier::make_average_position<event, output>(
+        0.0f,
+        0.0f,
+        0.999f,
+        [&](event event, float float_x, float) -> output {
+            x = float_x;
+            return {event.t};
+        },
+        [](output) -> void {});
+    auto fixed_average_position = tarsier::make_average_position<event, output, q16_16>(
+        0.0f,
+        0.0f,
+        0.999f,
+        [&](event event, q16_16 fixed_x, q16_16) -> output {
+            maximum_position_error = std::max(maximum_position_error, std::abs(static_cast<float>(fixed_x) - x));
+            return {event.t};
+        },
+        [](output) -> void {});
+    auto track_blob = tarsier::make_track_blob<event, output>(
+        120.0f,
+        75.0f,
+        100.0f,
+        0.0f,
+        100.0f,
+        0.999f,
+        0.999f,
+        [](event event, float, float, float, float, float) -> output { return {event.t}; },
+        [](output) -> void {});
+    auto fixed_track_blob = tarsier::make_track_blob<event, output, q16_16>(
+        120.0f,
+        75.0f,
+        100.0f,
+        0.0f,
+        100.0f,
+        0.999f,
+        0.999f,
+        [](event event, q16_16, q16_16, q16_16, q16_16, q16_16) -> output { return {event.t}; },
+        [](output) -> void {});
+    auto maximum_relative_potential_error = 0.0f;
+    float potential;
+    auto compute_activity = tarsier::make_compute_activity<event, output>(
+        1,
+        1,
+        10000,
+        [&](event event, float float_potential) -> output {
+            potential = float_potential;
+            return {event.t};
+        },
+        [](output) -> void {});
+    auto fixed_compute_activity = tarsier::make_compute_activity<event, output, q16_16>(
+        1,
+        1,
+        10000,
+        [&](event event, q16_16 fixed_potential) -> output {
+            maximum_relative_potential_error = std::max(
+                maximum_relative_potential_error,
+                std::abs(static_cast<float>(fixed_potential) - potential) / potential);
+            return {event.t};
+        },
+        [](output) -> void {});
+    for (auto event : events) {
+        average_position(event);
+        fixed_average_position(event);
+        track_blob(event);
+        fixed_track_blob(event);
+        compute_activity(::event{event.t, 0, 0});
+        fixed_compute_activity(::event{event.t, 0, 0});
+    }
+    REQUIRE(maximum_position_error < 0.015f);
+    REQUIRE(std::abs(track_blob.x() - static_cast<float>(fixed_track_blob.x())) < 0.05f);
+    REQUIRE(std::abs(track_blob.y() - static_cast<float>(fixed_track_blob.y())) < 0.05f);
+    REQUIRE(
+        std::abs(track_blob.sigma_x_squared() - static_cast<float>(fixed_track_blob.sigma_x_squared()))
+        / track_blob.sigma_x_squared()
+        < 1e-2f);
+    REQUIRE(maximum_relative_potential_error < 1e-5f);
+}
@@ -0,0 +1,99 @@
+#include "../source/compute_flow.hpp"
+#include "../source/compute_time_surface.hpp"
+#include "../source/guarded_active_events.hpp"
+#include "../source/mask_isolated.hpp"
+#include "../source/update_active_events.hpp"
+#include "../third_party/Catch2/single_include/catch.hpp"
+#include <cstring>
+#include <random>
+#include <sstream>
+
+struct event {
+    uint64_t t;
+    uint16_t x;
+    uint16_t y;
+    bool polarity;
+} __attribute__((packed));
+
+struct output {
+    uint64_t t;
+    float value;
+} __attribute__((packed));
+
+TEST_CASE("Compute neighbourhoods on a guard-banded map", "[guarded_active_events]") {
+    tarsier::active_events<bool> active_events(16, 12);
+    tarsier::guarded_active_events<bool, 16, 12, 2> guarded_active_events;
+    REQUIRE(guarded_active_events.width() == 16);
+    REQUIRE(guarded_active_events.height() == 12);
+    std::vector<float> outputs;
+    std::vector<float> guarded_outputs;
+    auto event_to_flow = [](event event, float vx, float vy) -> output { return {event.t, vx + vy}; };
+    auto event_to_time_surface = [](event event, std::array<std::pair<float, bool>, 25> projections_and_polarities) {
+        output output{event.t, 0.0f};
+        for (std::size_t index = 0; index < projections_and_polarities.size(); ++index) {
+            output.value += projections_and_polarities[index].first * static_cast<float>(index + 1)
+                            * (projections_and_polarities[index].second ? 1.0f : -1.0f);
+        }
+        return output;
+    };
+    auto mask_isolated = tarsier::make_mask_isolated<event>(
+        active_events, 1000, [&](event event) -> void { outputs.push_back(static_cast<float>(event.t)); });
+    auto compute_flow = tarsier::make_compute_flow<event, output>(
+        active_events, 2, 10000, 3, event_to_flow, [&](output output) -> void { outputs.push_back(output.value); });
+    auto compute_time_surface = tarsier::make_compute_time_surface<event, bool, output, 2>(
+        active_events, 10000, 1000, event_to_time_surface, [&](output output) -> void {
+            outputs.push_back(output.value);
+        });
+    auto guarded_mask_isolated =
+        tarsier::make_mask_isolated<event>(guarded_active_events, 1000, [&](event event) -> void {
+            guarded_outputs.push_back(static_cast<float>(event.t));
+        });
+    auto guarded_compute_flow = tarsier::make_compute_flow<event, output>(
+        guarded_active_events, 2, 10000, 3, event_to_flow, [&](output output) -> void {
+            guarded_outputs.push_back(output.value);
+        });
+    auto guarded_compute_time_surface = tarsier::make_compute_time_surface<event, bool, output, 2>(
+        guarded_active_events, 10000, 1000, event_to_time_surface, [&](output output) -> void {
+            guarded_outputs.push_back(output.value);
+        });
+    auto update_active_events = tarsier::make_update_active_events<event>(active_events, [&](event event) -> void {
+        mask_isolated(event);
+        compute_flow(event);
+        compute_time_surface(event);
+    });
+    auto update_guarded_active_events =
+        tarsier::make_update_active_events<event>(guarded_active_events, [&](event event) -> void {
+            guarded_mask_isolated(event);
+            guarded_compute_flow(event);
+            guarded_compute_time_surface(event);
+        });
+    std::mt19937 engine(42);
+    std::uniform_int_distribution<uint16_t> x_distribution(0, 15);
+    std::uniform_int_distribution<uint16_t> y_distribution(0, 11);
+    for (uint64_t t = 1; t <= 5000; ++t) {
+        const event event{t * 100, x_distribution(engine), y_distribution(engine), t % 3 == 0};
+        update_active_events(event);
+        update_guarded_active_events(event);
+    }
+    REQUIRE(outputs.size() > 5000);
+    REQUIRE(guarded_outputs.size() == outputs.size());
+    REQUIRE(std::memcmp(guarded_outputs.data(), outputs.data(), outputs.size() * sizeof(float)) == 0);
+    REQUIRE(guarded_active_events.t(-2, -2) == 0);
+    REQUIRE(guarded_active_events.t(17, 13) == 0);
+
+    std::stringstream stream;
+    guarded_mask_isolated.save_state(stream);
+    tarsier::guarded_active_events<bool, 16, 12, 2> loaded_active_events;
+    auto loaded_mask_isolated = tarsier::make_mask_isolated<event>(loaded_active_events, 1000, [](event) -> void {});
+    loaded_mask_isolated.load_state(stream);
+    for (uint16_t y = 0; y < 12; ++y) {
+        for (uint16_t x = 0; x < 16; ++x) {
+            REQUIRE(loaded_active_events.t(x, y) == active_events.t(x, y));
+            REQUIRE(loaded_active_events.polarity(x, y) == active_events.polarity(x, y));
+        }
+    }
+    REQUIRE_THROWS_AS(
+        (tarsier::make_compute_flow<event, output>(
+            guarded_active_events, 3, 10000, 3, event_to_flow, [](output) -> void {})),
+        std::logic_error);
+}
@@ -0,0 +1,58 @@
+#include "../source/index_activity.hpp"
+#include "../third_party/Catch2/single_include/catch.hpp"
+#include <random>
+#include <sstream>
+
+struct event {
+    uint64_t t;
+    uint16_t x;
+    uint16_t y;
+} __attribute__((packed));
+
+TEST_CASE("Count events in rectangles with Fenwick trees", "[index_activity]") {
+    std::vector<event> events;
+    auto index_activity =
+        tarsier::make_index_activity<event>(40, 30, 1000, 4, [&](event event) -> void { events.push_back(event); });
+    std::mt19937 engine(7);
+    std::uniform_int_distribution<uint16_t> x_distribution(0, 39);
+    std::uniform_int_distribution<uint16_t> y_distribution(0, 29);
+    std::size_t mismatches = 0;
+    for (uint64_t t = 0; t < 20000; t += 3) {
+        index_activity(event{t, x_distribution(engine), y_distribution(engine)});
+        if (t % 999 == 0) {
+            auto left = x_distribution(engine);
+            auto right = x_distribution(engine);
+            auto bottom = y_distribution(engine);
+            auto top = y_distribution(engine);
+            if (left > right) {
+                std::swap(left, right);
+            }
+            if (bottom > top) {
+                std::swap(bottom, top);
+            }
+            for (std::size_t number_of_buckets = 1; number_of_buckets <= 4; ++number_of_buckets) {
+                const auto first_bucket = t / 1000 < number_of_buckets ? 0 : t / 1000 + 1 - number_of_buckets;
+                uint64_t expected_count = 0;
+                for (auto event : events) {
+                    if (event.t / 1000 >= first_bucket && event.x >= left && event.x <= right && event.y >= bottom
+                        && event.y <= top) {
+                        ++expected_count;
+                    }
+                }
+                if (index_activity.count(left, bottom, right, top, number_of_buckets) != expected_count) {
+                    ++mismatches;
+                }
+            }
+        }
+    }
+    REQUIRE(mismatches == 0);
+    REQUIRE(index_activity.count(0, 0, 39, 29) == 1333);
+    REQUIRE(index_activity.count(0, 0, 39, 29, 1) == 333);
+
+    std::stringstream stream;
+    index_activity.save_state(stream);
+    index_activity(event{50000, 0, 0});
+    REQUIRE(index_activity.count(0, 0, 39, 29) == 1);
+    index_activity.load_state(stream);
+    REQUIRE(index_activity.count(0, 0, 39, 29) == 1333);
+}
@@ -0,0 +1,256 @@
+#include "../source/average_position.hpp"
+#include "../source/inertia.hpp"
+#include "../source/track_blob.hpp"
+#include "../third_party/Catch2/single_include/catch.hpp"
+#include <sstream>
+
+struct event {
+    uint64_t t;
+    uint16_t x;
+    uint16_t y;
+} __attribute__((packed));
+
+struct blob {
+    float x;
+    float y;
+    float sigma_x_squared;
+    float sigma_xy;
+    float sigma_y_squared;
+} __attribute__((packed));
+
+TEST_CASE("Filter with time constants and batches", "[inertia]") {
+    for (uint64_t period : {10, 100}) {
+        float x = 0.0f;
+        auto average_position = tarsier::make_average_position<event, float>(
+            0.0f,
+            0.0f,
+            tarsier::time_constant{1000},
+            [](event, float x, float) -> float { return x; },
+            [&](float position_x) { x = position_x; });
+        for (uint64_t t = period; t <= 1000; t += period) {
+            average_position(event{t, 100, 50});
+        }
+        REQUIRE(std::abs(x - 100.0f * (1.0f - std::exp(-1.0f))) < 1e-3f);
+    }
+    std::vector<event> events;
+    uint64_t seed = 1;
+    for (uint64_t t = 0; t < 1000; ++t) {
+        seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+        events.push_back(event{
+            t * 20 + (seed >> 60), static_cast<uint16_t>(100 + (seed >> 40) % 40), static_cast<uint16_t>(60 + t % 30)});
+    }
+    std::array<float, 2> positions[2];
+    auto event_average_position = tarsier::make_average_position<event, std::array<float, 2>>(
+        0.0f,
+        0.0f,
+        0.99f,
+        [](event, float x, float y) -> std::array<float, 2> { return {{x, y}}; },
+        [&](std::array<float, 2> position) { positions[0] = position; });
+    auto time_average_position = tarsier::make_average_position<event, std::array<float, 2>>(
+        0.0f,
+        0.0f,
+        tarsier::time_constant{2000},
+        [](event, float x, float y) -> std::array<float, 2> { return {{x, y}}; },
+        [&](std::array<float, 2> position) { positions[1] = position; });
+    blob blobs[2];
+    auto event_track_blob = tarsier::make_track_blob<event, blob>(
+        120.0f,
+        75.0f,
+        100.0f,
+        0.0f,
+        100.0f,
+        0.99f,
+        0.999f,
+        [](event, float x, float y, float sigma_x_squared, float sigma_xy, float sigma_y_squared) -> blob {
+            return {x, y, sigma_x_squared, sigma_xy, sigma_y_squared};
+        },
+        [&](blob blob) { blobs[0] = blob; });
+    auto time_track_blob = tarsier::make_track_blob<event, blob>(
+        120.0f,
+        75.0f,
+        100.0f,
+        0.0f,
+        100.0f,
+        tarsier::time_constant{2000},
+        tarsier::time_constant{20000},
+        [](event, float x, float y, float sigma_x_squared, float sigma_xy, float sigma_y_squared) -> blob {
+            return {x, y, sigma_x_squared, sigma_xy, sigma_y_squared};
+        },
+        [&](blob blob) { blobs[1] = blob; });
+    for (auto event : events) {
+        event_average_position(event);
+        time_average_position(event);
+        event_track_blob(event);
+        time_track_blob(event);
+    }
+    const auto single_positions = std::vector<std::array<float, 2>>{positions[0], positions[1]};
+    const auto single_blobs = std::vector<blob>{blobs[0], blobs[1]};
+    auto batch_average_positions = std::make_pair(
+        tarsier::make_average_position<event, std::array<float, 2>>(
+            0.0f,
+            0.0f,
+            0.99f,
+            [](event, float x, float y) -> std::array<float, 2> { return {{x, y}}; },
+            [&](std::array<float, 2> position) { positions[0] = position; }),
+        tarsier::make_average_position<event, std::array<float, 2>>(
+            0.0f,
+            0.0f,
+            tarsier::time_constant{2000},
+            [](event, float x, float y) -> std::array<float, 2> { return {{x, y}}; },
+            [&](std::array<float, 2> position) { positions[1] = position; }));
+    auto batch_track_blobs = std::make_pair(
+        tarsier::make_track_blob<event, blob>(
+            120.0f,
+            75.0f,
+            100.0f,
+            0.0f,
+            100.0f,
+            0.99f,
+            0.999f,
+            [](event, float x, float y, float sigma_x_squared, float sigma_xy, float sigma_y_squared) -> blob {
+                return {x, y, sigma_x_squared, sigma_xy, sigma_y_squared};
+            },
+            [&](blob blob) { blobs[0] = blob; }),
+        tarsier::make_track_blob<event, blob>(
+            120.0f,
+            75.0f,
+            100.0f,
+            0.0f,
+            100.0f,
+            tarsier::time_constant{2000},
+            tarsier::time_constant{20000},
+            [](event, float x, float y, float sigma_x_squared, float sigma_xy, float sigma_y_squared) -> blob {
+                return {x, y, sigma_x_squared, sigma_xy, sigma_y_squared};
+            },
+            [&](blob blob) { blobs[1] = blob; }));
+    for (std::size_t index = 0; index < events.size(); index += 64) {
+        const auto count = std::min(static_cast<std::size_t>(64), events.size() - index);
+        batch_average_positions.first(events.data() + index, count);
+        batch_average_positions.second(events.data() + index, count);
+        batch_track_blobs.first(events.data() + index, count);
+        batch_track_blobs.second(events.data() + index, count);
+    }
+    for (std::size_t mode = 0; mode < 2; ++mode) {
+        REQUIRE(std::abs(positions[mode][0] - single_positions[mode][0]) < 1e-3f);
+        REQUIRE(std::abs(positions[mode][1] - single_positions[mode][1]) < 1e-3f);
+        REQUIRE(std::abs(blobs[mode].x - single_blobs[mode].x) < 1e-3f);
+        REQUIRE(std::abs(blobs[mode].y - single_blobs[mode].y) < 1e-3f);
+        REQUIRE(std::abs(blobs[mode].sigma_x_squared - single_blobs[mode].sigma_x_squared) < 1e-2f);
+        REQUIRE(std::abs(blobs[mode].sigma_xy - single_blobs[mode].sigma_xy) < 1e-2f);
+        REQUIRE(std::abs(blobs[mode].sigma_y_squared - single_blobs[mode].sigma_y_squared) < 1e-2f);
+    }
+    std::vector<std::array<float, 3>> emitted_positions[2];
+    for (std::size_t mode = 0; mode < 2; ++mode) {
+        auto emitting_average_position = tarsier::make_average_position<event, std::array<float, 3>>(
+            0.0f,
+            0.0f,
+            tarsier::time_constant{2000},
+            [](event event, float x, float y) -> std::array<float, 3> {
+                return {{static_cast<float>(event.t), x, y}};
+            },
+            [&](std::array<float, 3> position) { emitted_positions[mode].push_back(position); },
+            tarsier::emit_every_events(10));
+        if (mode == 0) {
+            for (auto event : events) {
+                emitting_average_position(event);
+            }
+        } else {
+            for (std::size_t index = 0; index < events.size(); index += 64) {
+                emitting_average_position(
+                    events.data() + index, std::min(static_cast<std::size_t>(64), events.size() - index));
+            }
+        }
+    }
+    REQUIRE(emitted_positions[0].size() == events.size() / 10);
+    REQUIRE(emitted_positions[1].size() == emitted_positions[0].size());
+    for (std::size_t index = 0; index < emitted_positions[0].size(); ++index) {
+        REQUIRE(emitted_positions[1][index][0] == emitted_positions[0][index][0]);
+        REQUIRE(std::abs(emitted_positions[1][index][1] - emitted_positions[0][index][1]) < 1e-3f);
+        REQUIRE(std::abs(emitted_positions[1][index][2] - emitted_positions[0][index][2]) < 1e-3f);
+    }
+    std::vector<blob> emitted_blobs[2];
+    for (std::size_t mode = 0; mode < 2; ++mode) {
+        auto emitting_track_blob = tarsier::make_track_blob<event, blob>(
+            120.0f,
+            75.0f,
+            100.0f,
+            0.0f,
+            100.0f,
+            tarsier::time_constant{2000},
+            tarsier::time_constant{20000},
+            [](event, float x, float y, float sigma_x_squared, float sigma_xy, float sigma_y_squared) -> blob {
+                return {x, y, sigma_x_squared, sigma_xy, sigma_y_squared};
+            },
+            [&](blob blob) { emitted_blobs[mode].push_back(blob); },
+            tarsier::emit_every_events(10));
+        if (mode == 0) {
+            for (auto event : events) {
+                emitting_track_blob(event);
+            }
+        } else {
+            for (std::size_t index = 0; index < events.size(); index += 64) {
+                emitting_track_blob(
+                    events.data() + index, std::min(static_cast<std::size_t>(64), events.size() - index));
+            }
+        }
+    }
+    REQUIRE(emitted_blobs[0].size() == events.size() / 10);
+    REQUIRE(emitted_blobs[1].size() == emitted_blobs[0].size());
+    for (std::size_t index = 0; index < emitted_blobs[0].size(); ++index) {
+        REQUIRE(std::abs(emitted_blobs[1][index].x - emitted_blobs[0][index].x) < 1e-3f);
+        REQUIRE(std::abs(emitted_blobs[1][index].y - emitted_blobs[0][index].y) < 1e-3f);
+        REQUIRE(std::abs(emitted_blobs[1][index].sigma_x_squared - emitted_blobs[0][index].sigma_x_squared) < 1e-2f);
+        REQUIRE(std::abs(emitted_blobs[1][index].sigma_xy - emitted_blobs[0][index].sigma_xy) < 1e-2f);
+        REQUIRE(std::abs(emitted_blobs[1][index].sigma_y_squared - emitted_blobs[0][index].sigma_y_squared) < 1e-2f);
+    }
+    std::array<float, 2> restored_positions[2];
+    auto make_restorable_average_position = [&](std::size_t mode) {
+        return tarsier::make_average_position<event, std::array<float, 2>>(
+            0.0f,
+            0.0f,
+            tarsier::time_constant{2000},
+            [](event, float x, float y) -> std::array<float, 2> { return {{x, y}}; },
+            [&restored_positions, mode](std::array<float, 2> position) { restored_positions[mode] = position; });
+    };
+    blob restored_blobs[2];
+    auto make_restorable_track_blob = [&](std::size_t mode) {
+        return tarsier::make_track_blob<event, blob>(
+            120.0f,
+            75.0f,
+            100.0f,
+            0.0f,
+            100.0f,
+            tarsier::time_constant{2000},
+            tarsier::time_constant{20000},
+            [](event, float x, float y, float sigma_x_squared, float sigma_xy, float sigma_y_squared) -> blob {
+                return {x, y, sigma_x_squared, sigma_xy, sigma_y_squared};
+            },
+            [&restored_blobs, mode](blob blob) { restored_blobs[mode] = blob; });
+    };
+    auto uninterrupted_average_position = make_restorable_average_position(0);
+    auto uninterrupted_track_blob = make_restorable_track_blob(0);
+    for (std::size_t index = 0; index < events.size() / 2; ++index) {
+        uninterrupted_average_position(events[index]);
+        uninterrupted_track_blob(events[index]);
+    }
+    std::stringstream position_stream;
+    uninterrupted_average_position.save_state(position_stream);
+    std::stringstream blob_stream;
+    uninterrupted_track_blob.save_state(blob_stream);
+    auto restored_average_position = make_restorable_average_position(1);
+    restored_average_position.load_state(position_stream);
+    auto restored_track_blob = make_restorable_track_blob(1);
+    restored_track_blob.load_state(blob_stream);
+    for (std::size_t index = events.size() / 2; index < events.size(); ++index) {
+        uninterrupted_average_position(events[index]);
+        restored_average_position(events[index]);
+        uninterrupted_track_blob(events[index]);
+        restored_track_blob(events[index]);
+        REQUIRE(restored_positions[1] == restored_positions[0]);
+        REQUIRE(restored_blobs[1].x == restored_blobs[0].x);
+        REQUIRE(restored_blobs[1].sigma_xy == restored_blobs[0].sigma_xy);
+    }
+    std::stringstream event_inertia_stream;
+    event_average_position.save_state(event_inertia_stream);
+    REQUIRE_THROWS(restored_average_position.load_state(event_inertia_stream));
+}
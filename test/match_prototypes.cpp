@@ -0,0 +1,135 @@
+#include "../source/match_prototypes.hpp"
+#include "../third_party/Catch2/single_include/catch.hpp"
+#include <random>
+
+const std::size_t dimension = 9;
+
+struct time_surface {
+    uint64_t t;
+    std::array<float, dimension> projections;
+} __attribute__((packed));
+
+struct feature {
+    uint64_t t;
+    std::size_t index;
+} __attribute__((packed));
+
+TEST_CASE("Match time surfaces with prototypes", "[match_prototypes]") {
+    std::vector<std::array<float, dimension>> prototypes(10);
+    for (std::size_t index = 0; index < prototypes.size(); ++index) {
+        prototypes[index].fill(0.1f * index);
+    }
+    std::vector<std::size_t> expected_indices{0, 9, 3};
+    std::size_t count = 0;
+    auto match_prototypes = tarsier::make_match_prototypes<time_surface, feature, dimension>(
+        prototypes,
+        0.5f,
+        [](time_surface time_surface, std::size_t index, float) -> feature {
+            return {time_surface.t, index};
+        },
+        [&](feature feature) -> void {
+            REQUIRE(feature.index == expected_indices[count]);
+            ++count;
+        });
+    time_surface first_time_surface{0, {}};
+    first_time_surface.projections.fill(0.01f);
+    match_prototypes(first_time_surface);
+    time_surface second_time_surface{1, {}};
+    second_time_surface.projections.fill(1.0f);
+    match_prototypes(second_time_surface);
+    time_surface third_time_surface{2, {}};
+    third_time_surface.projections.fill(0.32f);
+    match_prototypes(third_time_surface);
+    REQUIRE(count == expected_indices.size());
+    std::vector<time_surface> batch(5, third_time_surface);
+    batch[4].projections.fill(0.0f);
+    match_prototypes.train(batch.begin(), batch.end());
+    REQUIRE(std::abs(match_prototypes.prototype(0)[0] - 0.0025f) < 1e-6f);
+    REQUIRE(std::abs(match_prototypes.prototype(3)[0] - 0.315f) < 1e-6f);
+    REQUIRE(std::abs(match_prototypes.prototype(9)[0] - 0.95f) < 1e-6f);
+
+    // the distances (AVX or scalar, depending on the build) match a straightforward computation
+    std::mt19937 engine(42);
+    std::uniform_real_distribution<float> distribution(0.0f, 1.0f);
+    std::vector<std::array<float, dimension>> random_prototypes(37);
+    for (auto& prototype : random_prototypes) {
+        for (auto& coordinate : prototype) {
+            coordinate = distribution(engine);
+        }
+    }
+    std::vector<time_surface> time_surfaces(11);
+    for (std::size_t index = 0; index < time_surfaces.size(); ++index) {
+        std::array<float, dimension> projections;
+        for (auto& coordinate : projections) {
+            coordinate = distribution(engine);
+        }
+        time_surfaces[index] = time_surface{index, projections};
+    }
+    std::vector<std::size_t> closest_indices;
+    std::vector<float> closest_distances;
+    for (const auto& time_surface : time_surfaces) {
+        std::size_t closest_index = 0;
+        auto closest_distance = std::numeric_limits<float>::infinity();
+        for (std::size_t index = 0; index < random_prototypes.size(); ++index) {
+            auto distance = 0.0f;
+            for (std::size_t coordinate = 0; coordinate < dimension; ++coordinate) {
+                const auto delta = random_prototypes[index][coordinate] - time_surface.projections[coordinate];
+                distance += delta * delta;
+            }
+            if (distance < closest_distance) {
+                closest_distance = distance;
+                closest_index = index;
+            }
+        }
+        closest_indices.push_back(closest_index);
+        closest_distances.push_back(closest_distance);
+    }
+    std::size_t random_count = 0;
+    auto random_match_prototypes = tarsier::make_match_prototypes<time_surface, feature, dimension>(
+        random_prototypes,
+        0.0f,
+        [&](time_surface time_surface, std::size_t index, float distance) -> feature {
+            REQUIRE(std::abs(distance - closest_distances[time_surface.t]) < 1e-5f);
+            return {time_surface.t, index};
+        },
+        [&](feature feature) -> void {
+            REQUIRE(feature.index == closest_indices[feature.t]);
+            ++random_count;
+        });
+    for (const auto& time_surface : time_surfaces) {
+        random_match_prototypes(time_surface);
+    }
+    REQUIRE(random_count == time_surfaces.size());
+
+    // with a learning rate of one, training (two tiles and a remainder) moves the winners to their members' mean
+    auto training_match_prototypes = tarsier::make_match_prototypes<time_surface, feature, dimension>(
+        random_prototypes,
+        1.0f,
+        [](time_surface time_surface, std::size_t index, float) -> feature {
+            return {time_surface.t, index};
+        },
+        [](feature) -> void {});
+    training_match_prototypes.train(time_surfaces.begin(), time_surfaces.end());
+    for (std::size_t index = 0; index < random_prototypes.size(); ++index) {
+        auto expected_prototype = random_prototypes[index];
+        std::size_t members = 0;
+        std::array<float, dimension> sums{};
+        for (std::size_t surface = 0; surface < time_surfaces.size(); ++surface) {
+            if (closest_indices[surface] == index) {
+                ++members;
+                for (std::size_t coordinate = 0; coordinate < dimension; ++coordinate) {
+                    sums[coordinate] += time_surfaces[surface].projections[coordinate];
+                }
+            }
+        }
+        if (members > 0) {
+            for (std::size_t coordinate = 0; coordinate < dimension; ++coordinate) {
+                expected_prototype[coordinate] = sums[coordinate] / static_cast<float>(members);
+            }
+        }
+        const auto prototype = training_match_prototypes.prototype(index);
+        for (std::size_t coordinate = 0; coordinate < dimension; ++coordinate) {
+            REQUIRE(std::abs(prototype[coordinate] - expected_prototype[coordinate]) < 1e-5f);
+        }
+    }
+}
@@ -0,0 +1,97 @@
+#include "../source/match_stereo.hpp"
+#include "../third_party/Catch2/single_include/catch.hpp"
+
+struct event {
+    uint64_t t;
+    uint16_t x;
+    uint16_t y;
+    bool polarity;
+} __attribute__((packed));
+
+struct depth_event {
+    uint64_t t;
+    uint16_t x;
+    uint16_t y;
+    uint16_t disparity;
+} __attribute__((packed));
+
+TEST_CASE("Match events from two cameras", "[match_stereo]") {
+    for (auto patch_weight : {0.0f, 1.0f}) {
+        std::size_t count = 0;
+        std::size_t correct_count = 0;
+        auto match_stereo = tarsier::make_match_stereo<event, depth_event>(
+            64,
+            16,
+            32,
+            0,
+            20,
+            1000,
+            2,
+            patch_weight,
+            500.0f,
+            [](event left_event, event right_event) -> depth_event {
+                return {std::max(left_event.t, right_event.t),
+                        left_event.x,
+                        left_event.y,
+                        static_cast<uint16_t>(left_event.x - right_event.x)};
+            },
+            [&](depth_event depth_event) -> void {
+                ++count;
+                if (depth_event.disparity == 7) {
+                    ++correct_count;
+                }
+            });
+        for (uint16_t x = 10; x < 60; ++x) {
+            for (uint16_t y = 0; y < 16; ++y) {
+                const uint64_t t = 1000 + x * 200 + y;
+                match_stereo.left(event{t, x, y, x % 2 == 0});
+                match_stereo.right(event{t + 20, static_cast<uint16_t>(x - 7), y, x % 2 == 0});
+            }
+        }
+        match_stereo.flush();
+        REQUIRE(count == 50 * 16);
+        REQUIRE(correct_count == count);
+    }
+    std::vector<depth_event> depth_events;
+    auto later_partner_match_stereo = tarsier::make_match_stereo<event, depth_event>(
+        64,
+        16,
+        32,
+        0,
+        20,
+        1000,
+        0,
+        0.0f,
+        0.0f,
+        [](event left_event, event right_event) -> depth_event {
+            return {right_event.t, left_event.x, left_event.y, static_cast<uint16_t>(left_event.x - right_event.x)};
+        },
+        [&](depth_event depth_event) -> void { depth_events.push_back(depth_event); });
+    later_partner_match_stereo.right(event{100, 25, 3, true});
+    later_partner_match_stereo.left(event{1000, 30, 3, true});
+    later_partner_match_stereo.right(event{1010, 25, 3, true});
+    later_partner_match_stereo.left(event{5000, 0, 0, false});
+    later_partner_match_stereo.right(event{5000, 0, 0, false});
+    REQUIRE(depth_events.size() == 1);
+    REQUIRE(depth_events[0].t == 1010);
+    REQUIRE(depth_events[0].x == 30);
+    REQUIRE(depth_events[0].disparity == 5);
+    later_partner_match_stereo.flush();
+    REQUIRE(depth_events.size() == 2);
+    REQUIRE_THROWS_AS(
+        (tarsier::make_match_stereo<event, depth_event>(
+            64,
+            16,
+            32,
+            10,
+            5,
+            1000,
+            0,
+            0.0f,
+            0.0f,
+            [](event left_event, event) -> depth_event {
+                return {left_event.t, left_event.x, left_event.y, 0};
+            },
+            [](depth_event) -> void {})),
+        std::logic_error);
+}
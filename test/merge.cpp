@@ -0,0 +1,31 @@
+#include "../source/merge.hpp"
+#include "../third_party/Catch2/single_include/catch.hpp"
+
+struct event {
+    uint64_t t;
+    uint16_t x;
+    uint16_t y;
+} __attribute__((packed));
+
+TEST_CASE("Merge event streams into a time-ordered stream", "[merge]") {
+    std::vector<uint64_t> expected_ts{0, 10, 20, 30, 40, 50, 60};
+    std::vector<uint16_t> expected_xs{0, 320, 1, 321, 322, 2, 323};
+    std::size_t index = 0;
+    auto merge = tarsier::make_merge<event>({{0, 0}, {320, 0}}, 25, [&](event event) -> void {
+        REQUIRE(event.t == expected_ts[index]);
+        REQUIRE(event.x == expected_xs[index]);
+        ++index;
+    });
+    merge(0, event{0, 0, 0});
+    merge(0, event{20, 1, 0});
+    merge(1, event{10, 0, 0});
+    merge(1, event{30, 1, 0});
+    merge(0, event{50, 2, 0});
+    merge(1, event{40, 2, 0});
+    merge(1, event{15, 3, 0});
+    merge(1, event{60, 3, 0});
+    REQUIRE(index == 4);
+    merge.flush();
+    REQUIRE(index == expected_ts.size());
+    REQUIRE(merge.late_events() == 1);
+}
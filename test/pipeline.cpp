@@ -0,0 +1,70 @@
+#include "../source/pipeline.hpp"
+#include "../third_party/Catch2/single_include/catch.hpp"
+
+struct event {
+    uint64_t t;
+    uint16_t x;
+    uint16_t y;
+} __attribute__((packed));
+
+TEST_CASE("Build a pipeline from a JSON description", "[pipeline]") {
+    const std::string description = R"({
+        "stages": [
+            {"type": "select_rectangle", "left": 10, "bottom": 0, "width": 20, "height": 240},
+            {"type": "mirror_x", "width": 320},
+            {"type": "shift_y", "height": 240, "shift": -5},
+            {"type": "scale_t", "factor": 2}
+        ]
+    })";
+    tarsier::pipeline_stages<event> stages = tarsier::default_pipeline_stages<event>();
+    stages["scale_t"] = [](const tarsier::json_value& parameters, tarsier::erased_handler<event> next) {
+        const auto factor = parameters.at("factor").as_integer<uint64_t>();
+        return tarsier::make_pipeline_stage<event>(
+            [=](tarsier::pipeline_sink<event> sink) {
+                return [=](event event) mutable {
+                    event.t *= factor;
+                    sink(event);
+                };
+            },
+            std::move(next));
+    };
+    std::vector<uint64_t> ts;
+    std::vector<uint16_t> xs;
+    std::vector<uint16_t> ys;
+    auto pipeline = tarsier::make_pipeline<event>(description, stages, [&](event event) {
+        ts.push_back(event.t);
+        xs.push_back(event.x);
+        ys.push_back(event.y);
+    });
+    std::vector<event> events;
+    for (uint16_t x = 0; x < 40; ++x) {
+        events.push_back(event{x, x, static_cast<uint16_t>(x + 1)});
+    }
+    pipeline(events[12]);
+    pipeline(events.data(), events.size());
+    REQUIRE(ts.size() == 21);
+    REQUIRE(ts[0] == 24);
+    REQUIRE(xs[0] == 307);
+    REQUIRE(ys[0] == 8);
+    REQUIRE(ts[1] == 20);
+    REQUIRE(xs[20] == 290);
+    REQUIRE(ys[20] == 25);
+    REQUIRE_THROWS_AS(
+        tarsier::make_pipeline<event>(R"({"stages": [{"type": "mirror_z"}]})", [](event) {}), std::runtime_error);
+    REQUIRE_THROWS_AS(
+        tarsier::make_pipeline<event>(R"({"stages": [{"type": "mirror_x", "width": -1}]})", [](event) {}),
+        std::runtime_error);
+    REQUIRE_THROWS_AS(tarsier::make_pipeline<event>(R"({"stages": [}")", [](event) {}), std::runtime_error);
+    REQUIRE(tarsier::parse_json("18446744073709549568").as_integer<uint64_t>() == 18446744073709549568ull);
+    REQUIRE_THROWS_AS(tarsier::parse_json("18446744073709551616").as_integer<uint64_t>(), std::runtime_error);
+    REQUIRE(
+        tarsier::parse_json("-9223372036854775808").as_integer<int64_t>() == std::numeric_limits<int64_t>::lowest());
+    REQUIRE_THROWS_AS(tarsier::parse_json("9223372036854775808").as_integer<int64_t>(), std::runtime_error);
+    REQUIRE_THROWS_AS(tarsier::parse_json("65536").as_integer<uint16_t>(), std::runtime_error);
+    const auto value = tarsier::parse_json(R"([true, null, "aé\n", 1.5e2, {}])");
+    REQUIRE(value.as_array()[0].as_boolean());
+    REQUIRE(value.as_array()[1].get_type() == tarsier::json_value::type::null);
+    REQUIRE(value.as_array()[2].as_string() == "a\xc3\xa9\n");
+    REQUIRE(value.as_array()[3].as_number() == 150.0);
+    REQUIRE(value.as_array()[4].as_object().empty());
+}
@@ -0,0 +1,61 @@
+#include "../source/compute_flow.hpp"
+#include "../source/replay.hpp"
+#include "../third_party/Catch2/single_include/catch.hpp"
+
+struct event {
+    uint64_t t;
+    uint16_t x;
+    uint16_t y;
+} __attribute__((packed));
+
+struct flow {
+    uint64_t t;
+    uint16_t x;
+    uint16_t y;
+    float vx;
+    float vy;
+} __attribute__((packed));
+
+TEST_CASE("Replay a recording in parallel chunks", "[replay]") {
+    std::vector<event> events;
+    for (uint64_t t = 0; t < 200000; t += 100) {
+        const auto column = static_cast<uint16_t>(t / 2000);
+        events.push_back(event{t, column, static_cast<uint16_t>((t / 100) % 20)});
+    }
+    const auto make_handler = [](tarsier::replay_sink<flow> sink) {
+        return tarsier::make_compute_flow<event, flow>(
+            100,
+            20,
+            2,
+            10000,
+            8,
+            [](event event, float vx, float vy) -> flow {
+                return {event.t, event.x, event.y, vx, vy};
+            },
+            std::move(sink));
+    };
+    std::vector<flow> serial_flows;
+    {
+        tarsier::replay_chunk<flow> chunk{{}, false, false};
+        auto compute_flow = make_handler(tarsier::replay_sink<flow>(chunk));
+        for (auto event : events) {
+            compute_flow(event);
+        }
+        serial_flows.swap(chunk.outputs);
+    }
+    REQUIRE(serial_flows.size() > 1000);
+    std::vector<flow> parallel_flows;
+    tarsier::replay<flow>(
+        events.begin(), events.end(), 7000, 10000, 3, make_handler, [&](flow flow) -> void {
+            parallel_flows.push_back(flow);
+        });
+    REQUIRE(parallel_flows.size() == serial_flows.size());
+    auto identical = true;
+    for (std::size_t index = 0; index < serial_flows.size(); ++index) {
+        identical &= parallel_flows[index].t == serial_flows[index].t
+                     && parallel_flows[index].x == serial_flows[index].x
+                     && parallel_flows[index].vx == serial_flows[index].vx
+                     && parallel_flows[index].vy == serial_flows[index].vy;
+    }
+    REQUIRE(identical);
+}
@@ -0,0 +1,158 @@
+#include "../source/simulate_events.hpp"
+#include "../source/stitch.hpp"
+#include "../third_party/Catch2/single_include/catch.hpp"
+#include <sstream>
+
+struct change_event {
+    uint64_t t;
+    uint16_t x;
+    uint16_t y;
+    bool is_increase;
+} __attribute__((packed));
+
+struct threshold_crossing {
+    uint64_t t;
+    uint16_t x;
+    uint16_t y;
+    bool is_second;
+} __attribute__((packed));
+
+struct exposure {
+    uint64_t delta_t;
+} __attribute__((packed));
+
+bool operator==(change_event first, change_event second) {
+    return first.t == second.t && first.x == second.x && first.y == second.y
+           && first.is_increase == second.is_increase;
+}
+
+struct batch_handler {
+    std::vector<change_event>& events;
+    std::size_t& number_of_batches;
+
+    void operator()(const change_event* batch, std::size_t count) {
+        events.insert(events.end(), batch, batch + count);
+        ++number_of_batches;
+    }
+};
+
+TEST_CASE("Simulate events from frames", "[simulate_events]") {
+    std::vector<std::vector<change_event>> events(3);
+    std::vector<uint64_t> exposures;
+    std::size_t number_of_threshold_crossings = 0;
+    auto stitch = tarsier::make_stitch<threshold_crossing, exposure>(
+        64,
+        48,
+        [](threshold_crossing, uint64_t delta_t) -> exposure { return {delta_t}; },
+        [&](exposure exposure) -> void { exposures.push_back(exposure.delta_t); });
+    auto simulate_events = tarsier::make_simulate_events<change_event, threshold_crossing>(
+        64,
+        48,
+        0.2f,
+        0.03f,
+        1.0f,
+        500,
+        100,
+        1,
+        42,
+        [&](change_event event) -> void { events[0].push_back(event); },
+        [&](threshold_crossing threshold_crossing) -> void {
+            ++number_of_threshold_crossings;
+            stitch(threshold_crossing);
+        });
+    auto parallel_simulate_events = tarsier::make_simulate_events<change_event, threshold_crossing>(
+        64,
+        48,
+        0.2f,
+        0.03f,
+        1.0f,
+        500,
+        0,
+        3,
+        42,
+        [&](change_event event) -> void { events[1].push_back(event); },
+        [](threshold_crossing) -> void {});
+    std::size_t number_of_batches = 0;
+    std::size_t number_of_batch_threshold_crossings = 0;
+    auto batch_simulate_events = tarsier::make_simulate_events<change_event, threshold_crossing>(
+        64,
+        48,
+        0.2f,
+        0.03f,
+        1.0f,
+        500,
+        100,
+        2,
+        42,
+        batch_handler{events[2], number_of_batches},
+        [&](threshold_crossing) -> void { ++number_of_batch_threshold_crossings; });
+    std::vector<uint8_t> frame;
+    for (uint64_t t = 0; t <= 100000; t += 1000) {
+        tarsier::render_grating(frame, 64, 48, t, 16.0f, 40.0f, 0.5f);
+        simulate_events(t, frame.data());
+        parallel_simulate_events(t, frame.data());
+        batch_simulate_events(t, frame.data());
+    }
+    simulate_events.flush();
+    batch_simulate_events.flush();
+    REQUIRE(events[0].size() > 10000);
+    REQUIRE(events[0] == events[1]);
+    REQUIRE(events[0] == events[2]);
+    REQUIRE(number_of_batches < events[2].size());
+    std::vector<uint64_t> next_ts(64 * 48, 0);
+    auto ordered = true;
+    auto refractory = true;
+    for (std::size_t index = 0; index < events[0].size(); ++index) {
+        const auto event = events[0][index];
+        ordered = ordered && (index == 0 || events[0][index - 1].t <= event.t);
+        refractory = refractory && event.t >= next_ts[event.x + event.y * 64];
+        next_ts[event.x + event.y * 64] = event.t + 500;
+    }
+    REQUIRE(ordered);
+    REQUIRE(refractory);
+    REQUIRE(number_of_threshold_crossings == exposures.size() * 2);
+    REQUIRE(number_of_batch_threshold_crossings == number_of_threshold_crossings);
+    REQUIRE(!exposures.empty());
+    REQUIRE(*std::min_element(exposures.begin(), exposures.end()) >= 100);
+
+    // the noise rate (50 Hz) exceeds one event per frame, and the events are spread uniformly within frames
+    std::size_t number_of_noise_events = 0;
+    std::size_t number_of_early_noise_events = 0;
+    auto noise_simulate_events = tarsier::make_simulate_events<change_event, threshold_crossing>(
+        100,
+        100,
+        0.2f,
+        0.0f,
+        50.0f,
+        0,
+        0,
+        2,
+        7,
+        [&](change_event event) -> void {
+            ++number_of_noise_events;
+            if ((event.t - 1) % 100000 < 50000) {
+                ++number_of_early_noise_events;
+            }
+        },
+        [](threshold_crossing) -> void {});
+    std::stringstream stream(std::string(100 * 100 * 11, '\x80'));
+    tarsier::simulate_raw_frames(stream, 100000, noise_simulate_events);
+    REQUIRE(std::abs(static_cast<float>(number_of_noise_events) - 100 * 100 * 50.0f) < 100 * 100 * 50.0f * 0.02f);
+    REQUIRE(
+        std::abs(static_cast<float>(number_of_early_noise_events) / static_cast<float>(number_of_noise_events) - 0.5f)
+        < 0.01f);
+    REQUIRE_THROWS_AS(
+        (tarsier::make_simulate_events<change_event, threshold_crossing>(
+            100,
+            100,
+            0.2f,
+            0.0f,
+            -1.0f,
+            0,
+            0,
+            1,
+            7,
+            [](change_event) -> void {},
+            [](threshold_crossing) -> void {})),
+        std::logic_error);
+}
@@ -0,0 +1,65 @@
+#include "../source/compute_time_surface.hpp"
+#include "../source/snapshot.hpp"
+#include "../source/track_blob.hpp"
+#include "../third_party/Catch2/single_include/catch.hpp"
+#include <thread>
+
+struct event {
+    uint64_t t;
+    uint16_t x;
+    uint16_t y;
+    bool polarity;
+} __attribute__((packed));
+
+TEST_CASE("Read consistent snapshots from another thread", "[snapshot]") {
+    tarsier::snapshot<std::array<float, 5>> blob_snapshot;
+    auto track_blob = tarsier::make_track_blob<event, int>(
+        0.0f,
+        0.0f,
+        0.0f,
+        0.0f,
+        0.0f,
+        0.0f,
+        0.0f,
+        [](event, float, float, float, float, float) -> int { return 0; },
+        [](int) -> void {});
+    track_blob.publish_to(blob_snapshot);
+    std::atomic<bool> running(true);
+    std::atomic<std::size_t> inconsistent(0);
+    std::atomic<std::size_t> loads(0);
+    std::thread reader([&]() {
+        while (running.load()) {
+            const auto& blob = blob_snapshot.load();
+            if (blob[0] != blob[1]) {
+                ++inconsistent;
+            }
+            ++loads;
+        }
+    });
+    for (uint16_t index = 0; index < 50000; ++index) {
+        track_blob(event{index, index, index, true});
+    }
+    while (loads.load() == 0) {
+        std::this_thread::yield();
+    }
+    running.store(false);
+    reader.join();
+    REQUIRE(loads > 0);
+    REQUIRE(inconsistent == 0);
+    REQUIRE(blob_snapshot.load()[0] == 49999.0f);
+
+    tarsier::snapshot<std::vector<std::pair<uint64_t, bool>>> ts_and_polarities_snapshot;
+    auto compute_time_surface = tarsier::make_compute_time_surface<event, bool, int, 1>(
+        4, 3, 1000, 100.0f, [](event, std::array<std::pair<float, bool>, 9>) -> int { return 0; }, [](int) -> void {});
+    compute_time_surface.publish_to(ts_and_polarities_snapshot, 100);
+    compute_time_surface(event{10, 1, 1, true});
+    compute_time_surface(event{20, 2, 1, false});
+    REQUIRE(ts_and_polarities_snapshot.load().size() == 12);
+    REQUIRE(ts_and_polarities_snapshot.load()[5].first == 10);
+    REQUIRE(ts_and_polarities_snapshot.load()[6].first == 0);
+    compute_time_surface(event{110, 3, 2, true});
+    const auto& ts_and_polarities = ts_and_polarities_snapshot.load();
+    REQUIRE(ts_and_polarities[6].first == 20);
+    REQUIRE(!ts_and_polarities[6].second);
+    REQUIRE(ts_and_polarities[11].first == 110);
+}
@@ -0,0 +1,82 @@
+#include "../source/compute_flow.hpp"
+#include "../source/mask_isolated.hpp"
+#include "../source/sparse_active_events.hpp"
+#include "../source/update_active_events.hpp"
+#include "../third_party/Catch2/single_include/catch.hpp"
+#include <sstream>
+
+struct event {
+    uint64_t t;
+    uint16_t x;
+    uint16_t y;
+    bool polarity;
+} __attribute__((packed));
+
+struct flow {
+    uint64_t t;
+    float vx;
+    float vy;
+} __attribute__((packed));
+
+TEST_CASE("Store active events in hashed blocks", "[sparse_active_events]") {
+    tarsier::sparse_active_events<bool> active_events(65535, 65535, 1000000, 2);
+    std::size_t masked_count = 0;
+    std::size_t flows_count = 0;
+    auto mask_isolated =
+        tarsier::make_mask_isolated<event>(active_events, 10000, [&](event) -> void { ++masked_count; });
+    auto compute_flow = tarsier::make_compute_flow<event, flow>(
+        active_events,
+        2,
+        1000000,
+        10,
+        [](event event, float vx, float vy) -> flow {
+            return {event.t, vx, vy};
+        },
+        [&](flow flow) -> void {
+            ++flows_count;
+            REQUIRE(flow.t == 2010000);
+            REQUIRE(std::abs(flow.vx - 0.0000904721018f) / 0.0000904721018f < 1e-3f);
+            REQUIRE(std::abs(flow.vy - 0.000232017177f) / 0.000232017177f < 1e-3f);
+        });
+    auto update_active_events = tarsier::make_update_active_events<event>(active_events, [&](event event) -> void {
+        mask_isolated(event);
+        compute_flow(event);
+    });
+    update_active_events(event{2000000, 50004 - 2, 50004 - 2, true});
+    update_active_events(event{2001000, 50004 - 1, 50004 - 2, false});
+    update_active_events(event{2002000, 50004 - 0, 50004 - 2, true});
+    update_active_events(event{2003000, 50004 - 2, 50004 - 1, false});
+    update_active_events(event{2004000, 50004 + 1, 50004 - 2, true});
+    update_active_events(event{2005000, 50004 - 1, 50004 - 1, false});
+    update_active_events(event{2006000, 50004 - 0, 50004 - 1, true});
+    update_active_events(event{2007000, 50004 - 2, 50004 - 0, false});
+    update_active_events(event{2008000, 50004 + 1, 50004 - 1, true});
+    update_active_events(event{2010000, 50004, 50004, false});
+    REQUIRE(masked_count == 9);
+    REQUIRE(flows_count == 1);
+    REQUIRE(active_events.number_of_blocks() == 1);
+    REQUIRE(active_events.t(50004, 50004) == 2010000);
+    REQUIRE(!active_events.polarity(50004, 50004));
+    REQUIRE(active_events.t(10, 10) == 0);
+
+    std::stringstream stream;
+    mask_isolated.save_state(stream);
+
+    active_events.update(event{2020000, 10, 10, true});
+    REQUIRE(active_events.number_of_blocks() == 2);
+    active_events.update(event{2030000, 20, 20, true});
+    REQUIRE(active_events.evictions() == 1);
+    REQUIRE(active_events.t(50004, 50004) == 0);
+    REQUIRE(active_events.t(10, 10) == 2020000);
+    REQUIRE(active_events.t(20, 20) == 2030000);
+    active_events.update(event{4000000, 30, 30, true});
+    REQUIRE(active_events.evictions() == 1);
+    REQUIRE(active_events.number_of_blocks() == 2);
+    REQUIRE(active_events.t(10, 10) == 0);
+    REQUIRE(active_events.t(20, 20) == 2030000);
+
+    mask_isolated.load_state(stream);
+    REQUIRE(active_events.t(50004, 50004) == 2010000);
+    REQUIRE(active_events.t(50003, 50002) == 2001000);
+    REQUIRE(active_events.t(20, 20) == 0);
+}
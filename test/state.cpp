@@ -0,0 +1,137 @@
+#include "../source/compute_activity.hpp"
+#include "../source/track_blob.hpp"
+#include "../third_party/Catch2/single_include/catch.hpp"
+#include <sstream>
+
+struct event {
+    uint64_t t;
+    uint16_t x;
+    uint16_t y;
+} __attribute__((packed));
+
+struct activity {
+    uint64_t t;
+    uint16_t x;
+    uint16_t y;
+    float potential;
+};
+
+struct blob {
+    float x;
+    float y;
+};
+
+TEST_CASE("Save and load handlers states", "[state]") {
+    std::vector<float> potentials;
+    auto event_to_activity = [](event event, float potential) -> activity {
+        return {event.t, event.x, event.y, potential};
+    };
+    auto handle_activity = [&](activity activity) -> void { potentials.push_back(activity.potential); };
+    auto compute_activity =
+        tarsier::make_compute_activity<event, activity>(320, 240, 10000, event_to_activity, handle_activity);
+    compute_activity(event{100000, 100, 100});
+    compute_activity(event{100001, 100, 100});
+    std::stringstream stream;
+    compute_activity.save_state(stream);
+    REQUIRE(stream.str().size() % 64 == 0);
+    auto restored_compute_activity =
+        tarsier::make_compute_activity<event, activity>(320, 240, 10000, event_to_activity, handle_activity);
+    restored_compute_activity.load_state(stream);
+    compute_activity(event{100002, 100, 100});
+    restored_compute_activity(event{100002, 100, 100});
+    REQUIRE(potentials.size() == 4);
+    REQUIRE(potentials[2] == potentials[3]);
+    auto track_blob = tarsier::make_track_blob<event, blob>(
+        0.0f,
+        0.0f,
+        10.0f,
+        10.0f,
+        0.0f,
+        0.9f,
+        0.9f,
+        [](event, float x, float y, float, float, float) -> blob {
+            return {x, y};
+        },
+        [](blob) -> void {});
+    track_blob(event{0, 100, 50});
+    std::stringstream blob_stream;
+    track_blob.save_state(blob_stream);
+    auto restored_track_blob = tarsier::make_track_blob<event, blob>(
+        0.0f,
+        0.0f,
+        10.0f,
+        10.0f,
+        0.0f,
+        0.9f,
+        0.9f,
+        [](event, float x, float y, float, float, float) -> blob {
+            return {x, y};
+        },
+        [](blob) -> void {});
+    restored_track_blob.load_state(blob_stream);
+    REQUIRE(restored_track_blob.x() == track_blob.x());
+    REQUIRE(restored_track_blob.sigma_xy() == track_blob.sigma_xy());
+    std::stringstream wrong_stream;
+    track_blob.save_state(wrong_stream);
+    REQUIRE_THROWS(compute_activity.load_state(wrong_stream));
+
+    std::stringstream activity_stream;
+    compute_activity.save_state(activity_stream);
+    const auto activity_state = activity_stream.str();
+    std::stringstream truncated_activity_stream(activity_state.substr(0, activity_state.size() - 64));
+    auto untouched_compute_activity =
+        tarsier::make_compute_activity<event, activity>(320, 240, 10000, event_to_activity, handle_activity);
+    auto failed_compute_activity =
+        tarsier::make_compute_activity<event, activity>(320, 240, 10000, event_to_activity, handle_activity);
+    REQUIRE_THROWS_AS(failed_compute_activity.load_state(truncated_activity_stream), std::runtime_error);
+    untouched_compute_activity(event{100003, 100, 100});
+    failed_compute_activity(event{100003, 100, 100});
+    REQUIRE(potentials.back() == potentials[potentials.size() - 2]);
+    REQUIRE(potentials.back() == 1.0f);
+
+    blob blobs[2];
+    auto make_time_track_blob = [&](std::size_t index) {
+        return tarsier::make_track_blob<event, blob>(
+            0.0f,
+            0.0f,
+            10.0f,
+            10.0f,
+            0.0f,
+            tarsier::time_constant{1000},
+            tarsier::time_constant{1000},
+            [](event, float x, float y, float, float, float) -> blob {
+                return {x, y};
+            },
+            [&blobs, index](blob blob) -> void { blobs[index] = blob; });
+    };
+    auto saved_track_blob = make_time_track_blob(0);
+    saved_track_blob(event{5000, 100, 50});
+    std::stringstream time_blob_stream;
+    saved_track_blob.save_state(time_blob_stream);
+    const auto blob_state = time_blob_stream.str();
+    std::stringstream truncated_blob_stream(blob_state.substr(0, blob_state.size() - 64));
+    auto untouched_track_blob = make_time_track_blob(0);
+    auto failed_track_blob = make_time_track_blob(1);
+    untouched_track_blob(event{100, 10, 10});
+    failed_track_blob(event{100, 10, 10});
+    REQUIRE_THROWS_AS(failed_track_blob.load_state(truncated_blob_stream), std::runtime_error);
+    REQUIRE(failed_track_blob.x() == untouched_track_blob.x());
+    untouched_track_blob(event{1100, 20, 10});
+    failed_track_blob(event{1100, 20, 10});
+    REQUIRE(blobs[1].x == blobs[0].x);
+    REQUIRE(blobs[1].y == blobs[0].y);
+
+    alignas(64) char mapped_state[512];
+    REQUIRE(blob_state.size() <= sizeof(mapped_state));
+    std::copy(blob_state.begin(), blob_state.end(), mapped_state);
+    tarsier::state_view view(mapped_state, blob_state.size(), "track_blob");
+    const auto values = view.section<float>(5);
+    REQUIRE(values[0] == saved_track_blob.x());
+    REQUIRE(values[3] == saved_track_blob.sigma_xy());
+    REQUIRE(*view.section<uint64_t>(1) == 5000);
+    REQUIRE(*view.section<uint64_t>(1) == 5000);
+    REQUIRE_THROWS_AS(view.section<uint64_t>(1), std::runtime_error);
+    REQUIRE_THROWS_AS(
+        tarsier::state_view(mapped_state, blob_state.size(), "compute_activity"), std::runtime_error);
+    REQUIRE_THROWS_AS(tarsier::state_view(mapped_state + 1, 64, "track_blob"), std::logic_error);
+}
@@ -0,0 +1,72 @@
+#include "../source/track_lines.hpp"
+#include "../third_party/Catch2/single_include/catch.hpp"
+
+struct event {
+    uint64_t t;
+    uint16_t x;
+    uint16_t y;
+} __attribute__((packed));
+
+TEST_CASE("Track lines in a decayed Hough accumulator", "[track_lines]") {
+    std::vector<tarsier::hough_line> lines;
+    auto track_lines = tarsier::make_track_lines<event, tarsier::hough_line>(
+        320,
+        240,
+        180,
+        10000,
+        20.0f,
+        3,
+        4,
+        1000,
+        [](event, const tarsier::hough_line& line) -> tarsier::hough_line { return line; },
+        [&](tarsier::hough_line line) { lines.push_back(line); });
+    uint64_t seed = 1;
+    for (uint64_t t = 10; t < 100000; t += 10) {
+        seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+        const auto position = static_cast<uint16_t>((seed >> 33) % 200);
+        if (t < 60000) {
+            track_lines(event{t, 100, static_cast<uint16_t>(20 + position)});
+        } else {
+            track_lines(event{t, static_cast<uint16_t>(60 + position), 50});
+        }
+        track_lines(event{t + 5, static_cast<uint16_t>((seed >> 17) % 320), static_cast<uint16_t>((seed >> 45) % 240)});
+    }
+    REQUIRE(!lines.empty());
+    std::vector<std::size_t> counts;
+    std::vector<uint64_t> previous_ts;
+    for (const auto& line : lines) {
+        if (line.id >= counts.size()) {
+            counts.resize(line.id + 1, 0);
+            previous_ts.resize(line.id + 1, 0);
+        } else {
+            REQUIRE(line.t - previous_ts[line.id] >= 1000);
+        }
+        ++counts[line.id];
+        previous_ts[line.id] = line.t;
+        REQUIRE(line.votes >= 20.0f);
+        if (line.id == 0) {
+            REQUIRE(std::abs(line.angle) < 0.02f);
+            REQUIRE(std::abs(line.rho - 100.0f) <= 1.0f);
+        } else {
+            REQUIRE(line.t > 60000);
+            REQUIRE(std::abs(line.angle - std::acos(-1.0f) / 2) < 0.02f);
+            REQUIRE(std::abs(line.rho - 50.0f) <= 1.0f);
+        }
+    }
+    REQUIRE(counts.size() == 2);
+    REQUIRE(counts[0] >= 55);
+    REQUIRE(counts[1] >= 35);
+    REQUIRE_THROWS_AS(
+        (tarsier::make_track_lines<event, tarsier::hough_line>(
+            320,
+            240,
+            0,
+            10000,
+            20.0f,
+            3,
+            4,
+            1000,
+            [](event, const tarsier::hough_line& line) -> tarsier::hough_line { return line; },
+            [](tarsier::hough_line) {})),
+        std::logic_error);
+}
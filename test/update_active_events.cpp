@@ -0,0 +1,57 @@
+#include "../source/compute_flow.hpp"
+#include "../source/mask_isolated.hpp"
+#include "../source/update_active_events.hpp"
+#include "../third_party/Catch2/single_include/catch.hpp"
+
+struct event {
+    uint64_t t;
+    uint16_t x;
+    uint16_t y;
+    bool polarity;
+} __attribute__((packed));
+
+struct flow {
+    uint64_t t;
+    float vx;
+    float vy;
+} __attribute__((packed));
+
+TEST_CASE("Share active events between handlers", "[update_active_events]") {
+    tarsier::active_events<bool> active_events(320, 240);
+    std::size_t masked_count = 0;
+    std::size_t flows_count = 0;
+    auto mask_isolated =
+        tarsier::make_mask_isolated<event>(active_events, 10000, [&](event) -> void { ++masked_count; });
+    auto compute_flow = tarsier::make_compute_flow<event, flow>(
+        active_events,
+        2,
+        1000000,
+        10,
+        [](event event, float vx, float vy) -> flow {
+            return {event.t, vx, vy};
+        },
+        [&](flow flow) -> void {
+            ++flows_count;
+            REQUIRE(flow.t == 2010000);
+            REQUIRE(std::abs(flow.vx - 0.0000904721018f) / 0.0000904721018f < 1e-3f);
+            REQUIRE(std::abs(flow.vy - 0.000232017177f) / 0.000232017177f < 1e-3f);
+        });
+    auto update_active_events = tarsier::make_update_active_events<event>(active_events, [&](event event) -> void {
+        mask_isolated(event);
+        compute_flow(event);
+    });
+    update_active_events(event{2000000, 100 - 2, 100 - 2, true});
+    update_active_events(event{2001000, 100 - 1, 100 - 2, false});
+    update_active_events(event{2002000, 100 - 0, 100 - 2, true});
+    update_active_events(event{2003000, 100 - 2, 100 - 1, false});
+    update_active_events(event{2004000, 100 + 1, 100 - 2, true});
+    update_active_events(event{2005000, 100 - 1, 100 - 1, false});
+    update_active_events(event{2006000, 100 - 0, 100 - 1, true});
+    update_active_events(event{2007000, 100 - 2, 100 - 0, false});
+    update_active_events(event{2008000, 100 + 1, 100 - 1, true});
+    update_active_events(event{2010000, 100, 100, false});
+    REQUIRE(masked_count == 9);
+    REQUIRE(flows_count == 1);
+    REQUIRE(active_events.t(100, 100) == 2010000);
+    REQUIRE(!active_events.polarity(100, 100));
+}
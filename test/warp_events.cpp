@@ -0,0 +1,110 @@
+#include "../source/accumulate_events.hpp"
+#include "../source/warp_events.hpp"
+#include "../third_party/Catch2/single_include/catch.hpp"
+
+struct event {
+    uint64_t t;
+    uint16_t x;
+    uint16_t y;
+} __attribute__((packed));
+
+struct warped_event {
+    uint64_t t;
+    float x;
+    float y;
+} __attribute__((packed));
+
+TEST_CASE("Warp events to the start of their window", "[warp_events]") {
+    const float angular_velocity = 2.0f;
+    std::vector<event> events;
+    for (uint64_t t = 1000; t < 40000; t += 1000) {
+        events.push_back(event{
+            t,
+            static_cast<uint16_t>(std::round(160.0f - 200.0f * std::tan(angular_velocity * t * 1e-6f))),
+            120});
+    }
+    std::vector<warped_event> warped_events;
+    auto accumulate_events = tarsier::make_accumulate_events<warped_event>(320, 240);
+    auto warp_events = tarsier::make_warp_events<event, warped_event>(
+        320,
+        240,
+        200.0f,
+        200.0f,
+        160.0f,
+        120.0f,
+        20000,
+        [](event event, float x, float y) -> warped_event {
+            return {event.t, x, y};
+        },
+        [&](warped_event warped_event) {
+            warped_events.push_back(warped_event);
+            accumulate_events(warped_event);
+        });
+    warp_events.angular_velocity(0, 0.0f, angular_velocity, 0.0f);
+    for (auto event : events) {
+        warp_events(event);
+    }
+    REQUIRE(warp_events.reference_t() == 20000);
+    REQUIRE(warped_events.size() == events.size());
+    for (std::size_t index = 0; index < events.size(); ++index) {
+        const auto expected_x =
+            events[index].t < 20000 ? 160.0f : 160.0f - 200.0f * std::tan(angular_velocity * 20000 * 1e-6f);
+        REQUIRE(std::abs(warped_events[index].x - expected_x) < 0.6f);
+        REQUIRE(std::abs(warped_events[index].y - events[index].y) < 0.1f);
+    }
+    REQUIRE(accumulate_events.frame()[160 + 120 * 320] > 12.0f);
+    std::vector<warped_event> batch_warped_events;
+    auto batch_warp_events = tarsier::make_warp_events<event, warped_event>(
+        320,
+        240,
+        tarsier::pinhole_bearings(320, 240, 200.0f, 200.0f, 160.0f, 120.0f),
+        200.0f,
+        200.0f,
+        160.0f,
+        120.0f,
+        20000,
+        [](event event, float x, float y) -> warped_event {
+            return {event.t, x, y};
+        },
+        [&](warped_event warped_event) { batch_warped_events.push_back(warped_event); });
+    batch_warp_events.angular_velocity(0, 0.0f, angular_velocity, 0.0f);
+    batch_warp_events(events.data(), 10);
+    batch_warp_events(events.data() + 10, events.size() - 10);
+    REQUIRE(batch_warped_events.size() == warped_events.size());
+    for (std::size_t index = 0; index < events.size(); ++index) {
+        REQUIRE(batch_warped_events[index].x == warped_events[index].x);
+        REQUIRE(batch_warped_events[index].y == warped_events[index].y);
+    }
+    std::vector<warped_event> sampled_warped_events;
+    auto sampled_warp_events = tarsier::make_warp_events<event, warped_event>(
+        320,
+        240,
+        200.0f,
+        200.0f,
+        160.0f,
+        120.0f,
+        20000,
+        [](event event, float x, float y) -> warped_event {
+            return {event.t, x, y};
+        },
+        [&](warped_event warped_event) { sampled_warped_events.push_back(warped_event); });
+    sampled_warp_events.angular_velocity(0, 0.0f, 0.0f, 0.0f);
+    sampled_warp_events.angular_velocity(10000, 0.0f, angular_velocity, 0.0f);
+    sampled_warp_events(event{15000, 160, 120});
+    REQUIRE(std::abs(sampled_warped_events.back().x - (160.0f + 200.0f * std::tan(0.01f))) < 0.01f);
+    sampled_warp_events.angular_velocity(30000, 0.0f, 0.0f, 0.0f);
+    sampled_warp_events(event{35000, 160, 120});
+    REQUIRE(std::abs(sampled_warped_events.back().x - (160.0f + 200.0f * std::tan(0.02f))) < 0.01f);
+    REQUIRE_THROWS_AS(
+        (tarsier::make_warp_events<event, warped_event>(
+            320,
+            240,
+            200.0f,
+            200.0f,
+            160.0f,
+            120.0f,
+            0,
+            [](event, float, float) -> warped_event { return {}; },
+            [](warped_event) {})),
+        std::logic_error);
+}